@@ -0,0 +1,36 @@
+/*
+ * arch/arm64/include/asm/crc32.h
+ *
+ * Hooks used by lib/crc32.c when the CPU implements the ARMv8 CRC32
+ * instructions.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __ASM_CRC32_H
+#define __ASM_CRC32_H
+
+#include <linux/jump_label.h>
+#include <linux/types.h>
+
+extern struct static_key arm64_crc32_enabled;
+
+static inline bool crc32_arch_enabled(void)
+{
+	return static_key_false(&arm64_crc32_enabled);
+}
+
+u32 crc32_le_arch(u32 crc, unsigned char const *p, size_t len);
+u32 __crc32c_le_arch(u32 crc, unsigned char const *p, size_t len);
+
+#endif /* __ASM_CRC32_H */
@@ -40,7 +40,25 @@ enum debug_el {
 #define AARCH32_BREAK_THUMB2_LO	0xf7f0
 #define AARCH32_BREAK_THUMB2_HI	0xa000
 
+/*
+ * BRK instruction encoding and the immediates (reported in ESR_EL1.ISS)
+ * used by the kernel's software breakpoints.
+ */
+#define AARCH64_BREAK_MON	0xd4200000
+
+#define BRK64_ESR_MASK		0xFFFF
+#define BRK64_ESR_KPROBES	0x0004
+#define BRK64_ESR_UPROBES	0x0005
+#define BRK64_ESR_KPROBES_SS	0x0006
+
+#define BRK64_OPCODE_KPROBES	(AARCH64_BREAK_MON | (BRK64_ESR_KPROBES << 5))
+#define BRK64_OPCODE_UPROBES	(AARCH64_BREAK_MON | (BRK64_ESR_UPROBES << 5))
+#define BRK64_OPCODE_KPROBES_SS	(AARCH64_BREAK_MON | (BRK64_ESR_KPROBES_SS << 5))
+
 #ifndef __ASSEMBLY__
+#include <linux/list.h>
+
+struct pt_regs;
 struct task_struct;
 
 #define local_dbg_save(flags)							\
@@ -67,6 +85,32 @@ u8 debug_monitors_arch(void);
 void enable_debug_monitors(enum debug_el el);
 void disable_debug_monitors(enum debug_el el);
 
+#define DBG_HOOK_HANDLED	0
+#define DBG_HOOK_ERROR		1
+
+/*
+ * Hooks for the software step and BRK exceptions, tried in turn until one
+ * returns DBG_HOOK_HANDLED.  A break hook is only called for a BRK whose
+ * ESR matches esr_val under esr_mask.
+ */
+struct step_hook {
+	struct list_head node;
+	int (*fn)(struct pt_regs *regs, unsigned int esr);
+};
+
+void register_step_hook(struct step_hook *hook);
+void unregister_step_hook(struct step_hook *hook);
+
+struct break_hook {
+	struct list_head node;
+	u32 esr_val;
+	u32 esr_mask;
+	int (*fn)(struct pt_regs *regs, unsigned int esr);
+};
+
+void register_break_hook(struct break_hook *hook);
+void unregister_break_hook(struct break_hook *hook);
+
 void user_rewind_single_step(struct task_struct *task);
 void user_fastforward_single_step(struct task_struct *task);
 
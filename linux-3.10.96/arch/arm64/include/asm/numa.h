@@ -0,0 +1,47 @@
+/*
+ * arch/arm64/include/asm/numa.h
+ *
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __ASM_NUMA_H
+#define __ASM_NUMA_H
+
+#include <linux/cpumask.h>
+#include <linux/numa.h>
+
+#ifdef CONFIG_NUMA
+
+struct device_node;
+
+extern cpumask_t node_to_cpumask_map[MAX_NUMNODES];
+
+int __node_distance(int from, int to);
+#define node_distance(a, b)	__node_distance(a, b)
+
+int of_node_to_nid(struct device_node *np);
+#define of_node_to_nid of_node_to_nid
+
+void arm64_numa_init(void);
+void early_map_cpu_to_node(unsigned int cpu, int nid);
+int early_cpu_to_node(int cpu);
+
+#else
+
+static inline void arm64_numa_init(void) { }
+static inline void early_map_cpu_to_node(unsigned int cpu, int nid) { }
+
+#endif /* CONFIG_NUMA */
+
+#endif /* __ASM_NUMA_H */
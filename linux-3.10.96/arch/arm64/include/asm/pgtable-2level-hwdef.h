@@ -40,4 +40,12 @@
 #define SECTION_SIZE		(_AC(1, UL) << SECTION_SHIFT)
 #define SECTION_MASK		(~(SECTION_SIZE-1))
 
+/*
+ * Contiguous hint: 32 adjacent, aligned ptes (2MB) may share one TLB
+ * entry.  There is no pmd level to apply it to.
+ */
+#define CONT_PTES		32
+#define CONT_PTE_SIZE		(CONT_PTES * PAGE_SIZE)
+#define CONT_PTE_MASK		(~(CONT_PTE_SIZE - 1))
+
 #endif
@@ -137,6 +137,7 @@ extern struct page *empty_zero_page;
 #define pte_special(pte)	(pte_val(pte) & PTE_SPECIAL)
 #define pte_write(pte)		(!(pte_val(pte) & PTE_RDONLY))
 #define pte_exec(pte)		(!(pte_val(pte) & PTE_UXN))
+#define pte_cont(pte)		(pte_val(pte) & PTE_CONT)
 
 #define pte_valid_user(pte) \
 	((pte_val(pte) & (PTE_VALID | PTE_USER)) == (PTE_VALID | PTE_USER))
@@ -151,6 +152,10 @@ PTE_BIT_FUNC(mkdirty,   |= PTE_DIRTY);
 PTE_BIT_FUNC(mkold,     &= ~PTE_AF);
 PTE_BIT_FUNC(mkyoung,   |= PTE_AF);
 PTE_BIT_FUNC(mkspecial, |= PTE_SPECIAL);
+PTE_BIT_FUNC(mknoncont, &= ~PTE_CONT);
+
+/* a contiguous run at the pte level must still use page descriptors */
+PTE_BIT_FUNC(mkcont,    |= PTE_CONT | PTE_TYPE_PAGE);
 
 static inline void set_pte(pte_t *ptep, pte_t pte)
 {
@@ -175,11 +180,76 @@ static inline void set_pte_at(struct mm_struct *mm, unsigned long addr,
 /*
  * Huge pte definitions.
  */
-#define pte_huge(pte)		((pte_val(pte) & PTE_TYPE_MASK) == PTE_TYPE_HUGEPAGE)
-#define pte_mkhuge(pte)		(__pte((pte_val(pte) & ~PTE_TYPE_MASK) | PTE_TYPE_HUGEPAGE))
+#define pte_huge(pte)		(!(pte_val(pte) & PTE_TABLE_BIT))
+#define pte_mkhuge(pte)		(__pte(pte_val(pte) & ~PTE_TABLE_BIT))
+
+/*
+ * Hugetlb definitions: PMD_SIZE is the default, PUD_SIZE and the
+ * contiguous hint sizes can be added with hugepagesz=.
+ */
+#define HUGE_MAX_HSTATE		4
+#define HPAGE_SHIFT		PMD_SHIFT
+#define HPAGE_SIZE		(_AC(1, UL) << HPAGE_SHIFT)
+#define HPAGE_MASK		(~(HPAGE_SIZE - 1))
+#define HUGETLB_PAGE_ORDER	(HPAGE_SHIFT - PAGE_SHIFT)
 
 #define __HAVE_ARCH_PTE_SPECIAL
 
+static inline pte_t pmd_pte(pmd_t pmd)
+{
+	return __pte(pmd_val(pmd));
+}
+
+static inline pmd_t pte_pmd(pte_t pte)
+{
+	return __pmd(pte_val(pte));
+}
+
+/*
+ * Software PMD bits for THP, at the same positions as their pte
+ * counterparts.
+ */
+#define PMD_SECT_DIRTY		(_AT(pmdval_t, 1) << 55)
+#define PMD_SECT_SPLITTING	(_AT(pmdval_t, 1) << 57)
+
+/*
+ * THP definitions.
+ */
+#define pmd_young(pmd)		(pmd_val(pmd) & PMD_SECT_AF)
+
+#define __HAVE_ARCH_PMD_WRITE
+#define pmd_write(pmd)		(!(pmd_val(pmd) & PMD_SECT_RDONLY))
+
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+#define pmd_trans_huge(pmd)	(pmd_val(pmd) && !(pmd_val(pmd) & PMD_TABLE_BIT))
+#define pmd_trans_splitting(pmd) (pmd_val(pmd) & PMD_SECT_SPLITTING)
+#endif
+
+#define PMD_BIT_FUNC(fn,op) \
+static inline pmd_t pmd_##fn(pmd_t pmd) { pmd_val(pmd) op; return pmd; }
+
+PMD_BIT_FUNC(wrprotect,	|= PMD_SECT_RDONLY);
+PMD_BIT_FUNC(mkold,	&= ~PMD_SECT_AF);
+PMD_BIT_FUNC(mksplitting, |= PMD_SECT_SPLITTING);
+PMD_BIT_FUNC(mkwrite,	&= ~PMD_SECT_RDONLY);
+PMD_BIT_FUNC(mkdirty,	|= PMD_SECT_DIRTY);
+PMD_BIT_FUNC(mkyoung,	|= PMD_SECT_AF);
+PMD_BIT_FUNC(mknotpresent, &= ~PMD_TYPE_MASK);
+PMD_BIT_FUNC(mkcont,	|= PMD_SECT_CONT);
+
+#define pmd_mkhuge(pmd)		(__pmd(pmd_val(pmd) & ~PMD_TABLE_BIT))
+
+#define pmd_pfn(pmd)		(((pmd_val(pmd) & PMD_MASK) & PHYS_MASK) >> PAGE_SHIFT)
+#define pfn_pmd(pfn,prot)	(__pmd(((phys_addr_t)(pfn) << PAGE_SHIFT) | pgprot_val(prot)))
+#define mk_pmd(page,prot)	pfn_pmd(page_to_pfn(page),prot)
+
+#define set_pmd_at(mm, addr, pmdp, pmd)	set_pmd(pmdp, pmd)
+
+static inline int has_transparent_hugepage(void)
+{
+	return 1;
+}
+
 /*
  * Mark the prot value as uncacheable and unbufferable.
  */
@@ -199,6 +269,11 @@ extern pgprot_t phys_mem_access_prot(struct file *file, unsigned long pfn,
 
 #define pmd_bad(pmd)		(!(pmd_val(pmd) & 2))
 
+#define pmd_table(pmd)		((pmd_val(pmd) & PMD_TYPE_MASK) == \
+				 PMD_TYPE_TABLE)
+#define pmd_sect(pmd)		((pmd_val(pmd) & PMD_TYPE_MASK) == \
+				 PMD_TYPE_SECT)
+
 static inline void set_pmd(pmd_t *pmdp, pmd_t pmd)
 {
 	*pmdp = pmd;
@@ -275,6 +350,68 @@ static inline pte_t pte_modify(pte_t pte, pgprot_t newprot)
 	return pte;
 }
 
+static inline pmd_t pmd_modify(pmd_t pmd, pgprot_t newprot)
+{
+	const pmdval_t mask = PMD_SECT_USER | PMD_SECT_PXN | PMD_SECT_UXN |
+			      PMD_SECT_RDONLY | PMD_SECT_PROT_NONE |
+			      PMD_SECT_VALID;
+	pmd_val(pmd) = (pmd_val(pmd) & ~mask) | (pgprot_val(newprot) & mask);
+	return pmd;
+}
+
+#ifdef CONFIG_NUMA_BALANCING
+/*
+ * NUMA hinting entries use the PROT_NONE encoding: the valid bit is
+ * cleared so the next access faults, while PTE_PROT_NONE (the upper half
+ * of PTE_TYPE_PAGE) keeps pte_present() true.  Block entries have no such
+ * spare type bit, so PMD_SECT_PROT_NONE stands in for it; that bit is
+ * AttrIndx[0], which is clear for normal memory.
+ */
+static inline int pte_numa(pte_t pte)
+{
+	return (pte_val(pte) & (PTE_VALID | PTE_PROT_NONE)) == PTE_PROT_NONE;
+}
+#define pte_numa pte_numa
+
+static inline pte_t pte_mknuma(pte_t pte)
+{
+	pte_val(pte) &= ~PTE_VALID;
+	pte_val(pte) |= PTE_PROT_NONE;
+	return pte;
+}
+#define pte_mknuma pte_mknuma
+
+static inline pte_t pte_mknonnuma(pte_t pte)
+{
+	pte_val(pte) |= PTE_VALID | PTE_PROT_NONE | PTE_AF;
+	return pte;
+}
+#define pte_mknonnuma pte_mknonnuma
+
+static inline int pmd_numa(pmd_t pmd)
+{
+	return (pmd_val(pmd) & (PMD_SECT_VALID | PMD_SECT_PROT_NONE)) ==
+		PMD_SECT_PROT_NONE;
+}
+#define pmd_numa pmd_numa
+
+static inline pmd_t pmd_mknuma(pmd_t pmd)
+{
+	pmd_val(pmd) &= ~PMD_SECT_VALID;
+	pmd_val(pmd) |= PMD_SECT_PROT_NONE;
+	return pmd;
+}
+#define pmd_mknuma pmd_mknuma
+
+static inline pmd_t pmd_mknonnuma(pmd_t pmd)
+{
+	pmd_val(pmd) &= ~PMD_SECT_PROT_NONE;
+	pmd_val(pmd) |= PMD_SECT_VALID | PMD_SECT_AF;
+	return pmd;
+}
+#define pmd_mknonnuma pmd_mknonnuma
+#endif /* CONFIG_NUMA_BALANCING */
+
 extern pgd_t swapper_pg_dir[PTRS_PER_PGD];
 extern pgd_t idmap_pg_dir[PTRS_PER_PGD];
 
@@ -0,0 +1,47 @@
+/*
+ * arch/arm64/include/asm/probes.h
+ *
+ * State shared by kprobes and uprobes for a probed instruction.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __ASM_PROBES_H
+#define __ASM_PROBES_H
+
+#include <linux/types.h>
+
+struct pt_regs;
+
+typedef u32 probe_opcode_t;
+typedef void (probes_handler_t) (u32 opcode, long addr, struct pt_regs *);
+
+/*
+ * A probed instruction is either stepped out of line from @insn, or, if
+ * it depends on its own address, simulated by @handler.  @restore is the
+ * pc to resume at after an out of line step.
+ */
+struct arch_probe_insn {
+	probe_opcode_t *insn;
+	probes_handler_t *handler;
+	unsigned long restore;
+};
+
+#ifdef CONFIG_KPROBES
+typedef u32 kprobe_opcode_t;
+
+struct arch_specific_insn {
+	struct arch_probe_insn api;
+};
+#endif
+
+#endif
@@ -19,6 +19,30 @@
 #include <asm/spinlock_types.h>
 #include <asm/processor.h>
 
+#ifdef CONFIG_QUEUED_SPINLOCKS
+#include <linux/atomic.h>
+
+/*
+ * Queued spinlock implementation, see kernel/qspinlock.c.
+ *
+ * The locked byte is the least significant byte of the lock word and is
+ * only ever written by the lock owner, so a store-release of zero to it
+ * is enough to release the lock.
+ */
+#define queued_spin_unlock queued_spin_unlock
+static inline void queued_spin_unlock(struct qspinlock *lock)
+{
+#ifdef __AARCH64EB__
+	smp_store_release(&((u8 *)lock)[3], 0);
+#else
+	smp_store_release(&((u8 *)lock)[0], 0);
+#endif
+}
+
+#include <asm-generic/qspinlock.h>
+
+#else /* !CONFIG_QUEUED_SPINLOCKS */
+
 /*
  * Spinlock implementation.
  *
@@ -33,6 +57,11 @@
  */
 
 #define arch_spin_is_locked(x)		((x)->lock != 0)
+
+static inline int arch_spin_value_unlocked(arch_spinlock_t lock)
+{
+	return lock.lock == 0;
+}
 #define arch_spin_unlock_wait(lock) \
 	do { while (arch_spin_is_locked(lock)) cpu_relax(); } while (0)
 
@@ -78,6 +107,8 @@ static inline void arch_spin_unlock(arch_spinlock_t *lock)
 	: "=Q" (lock->lock) : "r" (0) : "memory");
 }
 
+#endif /* CONFIG_QUEUED_SPINLOCKS */
+
 /*
  * Write lock implementation.
  *
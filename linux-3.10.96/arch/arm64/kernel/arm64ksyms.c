@@ -28,6 +28,7 @@
 #include <linux/io.h>
 
 #include <asm/checksum.h>
+#include <asm/ftrace.h>
 
 	/* user mem (segment) */
 EXPORT_SYMBOL(__strnlen_user);
@@ -58,3 +59,7 @@ EXPORT_SYMBOL(clear_bit);
 EXPORT_SYMBOL(test_and_clear_bit);
 EXPORT_SYMBOL(change_bit);
 EXPORT_SYMBOL(test_and_change_bit);
+
+#ifdef CONFIG_FUNCTION_TRACER
+EXPORT_SYMBOL(_mcount);
+#endif
@@ -22,7 +22,9 @@
 #include <linux/debugfs.h>
 #include <linux/hardirq.h>
 #include <linux/init.h>
+#include <linux/kprobes.h>
 #include <linux/ptrace.h>
+#include <linux/rculist.h>
 #include <linux/stat.h>
 
 #include <asm/debug-monitors.h>
@@ -187,8 +189,80 @@ static void clear_regs_spsr_ss(struct pt_regs *regs)
 	regs->pstate = spsr;
 }
 
-static int single_step_handler(unsigned long addr, unsigned int esr,
-			       struct pt_regs *regs)
+/*
+ * Step and break hooks.  The lists are walked from the exception path
+ * under RCU and only modified under debug_hook_lock.
+ */
+static LIST_HEAD(step_hook);
+static LIST_HEAD(break_hook);
+static DEFINE_SPINLOCK(debug_hook_lock);
+
+void register_step_hook(struct step_hook *hook)
+{
+	spin_lock(&debug_hook_lock);
+	list_add_rcu(&hook->node, &step_hook);
+	spin_unlock(&debug_hook_lock);
+}
+
+void unregister_step_hook(struct step_hook *hook)
+{
+	spin_lock(&debug_hook_lock);
+	list_del_rcu(&hook->node);
+	spin_unlock(&debug_hook_lock);
+	synchronize_rcu();
+}
+
+void register_break_hook(struct break_hook *hook)
+{
+	spin_lock(&debug_hook_lock);
+	list_add_rcu(&hook->node, &break_hook);
+	spin_unlock(&debug_hook_lock);
+}
+
+void unregister_break_hook(struct break_hook *hook)
+{
+	spin_lock(&debug_hook_lock);
+	list_del_rcu(&hook->node);
+	spin_unlock(&debug_hook_lock);
+	synchronize_rcu();
+}
+
+static int __kprobes call_step_hook(struct pt_regs *regs, unsigned int esr)
+{
+	struct step_hook *hook;
+	int retval = DBG_HOOK_ERROR;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(hook, &step_hook, node) {
+		retval = hook->fn(regs, esr);
+		if (retval == DBG_HOOK_HANDLED)
+			break;
+	}
+	rcu_read_unlock();
+
+	return retval;
+}
+
+static int __kprobes call_break_hook(struct pt_regs *regs, unsigned int esr)
+{
+	struct break_hook *hook;
+	int retval = DBG_HOOK_ERROR;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(hook, &break_hook, node) {
+		if ((esr & hook->esr_mask) != hook->esr_val)
+			continue;
+		retval = hook->fn(regs, esr);
+		if (retval == DBG_HOOK_HANDLED)
+			break;
+	}
+	rcu_read_unlock();
+
+	return retval;
+}
+
+static int __kprobes single_step_handler(unsigned long addr, unsigned int esr,
+					 struct pt_regs *regs)
 {
 	siginfo_t info;
 
@@ -199,6 +273,9 @@ static int single_step_handler(unsigned long addr, unsigned int esr,
 	if (!reinstall_suspended_bps(regs))
 		return 0;
 
+	if (call_step_hook(regs, esr) == DBG_HOOK_HANDLED)
+		return 0;
+
 	if (user_mode(regs)) {
 		info.si_signo = SIGTRAP;
 		info.si_errno = 0;
@@ -226,13 +303,41 @@ static int single_step_handler(unsigned long addr, unsigned int esr,
 	return 0;
 }
 
-static int __init single_step_init(void)
+/*
+ * BRK in the kernel is only ever one of our software breakpoints; in user
+ * space it is either a uprobe or a debugger's breakpoint.
+ */
+static int __kprobes brk_handler(unsigned long addr, unsigned int esr,
+				 struct pt_regs *regs)
+{
+	siginfo_t info;
+
+	if (call_break_hook(regs, esr) == DBG_HOOK_HANDLED)
+		return 0;
+
+	if (!user_mode(regs)) {
+		pr_warning("Unexpected kernel BRK exception at EL1\n");
+		return -EFAULT;
+	}
+
+	info.si_signo = SIGTRAP;
+	info.si_errno = 0;
+	info.si_code  = TRAP_BRKPT;
+	info.si_addr  = (void __user *)instruction_pointer(regs);
+	force_sig_info(SIGTRAP, &info, current);
+
+	return 0;
+}
+
+static int __init debug_traps_init(void)
 {
 	hook_debug_fault_code(DBG_ESR_EVT_HWSS, single_step_handler, SIGTRAP,
 			      TRAP_HWBKPT, "single-step handler");
+	hook_debug_fault_code(DBG_ESR_EVT_BRK, brk_handler, SIGTRAP,
+			      TRAP_BRKPT, "ptrace BRK handler");
 	return 0;
 }
-arch_initcall(single_step_init);
+arch_initcall(debug_traps_init);
 
 /* Re-enable single step for syscall restarting. */
 void user_rewind_single_step(struct task_struct *task)
@@ -0,0 +1,214 @@
+/*
+ * arch/arm64/kernel/insn.c
+ *
+ * A64 instruction encoding and kernel text patching.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <linux/bitops.h>
+#include <linux/compiler.h>
+#include <linux/kernel.h>
+#include <linux/smp.h>
+#include <linux/stop_machine.h>
+#include <linux/uaccess.h>
+
+#include <asm/cacheflush.h>
+#include <asm/insn.h>
+#include <asm/sizes.h>
+
+/*
+ * Only the NOP hint; the other hints (YIELD, WFE, ...) are not safe to
+ * patch over.
+ */
+bool aarch64_insn_is_nop(u32 insn)
+{
+	return insn == AARCH64_INSN_NOP;
+}
+
+/*
+ * Anything that writes the PC: immediate and register branches, the
+ * conditional forms, and ERET.
+ */
+bool aarch64_insn_is_branch(u32 insn)
+{
+	return aarch64_insn_is_b(insn) ||
+	       aarch64_insn_is_bl(insn) ||
+	       aarch64_insn_is_b_cond(insn) ||
+	       aarch64_insn_is_cbz(insn) ||
+	       aarch64_insn_is_cbnz(insn) ||
+	       aarch64_insn_is_tbz(insn) ||
+	       aarch64_insn_is_tbnz(insn) ||
+	       aarch64_insn_is_br(insn) ||
+	       aarch64_insn_is_blr(insn) ||
+	       aarch64_insn_is_ret(insn) ||
+	       aarch64_insn_is_eret(insn);
+}
+
+/*
+ * Instructions the architecture allows to be modified while another
+ * cpu may be executing them, see "Concurrent modification and execution
+ * of instructions" in the ARMv8 ARM.
+ */
+static bool __aarch64_insn_hotpatch_safe(u32 insn)
+{
+	return aarch64_insn_is_b(insn) ||
+	       aarch64_insn_is_bl(insn) ||
+	       aarch64_insn_is_svc(insn) ||
+	       aarch64_insn_is_hvc(insn) ||
+	       aarch64_insn_is_smc(insn) ||
+	       aarch64_insn_is_brk(insn) ||
+	       aarch64_insn_is_nop(insn);
+}
+
+bool aarch64_insn_hotpatch_safe(u32 old_insn, u32 new_insn)
+{
+	return __aarch64_insn_hotpatch_safe(old_insn) &&
+	       __aarch64_insn_hotpatch_safe(new_insn);
+}
+
+/*
+ * The text may belong to a module or __init section that is going away,
+ * so go through probe_kernel_*() rather than dereferencing it.
+ */
+int aarch64_insn_read(void *addr, u32 *insnp)
+{
+	int ret;
+	u32 val;
+
+	ret = probe_kernel_read(&val, addr, AARCH64_INSN_SIZE);
+	if (!ret)
+		*insnp = le32_to_cpu(val);
+
+	return ret;
+}
+
+int aarch64_insn_write(void *addr, u32 insn)
+{
+	insn = cpu_to_le32(insn);
+	return probe_kernel_write(addr, &insn, AARCH64_INSN_SIZE);
+}
+
+u32 aarch64_insn_gen_nop(void)
+{
+	return AARCH64_INSN_NOP;
+}
+
+u32 aarch64_insn_gen_branch_imm(unsigned long pc, unsigned long addr,
+				enum aarch64_insn_branch_type type)
+{
+	long offset = addr - pc;
+	u32 insn;
+
+	/* B and BL reach +/-128MB of word aligned targets */
+	BUG_ON(pc & 0x3 || addr & 0x3);
+	BUG_ON(offset < -SZ_128M || offset >= SZ_128M);
+
+	if (type == AARCH64_INSN_BRANCH_LINK)
+		insn = aarch64_insn_get_bl_value();
+	else
+		insn = aarch64_insn_get_b_value();
+
+	return insn | ((offset >> 2) & 0x03ffffff);
+}
+
+int aarch64_insn_patch_text_nosync(void *addr, u32 insn)
+{
+	u32 *tp = addr;
+	int ret;
+
+	/* A64 instructions must be word aligned */
+	if ((uintptr_t)tp & 0x3)
+		return -EINVAL;
+
+	ret = aarch64_insn_write(tp, insn);
+	if (ret == 0)
+		flush_icache_range((uintptr_t)tp,
+				   (uintptr_t)tp + AARCH64_INSN_SIZE);
+
+	return ret;
+}
+
+struct aarch64_insn_patch {
+	void		**text_addrs;
+	u32		*new_insns;
+	int		insn_cnt;
+	atomic_t	cpu_count;
+};
+
+static int aarch64_insn_patch_text_cb(void *arg)
+{
+	int i, ret = 0;
+	struct aarch64_insn_patch *pp = arg;
+
+	/* the first cpu in does the patching, the others wait for it */
+	if (atomic_inc_return(&pp->cpu_count) == 1) {
+		for (i = 0; ret == 0 && i < pp->insn_cnt; i++)
+			ret = aarch64_insn_patch_text_nosync(pp->text_addrs[i],
+							     pp->new_insns[i]);
+		/* one more increment releases the waiters */
+		atomic_inc(&pp->cpu_count);
+	} else {
+		while (atomic_read(&pp->cpu_count) <= num_online_cpus())
+			cpu_relax();
+		isb();
+	}
+
+	return ret;
+}
+
+int aarch64_insn_patch_text_sync(void *addrs[], u32 insns[], int cnt)
+{
+	struct aarch64_insn_patch patch = {
+		.text_addrs = addrs,
+		.new_insns = insns,
+		.insn_cnt = cnt,
+		.cpu_count = ATOMIC_INIT(0),
+	};
+
+	if (cnt <= 0)
+		return -EINVAL;
+
+	return stop_machine(aarch64_insn_patch_text_cb, &patch,
+			    cpu_online_mask);
+}
+
+/*
+ * Patch @cnt instructions.  A single instruction that is safe to modify
+ * concurrently is written in place; anything else is done with all cpus
+ * parked in stop_machine().
+ */
+int aarch64_insn_patch_text(void *addrs[], u32 insns[], int cnt)
+{
+	int ret;
+	u32 insn;
+
+	if (cnt == 1) {
+		ret = aarch64_insn_read(addrs[0], &insn);
+		if (ret)
+			return ret;
+
+		if (aarch64_insn_hotpatch_safe(insn, insns[0])) {
+			ret = aarch64_insn_patch_text_nosync(addrs[0], insns[0]);
+			/*
+			 * Other cpus are only guaranteed to see the new
+			 * instruction after a context synchronization event,
+			 * which the IPI provides.
+			 */
+			kick_all_cpus_sync();
+			return ret;
+		}
+	}
+
+	return aarch64_insn_patch_text_sync(addrs, insns, cnt);
+}
@@ -0,0 +1,276 @@
+/*
+ * arch/arm64/kernel/probes/simulate-insn.c
+ *
+ * Simulation of the instructions that cannot be stepped out of line
+ * because they read or write the PC.  @addr is the address the
+ * instruction was fetched from; the handlers leave regs->pc at the
+ * instruction that should run next.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <linux/bitops.h>
+#include <linux/kernel.h>
+#include <linux/kprobes.h>
+#include <linux/sched.h>
+#include <linux/string.h>
+#include <linux/uaccess.h>
+
+#include <asm/ptrace.h>
+
+#include "simulate-insn.h"
+
+#define bbl_displacement(insn)		\
+	sign_extend32(((insn) & 0x3ffffff) << 2, 27)
+
+#define bcond_displacement(insn)	\
+	sign_extend32(((insn >> 5) & 0x7ffff) << 2, 20)
+
+#define cbz_displacement(insn)	\
+	sign_extend32(((insn >> 5) & 0x7ffff) << 2, 20)
+
+#define tbz_displacement(insn)	\
+	sign_extend32(((insn >> 5) & 0x3fff) << 2, 15)
+
+#define ldr_displacement(insn)	\
+	sign_extend32(((insn >> 5) & 0x7ffff) << 2, 20)
+
+/* register 31 reads as zero and ignores writes in all of these */
+static inline void set_x_reg(struct pt_regs *regs, int reg, u64 val)
+{
+	if (reg < 31)
+		regs->regs[reg] = val;
+}
+
+static inline void set_w_reg(struct pt_regs *regs, int reg, u64 val)
+{
+	if (reg < 31)
+		regs->regs[reg] = lower_32_bits(val);
+}
+
+static inline u64 get_x_reg(struct pt_regs *regs, int reg)
+{
+	return reg < 31 ? regs->regs[reg] : 0;
+}
+
+static inline u32 get_w_reg(struct pt_regs *regs, int reg)
+{
+	return lower_32_bits(get_x_reg(regs, reg));
+}
+
+static bool __kprobes check_cbz(u32 opcode, struct pt_regs *regs)
+{
+	int xn = opcode & 0x1f;
+
+	return (opcode & (1 << 31)) ?
+	    (get_x_reg(regs, xn) == 0) : (get_w_reg(regs, xn) == 0);
+}
+
+static bool __kprobes check_cbnz(u32 opcode, struct pt_regs *regs)
+{
+	return !check_cbz(opcode, regs);
+}
+
+static bool __kprobes check_tbz(u32 opcode, struct pt_regs *regs)
+{
+	int xn = opcode & 0x1f;
+	int bit_pos = ((opcode & (1 << 31)) >> 26) | ((opcode >> 19) & 0x1f);
+
+	return ((get_x_reg(regs, xn) >> bit_pos) & 0x1) == 0;
+}
+
+static bool __kprobes check_tbnz(u32 opcode, struct pt_regs *regs)
+{
+	return !check_tbz(opcode, regs);
+}
+
+/* Evaluate an A64 condition code against the saved NZCV flags. */
+static bool __kprobes condition_holds(unsigned int cond, u64 pstate)
+{
+	bool n = pstate & PSR_N_BIT;
+	bool z = pstate & PSR_Z_BIT;
+	bool c = pstate & PSR_C_BIT;
+	bool v = pstate & PSR_V_BIT;
+	bool ret;
+
+	switch (cond >> 1) {
+	case 0:		/* EQ / NE */
+		ret = z;
+		break;
+	case 1:		/* CS / CC */
+		ret = c;
+		break;
+	case 2:		/* MI / PL */
+		ret = n;
+		break;
+	case 3:		/* VS / VC */
+		ret = v;
+		break;
+	case 4:		/* HI / LS */
+		ret = c && !z;
+		break;
+	case 5:		/* GE / LT */
+		ret = n == v;
+		break;
+	case 6:		/* GT / LE */
+		ret = !z && n == v;
+		break;
+	default:	/* AL / NV */
+		return true;
+	}
+
+	return (cond & 1) ? !ret : ret;
+}
+
+/*
+ * Fetch a literal for one of the load-literal forms.  A uprobed task
+ * that points one at an unmapped address gets the SIGSEGV the real
+ * instruction would have raised.
+ */
+static bool __kprobes load_literal(struct pt_regs *regs, long addr,
+				   void *val, size_t size)
+{
+	if (!user_mode(regs)) {
+		memcpy(val, (void *)addr, size);
+		return true;
+	}
+
+	if (!copy_from_user(val, (void __user *)addr, size))
+		return true;
+
+	force_sig(SIGSEGV, current);
+	return false;
+}
+
+/*
+ * instruction simulation functions
+ */
+void __kprobes
+simulate_adr_adrp(u32 opcode, long addr, struct pt_regs *regs)
+{
+	long imm, xn, val;
+
+	xn = opcode & 0x1f;
+	imm = ((opcode >> 3) & 0x1ffffc) | ((opcode >> 29) & 0x3);
+	imm = sign_extend32(imm, 20);
+	if (opcode & 0x80000000)
+		val = (imm << 12) + (addr & 0xfffffffffffff000);
+	else
+		val = imm + addr;
+
+	set_x_reg(regs, xn, val);
+
+	instruction_pointer_set(regs, instruction_pointer(regs) + 4);
+}
+
+void __kprobes
+simulate_b_bl(u32 opcode, long addr, struct pt_regs *regs)
+{
+	int disp = bbl_displacement(opcode);
+
+	/* Link register is x30 */
+	if (opcode & (1 << 31))
+		set_x_reg(regs, 30, addr + 4);
+
+	instruction_pointer_set(regs, addr + disp);
+}
+
+void __kprobes
+simulate_b_cond(u32 opcode, long addr, struct pt_regs *regs)
+{
+	int disp = 4;
+
+	if (condition_holds(opcode & 0xf, regs->pstate))
+		disp = bcond_displacement(opcode);
+
+	instruction_pointer_set(regs, addr + disp);
+}
+
+void __kprobes
+simulate_br_blr_ret(u32 opcode, long addr, struct pt_regs *regs)
+{
+	int xn = (opcode >> 5) & 0x1f;
+
+	/* update pc first in case we're doing a "blr lr" */
+	instruction_pointer_set(regs, get_x_reg(regs, xn));
+
+	/* Link register is x30 */
+	if (((opcode >> 21) & 0x3) == 1)
+		set_x_reg(regs, 30, addr + 4);
+}
+
+void __kprobes
+simulate_cbz_cbnz(u32 opcode, long addr, struct pt_regs *regs)
+{
+	int disp = 4;
+
+	if (opcode & (1 << 24)) {
+		if (check_cbnz(opcode, regs))
+			disp = cbz_displacement(opcode);
+	} else {
+		if (check_cbz(opcode, regs))
+			disp = cbz_displacement(opcode);
+	}
+	instruction_pointer_set(regs, addr + disp);
+}
+
+void __kprobes
+simulate_tbz_tbnz(u32 opcode, long addr, struct pt_regs *regs)
+{
+	int disp = 4;
+
+	if (opcode & (1 << 24)) {
+		if (check_tbnz(opcode, regs))
+			disp = tbz_displacement(opcode);
+	} else {
+		if (check_tbz(opcode, regs))
+			disp = tbz_displacement(opcode);
+	}
+	instruction_pointer_set(regs, addr + disp);
+}
+
+void __kprobes
+simulate_ldr_literal(u32 opcode, long addr, struct pt_regs *regs)
+{
+	int xn = opcode & 0x1f;
+	int disp = ldr_displacement(opcode);
+	u64 xval;
+	u32 wval;
+
+	if (opcode & (1 << 30)) {	/* x0-x30 */
+		if (!load_literal(regs, addr + disp, &xval, sizeof(xval)))
+			return;
+		set_x_reg(regs, xn, xval);
+	} else {			/* w0-w30 */
+		if (!load_literal(regs, addr + disp, &wval, sizeof(wval)))
+			return;
+		set_w_reg(regs, xn, wval);
+	}
+
+	instruction_pointer_set(regs, instruction_pointer(regs) + 4);
+}
+
+void __kprobes
+simulate_ldrsw_literal(u32 opcode, long addr, struct pt_regs *regs)
+{
+	int xn = opcode & 0x1f;
+	int disp = ldr_displacement(opcode);
+	s32 val;
+
+	if (!load_literal(regs, addr + disp, &val, sizeof(val)))
+		return;
+
+	set_x_reg(regs, xn, val);
+
+	instruction_pointer_set(regs, instruction_pointer(regs) + 4);
+}
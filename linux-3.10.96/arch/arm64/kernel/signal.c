@@ -24,6 +24,7 @@
 #include <linux/uaccess.h>
 #include <linux/tracehook.h>
 #include <linux/ratelimit.h>
+#include <linux/uprobes.h>
 
 #include <asm/compat.h>
 #include <asm/debug-monitors.h>
@@ -409,6 +410,15 @@ static void do_signal(struct pt_regs *regs)
 asmlinkage void do_notify_resume(struct pt_regs *regs,
 				 unsigned int thread_flags)
 {
+	/*
+	 * The uprobe has to be handled first: its single-step must not
+	 * be disturbed by signal delivery.
+	 */
+	if (thread_flags & _TIF_UPROBE) {
+		clear_thread_flag(TIF_UPROBE);
+		uprobe_notify_resume(regs);
+	}
+
 	if (thread_flags & _TIF_SIGPENDING)
 		do_signal(regs);
 
@@ -0,0 +1,96 @@
+/*
+ * arch/arm64/lib/crc32-glue.c
+ *
+ * Runtime selection of the ARMv8 CRC32 code for lib/crc32.c.  Short
+ * buffers, and anything in interrupt context, use the scalar CRC32
+ * instructions; longer ones are folded with PMULL when the cpu has it.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <linux/crc32.h>
+#include <linux/hardirq.h>
+#include <linux/init.h>
+#include <linux/jump_label.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+
+#include <asm/hwcap.h>
+#include <asm/neon.h>
+
+/*
+ * kernel_neon_begin() saves and restores the whole FP/SIMD register
+ * file of the current task, which only pays off for long buffers.
+ */
+#define CRC32_PMULL_MIN_LEN	1024
+
+struct static_key arm64_crc32_enabled = STATIC_KEY_INIT_FALSE;
+EXPORT_SYMBOL(arm64_crc32_enabled);
+
+static bool crc32_use_pmull __read_mostly;
+
+asmlinkage u32 crc32_armv8_le(u32 crc, unsigned char const *p, size_t len);
+asmlinkage u32 crc32c_armv8_le(u32 crc, unsigned char const *p, size_t len);
+asmlinkage u32 crc32_pmull_le(const u8 buf[], u64 len, u32 init_crc);
+asmlinkage u32 crc32c_pmull_le(const u8 buf[], u64 len, u32 init_crc);
+
+static inline u32 crc32_arm64_le(u32 crc, unsigned char const *p, size_t len,
+	u32 (*crc_scalar)(u32, unsigned char const *, size_t),
+	u32 (*crc_pmull)(const u8 *, u64, u32))
+{
+	size_t head, body;
+
+	if (!crc32_use_pmull || len < CRC32_PMULL_MIN_LEN || in_interrupt())
+		return crc_scalar(crc, p, len);
+
+	/* bring the buffer to 16 byte alignment with the scalar code */
+	head = -(unsigned long)p & 15;
+	if (head) {
+		crc = crc_scalar(crc, p, head);
+		p += head;
+		len -= head;
+	}
+
+	body = round_down(len, 16);
+	kernel_neon_begin();
+	crc = crc_pmull(p, body, crc);
+	kernel_neon_end();
+
+	return crc_scalar(crc, p + body, len - body);
+}
+
+u32 crc32_le_arch(u32 crc, unsigned char const *p, size_t len)
+{
+	return crc32_arm64_le(crc, p, len, crc32_armv8_le, crc32_pmull_le);
+}
+EXPORT_SYMBOL(crc32_le_arch);
+
+u32 __crc32c_le_arch(u32 crc, unsigned char const *p, size_t len)
+{
+	return crc32_arm64_le(crc, p, len, crc32c_armv8_le, crc32c_pmull_le);
+}
+EXPORT_SYMBOL(__crc32c_le_arch);
+
+static int __init crc32_arm64_init(void)
+{
+	if (!(elf_hwcap & HWCAP_CRC32))
+		return 0;
+
+	crc32_use_pmull = elf_hwcap & HWCAP_PMULL;
+	static_key_slow_inc(&arm64_crc32_enabled);
+
+	pr_info("crc32: using ARMv8 CRC32 instructions%s\n",
+		crc32_use_pmull ? " and PMULL folding" : "");
+	return 0;
+}
+core_initcall(crc32_arm64_init);
@@ -0,0 +1,316 @@
+/*
+ * arch/arm64/mm/hugetlbpage.c
+ *
+ * Based on arch/x86/mm/hugetlbpage.c.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <linux/init.h>
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/hugetlb.h>
+#include <linux/pagemap.h>
+#include <linux/err.h>
+#include <linux/sysctl.h>
+#include <asm/mman.h>
+#include <asm/tlb.h>
+#include <asm/tlbflush.h>
+#include <asm/pgalloc.h>
+
+/*
+ * Huge page sizes, 4K granule:
+ *	64K	CONT_PTES ptes with the contiguous hint
+ *	2M	a pmd section (the default)
+ *	32M	CONT_PMDS pmd sections with the contiguous hint
+ *	1G	a pud section
+ *
+ * 64K granule: 2M (contiguous ptes) and 512M (a pmd section).
+ *
+ * The generic hugetlb code only ever sees the first entry of a
+ * contiguous run; the helpers below apply every change to the whole run.
+ */
+
+int pmd_huge(pmd_t pmd)
+{
+	return !(pmd_val(pmd) & PMD_TABLE_BIT);
+}
+
+int pud_huge(pud_t pud)
+{
+#ifndef __PAGETABLE_PMD_FOLDED
+	return !(pud_val(pud) & PUD_TABLE_BIT);
+#else
+	return 0;
+#endif
+}
+
+int huge_pmd_unshare(struct mm_struct *mm, unsigned long *addr, pte_t *ptep)
+{
+	return 0;
+}
+
+struct page *follow_huge_addr(struct mm_struct *mm, unsigned long address,
+			      int write)
+{
+	return ERR_PTR(-EINVAL);
+}
+
+struct page *follow_huge_pmd(struct mm_struct *mm, unsigned long address,
+			     pmd_t *pmd, int write)
+{
+	struct page *page;
+
+	page = pte_page(*(pte_t *)pmd);
+	if (page)
+		page += ((address & ~PMD_MASK) >> PAGE_SHIFT);
+	return page;
+}
+
+struct page *follow_huge_pud(struct mm_struct *mm, unsigned long address,
+			     pud_t *pud, int write)
+{
+	struct page *page;
+
+	page = pte_page(*(pte_t *)pud);
+	if (page)
+		page += ((address & ~PUD_MASK) >> PAGE_SHIFT);
+	return page;
+}
+
+/*
+ * Number of entries making up the huge mapping at @ptep, and the size
+ * each of them maps.
+ */
+static int find_num_contig(struct mm_struct *mm, unsigned long addr,
+			   pte_t *ptep, pte_t pte, size_t *pgsize)
+{
+	pgd_t *pgd = pgd_offset(mm, addr);
+	pud_t *pud;
+	pmd_t *pmd;
+
+	*pgsize = PAGE_SIZE;
+	if (!pte_cont(pte))
+		return 1;
+
+	pud = pud_offset(pgd, addr);
+	pmd = pmd_offset(pud, addr);
+#ifdef CONT_PMDS
+	if ((pte_t *)pmd == ptep) {
+		*pgsize = PMD_SIZE;
+		return CONT_PMDS;
+	}
+#endif
+	return CONT_PTES;
+}
+
+pte_t *huge_pte_alloc(struct mm_struct *mm, unsigned long addr,
+		      unsigned long sz)
+{
+	pgd_t *pgd;
+	pud_t *pud;
+	pmd_t *pmd;
+
+	pgd = pgd_offset(mm, addr);
+	pud = pud_alloc(mm, pgd, addr);
+	if (!pud)
+		return NULL;
+
+#ifndef __PAGETABLE_PMD_FOLDED
+	if (sz == PUD_SIZE)
+		return (pte_t *)pud;
+#endif
+
+	pmd = pmd_alloc(mm, pud, addr);
+	if (!pmd)
+		return NULL;
+
+	if (sz == CONT_PTE_SIZE) {
+		WARN_ON(addr & (sz - 1));
+		return pte_alloc_map(mm, NULL, pmd, addr);
+	}
+
+	/* PMD_SIZE, or CONT_PMD_SIZE starting at the first pmd of the run */
+	return (pte_t *)pmd;
+}
+
+pte_t *huge_pte_offset(struct mm_struct *mm, unsigned long addr)
+{
+	pgd_t *pgd;
+	pud_t *pud;
+	pmd_t *pmd;
+	pte_t *pte;
+
+	pgd = pgd_offset(mm, addr);
+	if (!pgd_present(*pgd))
+		return NULL;
+
+	pud = pud_offset(pgd, addr);
+	if (!pud_present(*pud))
+		return NULL;
+	if (pud_huge(*pud))
+		return (pte_t *)pud;
+
+	pmd = pmd_offset(pud, addr);
+	if (!pmd_present(*pmd))
+		return NULL;
+#ifdef CONT_PMDS
+	if (pte_cont(pmd_pte(*pmd)))
+		return (pte_t *)pmd_offset(pud, addr & CONT_PMD_MASK);
+#endif
+	if (pmd_huge(*pmd))
+		return (pte_t *)pmd;
+
+	pte = pte_offset_kernel(pmd, addr);
+	if (pte_present(*pte) && pte_cont(*pte))
+		return pte_offset_kernel(pmd, addr & CONT_PTE_MASK);
+
+	return NULL;
+}
+
+pte_t arch_make_huge_pte(pte_t entry, struct vm_area_struct *vma,
+			 struct page *page, int writable)
+{
+	size_t pagesize = huge_page_size(hstate_vma(vma));
+
+	if (pagesize == CONT_PTE_SIZE)
+		entry = pte_mkcont(entry);
+#ifdef CONT_PMDS
+	else if (pagesize == CONT_PMD_SIZE)
+		entry = pmd_pte(pmd_mkcont(pte_pmd(entry)));
+#endif
+
+	return entry;
+}
+
+void set_huge_pte_at(struct mm_struct *mm, unsigned long addr,
+		     pte_t *ptep, pte_t pte)
+{
+	size_t pgsize;
+	unsigned long pfn;
+	pgprot_t hugeprot;
+	int i, ncontig;
+
+	if (!pte_cont(pte)) {
+		set_pte_at(mm, addr, ptep, pte);
+		return;
+	}
+
+	ncontig = find_num_contig(mm, addr, ptep, pte, &pgsize);
+	pfn = pte_pfn(pte);
+	hugeprot = __pgprot(pte_val(pfn_pte(pfn, __pgprot(0))) ^ pte_val(pte));
+	for (i = 0; i < ncontig; i++, ptep++, addr += pgsize,
+	     pfn += pgsize >> PAGE_SHIFT)
+		set_pte_at(mm, addr, ptep, pfn_pte(pfn, hugeprot));
+}
+
+pte_t huge_ptep_get_and_clear(struct mm_struct *mm, unsigned long addr,
+			      pte_t *ptep)
+{
+	pte_t pte = *ptep;
+	size_t pgsize;
+	int i, ncontig;
+
+	if (!pte_cont(pte))
+		return ptep_get_and_clear(mm, addr, ptep);
+
+	/* the run is cleared as a whole, so any entry may carry dirty */
+	ncontig = find_num_contig(mm, addr, ptep, pte, &pgsize);
+	for (i = 0; i < ncontig; i++, ptep++, addr += pgsize) {
+		pte_t orig = ptep_get_and_clear(mm, addr, ptep);
+
+		if (pte_dirty(orig))
+			pte = pte_mkdirty(pte);
+	}
+	return pte;
+}
+
+int huge_ptep_set_access_flags(struct vm_area_struct *vma,
+			       unsigned long addr, pte_t *ptep,
+			       pte_t pte, int dirty)
+{
+	struct mm_struct *mm = vma->vm_mm;
+	unsigned long pfn;
+	pgprot_t hugeprot;
+	size_t pgsize;
+	int i, ncontig;
+
+	if (!pte_cont(pte))
+		return ptep_set_access_flags(vma, addr, ptep, pte, dirty);
+
+	if (pte_same(*ptep, pte))
+		return 0;
+
+	/*
+	 * Break before make: the TLB must never see a run whose entries
+	 * disagree, so clear and flush all of it before rewriting it.
+	 */
+	ncontig = find_num_contig(mm, addr, ptep, pte, &pgsize);
+	for (i = 0; i < ncontig; i++)
+		pte_clear(mm, addr + i * pgsize, ptep + i);
+	flush_tlb_range(vma, addr, addr + ncontig * pgsize);
+
+	pfn = pte_pfn(pte);
+	hugeprot = __pgprot(pte_val(pfn_pte(pfn, __pgprot(0))) ^ pte_val(pte));
+	for (i = 0; i < ncontig; i++, ptep++, addr += pgsize,
+	     pfn += pgsize >> PAGE_SHIFT)
+		set_pte_at(mm, addr, ptep, pfn_pte(pfn, hugeprot));
+
+	return 1;
+}
+
+void huge_ptep_set_wrprotect(struct mm_struct *mm,
+			     unsigned long addr, pte_t *ptep)
+{
+	size_t pgsize;
+	int i, ncontig;
+
+	ncontig = find_num_contig(mm, addr, ptep, *ptep, &pgsize);
+	for (i = 0; i < ncontig; i++, ptep++, addr += pgsize)
+		ptep_set_wrprotect(mm, addr, ptep);
+}
+
+void huge_ptep_clear_flush(struct vm_area_struct *vma,
+			   unsigned long addr, pte_t *ptep)
+{
+	size_t pgsize;
+	int i, ncontig;
+
+	ncontig = find_num_contig(vma->vm_mm, addr, ptep, *ptep, &pgsize);
+	for (i = 0; i < ncontig; i++, ptep++, addr += pgsize)
+		ptep_clear_flush(vma, addr, ptep);
+}
+
+static __init int setup_hugepagesz(char *opt)
+{
+	unsigned long ps = memparse(opt, &opt);
+
+	if (ps == PMD_SIZE) {
+		hugetlb_add_hstate(PMD_SHIFT - PAGE_SHIFT);
+	} else if (ps == CONT_PTE_SIZE) {
+		hugetlb_add_hstate(ilog2(CONT_PTE_SIZE) - PAGE_SHIFT);
+#ifdef CONT_PMDS
+	} else if (ps == CONT_PMD_SIZE) {
+		hugetlb_add_hstate(ilog2(CONT_PMD_SIZE) - PAGE_SHIFT);
+#endif
+#ifndef __PAGETABLE_PMD_FOLDED
+	} else if (ps == PUD_SIZE) {
+		hugetlb_add_hstate(PUD_SHIFT - PAGE_SHIFT);
+#endif
+	} else {
+		pr_err("hugepagesz: Unsupported page size %lu K\n", ps >> 10);
+		return 0;
+	}
+	return 1;
+}
+__setup("hugepagesz=", setup_hugepagesz);
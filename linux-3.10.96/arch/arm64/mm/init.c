@@ -31,6 +31,7 @@
 #include <linux/sort.h>
 #include <linux/of_fdt.h>
 
+#include <asm/numa.h>
 #include <asm/prom.h>
 #include <asm/sections.h>
 #include <asm/setup.h>
@@ -69,6 +70,22 @@ early_param("initrd", early_initrd);
 
 #define MAX_DMA32_PFN ((4UL * 1024 * 1024 * 1024) >> PAGE_SHIFT)
 
+#ifdef CONFIG_NUMA
+static void __init zone_sizes_init(unsigned long min, unsigned long max)
+{
+	unsigned long max_zone_pfns[MAX_NR_ZONES];
+
+	memset(max_zone_pfns, 0, sizeof(max_zone_pfns));
+#ifdef CONFIG_ZONE_DMA32
+	/* 4GB maximum for 32-bit only capable devices */
+	max_zone_pfns[ZONE_DMA32] = max(min, min(max, MAX_DMA32_PFN));
+#endif
+	max_zone_pfns[ZONE_NORMAL] = max;
+
+	/* node spans and holes come from the memblock node map */
+	free_area_init_nodes(max_zone_pfns);
+}
+#else
 static void __init zone_sizes_init(unsigned long min, unsigned long max)
 {
 	struct memblock_region *reg;
@@ -107,6 +124,7 @@ static void __init zone_sizes_init(unsigned long min, unsigned long max)
 
 	free_area_init_node(0, zone_size, min, zhole_size);
 }
+#endif
 
 #ifdef CONFIG_HAVE_ARCH_PFN_VALID
 int pfn_valid(unsigned long pfn)
@@ -126,7 +144,8 @@ static void arm64_memory_present(void)
 	struct memblock_region *reg;
 
 	for_each_memblock(memory, reg)
-		memory_present(0, memblock_region_memory_base_pfn(reg),
+		memory_present(memblock_get_region_node(reg),
+			       memblock_region_memory_base_pfn(reg),
 			       memblock_region_memory_end_pfn(reg));
 }
 #endif
@@ -184,6 +203,12 @@ void __init bootmem_init(void)
 	min = PFN_UP(memblock_start_of_DRAM());
 	max = PFN_DOWN(memblock_end_of_DRAM());
 
+	/*
+	 * Memory has to be assigned to nodes before sparsemem and the
+	 * zones are set up.
+	 */
+	arm64_numa_init();
+
 	/*
 	 * Sparsemem tries to allocate bootmem in memory_present(), so must be
 	 * done after the fixed reservations.
@@ -285,7 +310,9 @@ void __init mem_init(void)
 
 	arm64_swiotlb_init();
 
+#ifndef CONFIG_NEED_MULTIPLE_NODES
 	max_mapnr   = pfn_to_page(max_pfn + PHYS_PFN_OFFSET) - mem_map;
+#endif
 
 #ifndef CONFIG_SPARSEMEM_VMEMMAP
 	/* this will put all unused low memory onto the freelists */
@@ -0,0 +1,383 @@
+/*
+ * arch/arm64/mm/numa.c
+ *
+ * NUMA support, with the node topology taken from the device tree.
+ *
+ * Memory nodes and cpu nodes carry a "numa-node-id" property; an optional
+ * "numa-distance-map-v1" node provides the inter-node distances as
+ * <from to distance> triplets in its "distance-matrix" property.  Memory
+ * has to be assigned to nodes before the zones are set up, which happens
+ * long before the tree is unflattened, so that part works on the flat
+ * tree.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <linux/bootmem.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/memblock.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/nodemask.h>
+#include <linux/of.h>
+#include <linux/of_fdt.h>
+#include <linux/percpu.h>
+#include <linux/string.h>
+
+#include <asm/numa.h>
+
+struct pglist_data *node_data[MAX_NUMNODES] __read_mostly;
+EXPORT_SYMBOL(node_data);
+
+cpumask_t node_to_cpumask_map[MAX_NUMNODES] __read_mostly;
+EXPORT_SYMBOL(node_to_cpumask_map);
+
+static int cpu_to_node_map[NR_CPUS] = { [0 ... NR_CPUS - 1] = NUMA_NO_NODE };
+
+static u8 numa_distance[MAX_NUMNODES][MAX_NUMNODES] __read_mostly;
+static nodemask_t numa_nodes_parsed __initdata;
+static bool numa_off;
+
+static int __init numa_parse_early_param(char *opt)
+{
+	if (!opt)
+		return -EINVAL;
+	if (!strncmp(opt, "off", 3)) {
+		pr_info("NUMA turned off\n");
+		numa_off = true;
+	}
+	return 0;
+}
+early_param("numa", numa_parse_early_param);
+
+int __node_distance(int from, int to)
+{
+	if (from >= MAX_NUMNODES || to >= MAX_NUMNODES)
+		return from == to ? LOCAL_DISTANCE : REMOTE_DISTANCE;
+	return numa_distance[from][to];
+}
+EXPORT_SYMBOL(__node_distance);
+
+static void __init numa_reset_distance(void)
+{
+	int i, j;
+
+	for (i = 0; i < MAX_NUMNODES; i++)
+		for (j = 0; j < MAX_NUMNODES; j++)
+			numa_distance[i][j] = i == j ? LOCAL_DISTANCE :
+						       REMOTE_DISTANCE;
+}
+
+static void __init numa_set_distance(int from, int to, int distance)
+{
+	if (from >= MAX_NUMNODES || to >= MAX_NUMNODES) {
+		pr_warn("NUMA: invalid distance entry %d -> %d\n", from, to);
+		return;
+	}
+
+	if (distance > U8_MAX || distance <= 0 ||
+	    (from == to && distance != LOCAL_DISTANCE)) {
+		pr_warn("NUMA: invalid distance %d for %d -> %d\n",
+			distance, from, to);
+		return;
+	}
+
+	numa_distance[from][to] = distance;
+}
+
+/*
+ * Record the node of a cpu found in the device tree.  Cpus that name a
+ * node without memory, or no node at all, are put on node 0.
+ */
+void __init early_map_cpu_to_node(unsigned int cpu, int nid)
+{
+	if (nid < 0 || nid >= MAX_NUMNODES || !node_online(nid))
+		nid = 0;
+
+	cpu_to_node_map[cpu] = nid;
+}
+
+int early_cpu_to_node(int cpu)
+{
+	int nid = cpu_to_node_map[cpu];
+
+	return nid == NUMA_NO_NODE ? 0 : nid;
+}
+
+int of_node_to_nid(struct device_node *device)
+{
+	struct device_node *np = of_node_get(device);
+	u32 nid;
+
+	while (np) {
+		if (!of_property_read_u32(np, "numa-node-id", &nid)) {
+			of_node_put(np);
+			if (nid >= MAX_NUMNODES || !node_online(nid))
+				return NUMA_NO_NODE;
+			return nid;
+		}
+		np = of_get_next_parent(np);
+	}
+
+	return NUMA_NO_NODE;
+}
+EXPORT_SYMBOL(of_node_to_nid);
+
+#ifdef CONFIG_HAVE_SETUP_PER_CPU_AREA
+unsigned long __per_cpu_offset[NR_CPUS] __read_mostly;
+EXPORT_SYMBOL(__per_cpu_offset);
+
+static int __init pcpu_cpu_distance(unsigned int from, unsigned int to)
+{
+	return node_distance(early_cpu_to_node(from), early_cpu_to_node(to));
+}
+
+static void * __init pcpu_fc_alloc(unsigned int cpu, size_t size,
+				   size_t align)
+{
+	return __alloc_bootmem_node(NODE_DATA(early_cpu_to_node(cpu)),
+				    size, align, __pa(MAX_DMA_ADDRESS));
+}
+
+static void __init pcpu_fc_free(void *ptr, size_t size)
+{
+	free_bootmem(__pa(ptr), size);
+}
+
+/*
+ * As the generic version, but each cpu's unit is allocated on its own
+ * node and the units are grouped by distance.
+ */
+void __init setup_per_cpu_areas(void)
+{
+	unsigned long delta;
+	unsigned int cpu;
+	int rc;
+
+	rc = pcpu_embed_first_chunk(PERCPU_MODULE_RESERVE,
+				    PERCPU_DYNAMIC_RESERVE, PAGE_SIZE,
+				    pcpu_cpu_distance,
+				    pcpu_fc_alloc, pcpu_fc_free);
+	if (rc < 0)
+		panic("Failed to initialize percpu areas.");
+
+	delta = (unsigned long)pcpu_base_addr - (unsigned long)__per_cpu_start;
+	for_each_possible_cpu(cpu) {
+		int nid = early_cpu_to_node(cpu);
+
+		__per_cpu_offset[cpu] = delta + pcpu_unit_offsets[cpu];
+		set_cpu_numa_node(cpu, nid);
+		cpumask_set_cpu(cpu, &node_to_cpumask_map[nid]);
+	}
+}
+#endif
+
+static void __init numa_add_memblk(int nid, u64 base, u64 size)
+{
+	pr_info("NUMA: adding memory to node %d [mem %#010llx-%#010llx]\n",
+		nid, base, base + size - 1);
+
+	memblock_set_node(base, size, nid);
+	node_set(nid, numa_nodes_parsed);
+}
+
+static int __init early_init_dt_scan_numa_memory(unsigned long node,
+						 const char *uname,
+						 int depth, void *data)
+{
+	char *type = of_get_flat_dt_prop(node, "device_type", NULL);
+	__be32 *reg, *endp, *nidp;
+	unsigned long l;
+	int *err = data;
+	u32 nid;
+
+	if (type == NULL || strcmp(type, "memory") != 0)
+		return 0;
+
+	nidp = of_get_flat_dt_prop(node, "numa-node-id", NULL);
+	if (!nidp) {
+		pr_warn("NUMA: %s has no numa-node-id\n", uname);
+		*err = -EINVAL;
+		return 0;
+	}
+
+	nid = be32_to_cpup(nidp);
+	if (nid >= MAX_NUMNODES) {
+		pr_warn("NUMA: %s has invalid node id %u\n", uname, nid);
+		*err = -EINVAL;
+		return 0;
+	}
+
+	reg = of_get_flat_dt_prop(node, "linux,usable-memory", &l);
+	if (reg == NULL)
+		reg = of_get_flat_dt_prop(node, "reg", &l);
+	if (reg == NULL)
+		return 0;
+
+	endp = reg + (l / sizeof(__be32));
+	while ((endp - reg) >= (dt_root_addr_cells + dt_root_size_cells)) {
+		u64 base, size;
+
+		base = dt_mem_next_cell(dt_root_addr_cells, &reg);
+		size = dt_mem_next_cell(dt_root_size_cells, &reg);
+		if (size == 0)
+			continue;
+
+		numa_add_memblk(nid, base, size);
+	}
+
+	return 0;
+}
+
+static int __init early_init_dt_scan_numa_distance(unsigned long node,
+						   const char *uname,
+						   int depth, void *data)
+{
+	__be32 *matrix;
+	unsigned long l;
+	int i, entries;
+
+	if (!of_flat_dt_is_compatible(node, "numa-distance-map-v1"))
+		return 0;
+
+	matrix = of_get_flat_dt_prop(node, "distance-matrix", &l);
+	if (!matrix) {
+		pr_warn("NUMA: %s has no distance-matrix\n", uname);
+		return 1;
+	}
+
+	entries = l / (3 * sizeof(__be32));
+	for (i = 0; i < entries; i++) {
+		int from = be32_to_cpup(matrix++);
+		int to = be32_to_cpup(matrix++);
+		int distance = be32_to_cpup(matrix++);
+
+		numa_set_distance(from, to, distance);
+		/* the binding allows listing only one direction */
+		if (from != to && numa_distance[to][from] == REMOTE_DISTANCE)
+			numa_set_distance(to, from, distance);
+	}
+
+	return 1;
+}
+
+static int __init of_numa_init(void)
+{
+	int err = 0;
+
+	of_scan_flat_dt(early_init_dt_scan_numa_memory, &err);
+	if (err)
+		return err;
+
+	of_scan_flat_dt(early_init_dt_scan_numa_distance, NULL);
+	return 0;
+}
+
+static int __init dummy_numa_init(void)
+{
+	if (numa_off)
+		pr_info("NUMA disabled\n");
+	else
+		pr_info("No NUMA configuration found\n");
+
+	numa_add_memblk(0, memblock_start_of_DRAM(),
+			memblock_end_of_DRAM() - memblock_start_of_DRAM());
+	return 0;
+}
+
+static void __init setup_node_data(int nid, unsigned long start_pfn,
+				   unsigned long end_pfn)
+{
+	const size_t nd_size = roundup(sizeof(pg_data_t), SMP_CACHE_BYTES);
+	phys_addr_t nd_pa;
+	int tnid;
+
+	nd_pa = memblock_alloc_try_nid(nd_size, SMP_CACHE_BYTES, nid);
+	tnid = early_pfn_to_nid(PFN_DOWN(nd_pa));
+	if (tnid != nid)
+		pr_info("NUMA: NODE_DATA(%d) on node %d\n", nid, tnid);
+
+	node_data[nid] = __va(nd_pa);
+	memset(NODE_DATA(nid), 0, sizeof(pg_data_t));
+	NODE_DATA(nid)->node_id = nid;
+	NODE_DATA(nid)->node_start_pfn = start_pfn;
+	NODE_DATA(nid)->node_spanned_pages = end_pfn - start_pfn;
+}
+
+static int __init numa_register_nodes(void)
+{
+	struct memblock_region *mblk;
+	int nid;
+
+	/* all memory has to have ended up on some node */
+	for_each_memblock(memory, mblk) {
+		if (memblock_get_region_node(mblk) == MAX_NUMNODES) {
+			pr_warn("NUMA: memory [mem %#010llx-%#010llx] has no node\n",
+				(u64)mblk->base, (u64)(mblk->base + mblk->size - 1));
+			return -EINVAL;
+		}
+	}
+
+	for_each_node_mask(nid, numa_nodes_parsed) {
+		unsigned long start_pfn, end_pfn;
+
+		get_pfn_range_for_nid(nid, &start_pfn, &end_pfn);
+		if (start_pfn >= end_pfn)
+			continue;
+
+		setup_node_data(nid, start_pfn, end_pfn);
+		node_set_online(nid);
+	}
+
+	return 0;
+}
+
+static int __init numa_init(int (*init_func)(void))
+{
+	int ret;
+
+	nodes_clear(numa_nodes_parsed);
+	nodes_clear(node_possible_map);
+	nodes_clear(node_online_map);
+	numa_reset_distance();
+	/* forget whatever a failed attempt assigned */
+	memblock_set_node(0, (phys_addr_t)ULLONG_MAX, MAX_NUMNODES);
+
+	ret = init_func();
+	if (ret < 0)
+		return ret;
+
+	if (nodes_empty(numa_nodes_parsed))
+		return -EINVAL;
+
+	ret = numa_register_nodes();
+	if (ret < 0)
+		return ret;
+
+	node_possible_map = numa_nodes_parsed;
+	return 0;
+}
+
+/*
+ * Called from bootmem_init(): assign memory to nodes and allocate the
+ * node data, falling back to a single node if the device tree does not
+ * describe a usable topology.
+ */
+void __init arm64_numa_init(void)
+{
+	if (!numa_off && !numa_init(of_numa_init))
+		return;
+
+	numa_init(dummy_numa_init);
+}
@@ -903,8 +903,8 @@ static struct dentry *splice_dentry(struct dentry *dn, struct inode *in,
 	} else if (realdn) {
 		dout("dn %p (%d) spliced with %p (%d) "
 		     "inode %p ino %llx.%llx\n",
-		     dn, dn->d_count,
-		     realdn, realdn->d_count,
+		     dn, d_count(dn),
+		     realdn, d_count(realdn),
 		     realdn->d_inode, ceph_vinop(realdn->d_inode));
 		dput(dn);
 		dn = realdn;
@@ -1831,17 +1831,43 @@ int ceph_permission(struct inode *inode, int mask)
 }
 
 /*
- * Get all attributes.  Hopefully somedata we'll have a statlite()
- * and can limit the fields we require to be accurate.
+ * Map the STATX_* fields the caller asked for onto the caps we need to
+ * hold for them to be accurate.
+ */
+static int statx_to_caps(u32 want)
+{
+	int mask = CEPH_STAT_CAP_INODE;
+
+	if (want & (STATX_MODE | STATX_UID | STATX_GID))
+		mask |= CEPH_STAT_CAP_MODE | CEPH_STAT_CAP_UID |
+			CEPH_STAT_CAP_GID;
+	if (want & STATX_NLINK)
+		mask |= CEPH_STAT_CAP_NLINK;
+	if (want & (STATX_ATIME | STATX_MTIME | STATX_SIZE | STATX_BLOCKS))
+		mask |= CEPH_STAT_CAP_MTIME | CEPH_STAT_CAP_ATIME |
+			CEPH_STAT_CAP_SIZE;
+	/* anything that changes ctime: attributes, xattrs, data, links */
+	if (want & STATX_CTIME)
+		mask |= CEPH_CAP_AUTH_SHARED | CEPH_CAP_XATTR_SHARED |
+			CEPH_CAP_FILE_SHARED | CEPH_CAP_LINK_SHARED;
+
+	return mask;
+}
+
+/*
+ * Get attributes.  Only the caps covering the fields in the statx
+ * request mask are fetched from the MDS, and nothing is fetched at all
+ * if the caller asked for AT_STATX_DONT_SYNC.
  */
 int ceph_getattr(struct vfsmount *mnt, struct dentry *dentry,
 		 struct kstat *stat)
 {
 	struct inode *inode = dentry->d_inode;
 	struct ceph_inode_info *ci = ceph_inode(inode);
-	int err;
+	int err = 0;
 
-	err = ceph_do_getattr(inode, CEPH_STAT_CAP_INODE_ALL);
+	if ((stat->query_flags & AT_STATX_SYNC_TYPE) != AT_STATX_DONT_SYNC)
+		err = ceph_do_getattr(inode, statx_to_caps(stat->request_mask));
 	if (!err) {
 		generic_fillattr(inode, stat);
 		stat->ino = ceph_translate_ino(inode->i_sb, inode->i_ino);
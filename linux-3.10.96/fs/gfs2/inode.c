@@ -1645,6 +1645,9 @@ out:
  * readdirplus operation which causes this to be called (from filldir)
  * with the glock already held.
  *
+ * If the caller passed AT_STATX_DONT_SYNC we skip the glock altogether and
+ * report whatever is cached in the inode.
+ *
  * Returns: errno
  */
 
@@ -1657,7 +1660,8 @@ static int gfs2_getattr(struct vfsmount *mnt, struct dentry *dentry,
 	int error;
 	int unlock = 0;
 
-	if (gfs2_glock_is_locked_by_me(ip->i_gl) == NULL) {
+	if ((stat->query_flags & AT_STATX_SYNC_TYPE) != AT_STATX_DONT_SYNC &&
+	    gfs2_glock_is_locked_by_me(ip->i_gl) == NULL) {
 		error = gfs2_glock_nq_init(ip->i_gl, LM_ST_SHARED, LM_FLAG_ANY, &gh);
 		if (error)
 			return error;
@@ -16,6 +16,8 @@ struct file_system_type;
 struct linux_binprm;
 struct path;
 struct mount;
+struct kstat;
+struct statx;
 
 /*
  * block_dev.c
@@ -106,7 +108,6 @@ extern int open_check_o_direct(struct file *f);
 /*
  * inode.c
  */
-extern spinlock_t inode_sb_list_lock;
 extern void inode_add_lru(struct inode *inode);
 
 /*
@@ -128,6 +129,11 @@ extern struct dentry *__d_alloc(struct super_block *, const struct qstr *);
  */
 extern ssize_t __kernel_write(struct file *, const char *, size_t, loff_t *);
 
+/*
+ * stat.c
+ */
+extern void fill_statx(struct statx *, const struct kstat *);
+
 /*
  * splice.c
  */
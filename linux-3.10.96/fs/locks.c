@@ -126,6 +126,9 @@
 #include <linux/time.h>
 #include <linux/rcupdate.h>
 #include <linux/pid_namespace.h>
+#include <linux/hashtable.h>
+#include <linux/percpu.h>
+#include <linux/lglock.h>
 
 #include <asm/uaccess.h>
 
@@ -150,33 +153,86 @@ static int target_leasetype(struct file_lock *fl)
 int leases_enable = 1;
 int lease_break_time = 45;
 
-#define for_each_lock(inode, lockp) \
-	for (lockp = &inode->i_flock; *lockp != NULL; lockp = &(*lockp)->fl_next)
+/*
+ * The locks applied to an inode live on the flock, posix and lease lists
+ * of its file_lock_context, which is allocated the first time a lock is
+ * set on the inode and is protected by its flc_lock.
+ *
+ * The global file_lock_list is only used for displaying /proc/locks, so
+ * we keep one list per cpu, each protected by its own spinlock via the
+ * file_lock_lglock.  Changing a list also requires holding the flc_lock
+ * of the inode the lock belongs to.
+ */
+DEFINE_STATIC_LGLOCK(file_lock_lglock);
+static DEFINE_PER_CPU(struct hlist_head, file_lock_list);
 
-static LIST_HEAD(file_lock_list);
-static LIST_HEAD(blocked_list);
-static DEFINE_SPINLOCK(file_lock_lock);
+/*
+ * The blocked_hash is used to find POSIX lock loops for deadlock
+ * detection.  Waiters are hashed by lock owner so that finding the lock
+ * a given owner is waiting on does not mean walking every blocked lock
+ * in the system.
+ */
+#define BLOCKED_HASH_BITS	7
+static DEFINE_HASHTABLE(blocked_hash, BLOCKED_HASH_BITS);
 
 /*
- * Protects the two list heads above, plus the inode->i_flock list
+ * blocked_lock_lock protects the blocked_hash, the fl_block lists and
+ * the fl_next pointer of lock requests that are waiting on another lock.
+ *
+ * Adding a waiter to a blocker's fl_block list requires both the
+ * blocker's flc_lock and the blocked_lock_lock, taken in that order.
+ * Removing a waiter only needs the blocked_lock_lock.
  */
-void lock_flocks(void)
+static DEFINE_SPINLOCK(blocked_lock_lock);
+
+static struct kmem_cache *flctx_cache __read_mostly;
+static struct kmem_cache *filelock_cache __read_mostly;
+
+/*
+ * Return the inode's lock context, allocating it if this is the first
+ * lock set on the inode.  Returns NULL only if the allocation failed.
+ */
+static struct file_lock_context *locks_get_lock_context(struct inode *inode)
 {
-	spin_lock(&file_lock_lock);
+	struct file_lock_context *new;
+
+	if (likely(inode->i_flctx))
+		goto out;
+
+	new = kmem_cache_alloc(flctx_cache, GFP_KERNEL);
+	if (!new)
+		goto out;
+
+	spin_lock_init(&new->flc_lock);
+	INIT_LIST_HEAD(&new->flc_flock);
+	INIT_LIST_HEAD(&new->flc_posix);
+	INIT_LIST_HEAD(&new->flc_lease);
+
+	/*
+	 * Somebody else may have raced with us to set up the context; in
+	 * that case use theirs and free ours.
+	 */
+	if (cmpxchg(&inode->i_flctx, NULL, new))
+		kmem_cache_free(flctx_cache, new);
+out:
+	return inode->i_flctx;
 }
-EXPORT_SYMBOL_GPL(lock_flocks);
 
-void unlock_flocks(void)
+/* Called when the inode is destroyed; all locks must be gone by now. */
+void locks_free_lock_context(struct file_lock_context *ctx)
 {
-	spin_unlock(&file_lock_lock);
+	if (ctx) {
+		WARN_ON_ONCE(!list_empty(&ctx->flc_flock));
+		WARN_ON_ONCE(!list_empty(&ctx->flc_posix));
+		WARN_ON_ONCE(!list_empty(&ctx->flc_lease));
+		kmem_cache_free(flctx_cache, ctx);
+	}
 }
-EXPORT_SYMBOL_GPL(unlock_flocks);
-
-static struct kmem_cache *filelock_cache __read_mostly;
 
 static void locks_init_lock_heads(struct file_lock *fl)
 {
-	INIT_LIST_HEAD(&fl->fl_link);
+	INIT_HLIST_NODE(&fl->fl_link);
+	INIT_LIST_HEAD(&fl->fl_list);
 	INIT_LIST_HEAD(&fl->fl_block);
 	init_waitqueue_head(&fl->fl_wait);
 }
@@ -210,7 +266,8 @@ void locks_free_lock(struct file_lock *fl)
 {
 	BUG_ON(waitqueue_active(&fl->fl_wait));
 	BUG_ON(!list_empty(&fl->fl_block));
-	BUG_ON(!list_empty(&fl->fl_link));
+	BUG_ON(!list_empty(&fl->fl_list));
+	BUG_ON(!hlist_unhashed(&fl->fl_link));
 
 	locks_release_private(fl);
 	kmem_cache_free(filelock_cache, fl);
@@ -484,13 +541,57 @@ static int posix_same_owner(struct file_lock *fl1, struct file_lock *fl2)
 	return fl1->fl_owner == fl2->fl_owner;
 }
 
+/* Must be called with the inode's flc_lock held. */
+static void locks_insert_global_locks(struct file_lock *fl)
+{
+	lg_local_lock(&file_lock_lglock);
+	fl->fl_link_cpu = smp_processor_id();
+	hlist_add_head(&fl->fl_link, this_cpu_ptr(&file_lock_list));
+	lg_local_unlock(&file_lock_lglock);
+}
+
+/* Must be called with the inode's flc_lock held. */
+static void locks_delete_global_locks(struct file_lock *fl)
+{
+	/*
+	 * Insertions also need the flc_lock, so it is safe to skip the
+	 * lglock when the lock is not on any list.
+	 */
+	if (hlist_unhashed(&fl->fl_link))
+		return;
+	lg_local_lock_cpu(&file_lock_lglock, fl->fl_link_cpu);
+	hlist_del_init(&fl->fl_link);
+	lg_local_unlock_cpu(&file_lock_lglock, fl->fl_link_cpu);
+}
+
+static unsigned long posix_owner_key(struct file_lock *fl)
+{
+	if (fl->fl_lmops && fl->fl_lmops->lm_owner_key)
+		return fl->fl_lmops->lm_owner_key(fl);
+	return (unsigned long)fl->fl_owner;
+}
+
+/* Must be called with blocked_lock_lock held. */
+static void locks_insert_global_blocked(struct file_lock *waiter)
+{
+	hash_add(blocked_hash, &waiter->fl_link, posix_owner_key(waiter));
+}
+
+/* Must be called with blocked_lock_lock held. */
+static void locks_delete_global_blocked(struct file_lock *waiter)
+{
+	hash_del(&waiter->fl_link);
+}
+
 /* Remove waiter from blocker's block list.
  * When blocker ends up pointing to itself then the list is empty.
+ *
+ * Must be called with blocked_lock_lock held.
  */
 static void __locks_delete_block(struct file_lock *waiter)
 {
+	locks_delete_global_blocked(waiter);
 	list_del_init(&waiter->fl_block);
-	list_del_init(&waiter->fl_link);
 	waiter->fl_next = NULL;
 }
 
@@ -498,9 +599,9 @@ static void __locks_delete_block(struct file_lock *waiter)
  */
 void locks_delete_block(struct file_lock *waiter)
 {
-	lock_flocks();
+	spin_lock(&blocked_lock_lock);
 	__locks_delete_block(waiter);
-	unlock_flocks();
+	spin_unlock(&blocked_lock_lock);
 }
 EXPORT_SYMBOL(locks_delete_block);
 
@@ -508,23 +609,45 @@ EXPORT_SYMBOL(locks_delete_block);
  * We use a circular list so that processes can be easily woken up in
  * the order they blocked. The documentation doesn't require this but
  * it seems like the reasonable thing to do.
+ *
+ * Must be called with both the flc_lock and blocked_lock_lock held.
  */
-static void locks_insert_block(struct file_lock *blocker, 
-			       struct file_lock *waiter)
+static void __locks_insert_block(struct file_lock *blocker,
+				 struct file_lock *waiter)
 {
 	BUG_ON(!list_empty(&waiter->fl_block));
-	list_add_tail(&waiter->fl_block, &blocker->fl_block);
 	waiter->fl_next = blocker;
+	list_add_tail(&waiter->fl_block, &blocker->fl_block);
 	if (IS_POSIX(blocker))
-		list_add(&waiter->fl_link, &blocked_list);
+		locks_insert_global_blocked(waiter);
+}
+
+/* Must be called with the flc_lock held. */
+static void locks_insert_block(struct file_lock *blocker,
+			       struct file_lock *waiter)
+{
+	spin_lock(&blocked_lock_lock);
+	__locks_insert_block(blocker, waiter);
+	spin_unlock(&blocked_lock_lock);
 }
 
 /* Wake up processes blocked waiting for blocker.
  * If told to wait then schedule the processes until the block list
  * is empty, otherwise empty the block list ourselves.
+ *
+ * Must be called with the flc_lock held.
  */
 static void locks_wake_up_blocks(struct file_lock *blocker)
 {
+	/*
+	 * Waiters are only added under the flc_lock, which we hold, so an
+	 * empty list can be checked without the blocked_lock_lock.  They
+	 * can be removed without it though, so recheck once it is taken.
+	 */
+	if (list_empty(&blocker->fl_block))
+		return;
+
+	spin_lock(&blocked_lock_lock);
 	while (!list_empty(&blocker->fl_block)) {
 		struct file_lock *waiter;
 
@@ -536,20 +659,18 @@ static void locks_wake_up_blocks(struct file_lock *blocker)
 		else
 			wake_up(&waiter->fl_wait);
 	}
+	spin_unlock(&blocked_lock_lock);
 }
 
-/* Insert file lock fl into an inode's lock list at the position indicated
- * by pos. At the same time add the lock to the global file lock list.
+/* Insert file lock fl into an inode's lock list before the entry @before
+ * (or at the tail if @before is the list head). At the same time add the
+ * lock to the global file lock list.
  */
-static void locks_insert_lock(struct file_lock **pos, struct file_lock *fl)
+static void locks_insert_lock(struct file_lock *fl, struct list_head *before)
 {
-	list_add(&fl->fl_link, &file_lock_list);
-
 	fl->fl_nspid = get_pid(task_tgid(current));
-
-	/* insert into file's list */
-	fl->fl_next = *pos;
-	*pos = fl;
+	list_add_tail(&fl->fl_list, before);
+	locks_insert_global_locks(fl);
 }
 
 /*
@@ -557,14 +678,13 @@ static void locks_insert_lock(struct file_lock **pos, struct file_lock *fl)
  * Wake up processes that are blocked waiting for this lock,
  * notify the FS that the lock has been cleared and
  * finally free the lock.
+ *
+ * Must be called with the flc_lock held.
  */
-static void locks_delete_lock(struct file_lock **thisfl_p)
+static void locks_delete_lock(struct file_lock *fl)
 {
-	struct file_lock *fl = *thisfl_p;
-
-	*thisfl_p = fl->fl_next;
-	fl->fl_next = NULL;
-	list_del_init(&fl->fl_link);
+	locks_delete_global_locks(fl);
+	list_del_init(&fl->fl_list);
 
 	if (fl->fl_nspid) {
 		put_pid(fl->fl_nspid);
@@ -624,23 +744,26 @@ static int flock_locks_conflict(struct file_lock *caller_fl, struct file_lock *s
 void
 posix_test_lock(struct file *filp, struct file_lock *fl)
 {
+	struct file_lock_context *ctx = file_inode(filp)->i_flctx;
 	struct file_lock *cfl;
 
-	lock_flocks();
-	for (cfl = file_inode(filp)->i_flock; cfl; cfl = cfl->fl_next) {
-		if (!IS_POSIX(cfl))
-			continue;
-		if (posix_locks_conflict(fl, cfl))
-			break;
-	}
-	if (cfl) {
-		__locks_copy_lock(fl, cfl);
-		if (cfl->fl_nspid)
-			fl->fl_pid = pid_vnr(cfl->fl_nspid);
-	} else
+	if (!ctx || list_empty_careful(&ctx->flc_posix)) {
 		fl->fl_type = F_UNLCK;
-	unlock_flocks();
-	return;
+		return;
+	}
+
+	spin_lock(&ctx->flc_lock);
+	list_for_each_entry(cfl, &ctx->flc_posix, fl_list) {
+		if (posix_locks_conflict(fl, cfl)) {
+			__locks_copy_lock(fl, cfl);
+			if (cfl->fl_nspid)
+				fl->fl_pid = pid_vnr(cfl->fl_nspid);
+			goto out;
+		}
+	}
+	fl->fl_type = F_UNLCK;
+out:
+	spin_unlock(&ctx->flc_lock);
 }
 EXPORT_SYMBOL(posix_test_lock);
 
@@ -667,6 +790,10 @@ EXPORT_SYMBOL(posix_test_lock);
  * of tasks (such as posix threads) sharing the same open file table.
  *
  * To handle those cases, we just bail out after a few iterations.
+ *
+ * The waiters are kept in the blocked_hash, keyed by owner, and the walk
+ * only needs the blocked_lock_lock: a lock that has waiters cannot be
+ * freed without first taking it to wake them.
  */
 
 #define MAX_DEADLK_ITERATIONS 10
@@ -676,13 +803,15 @@ static struct file_lock *what_owner_is_waiting_for(struct file_lock *block_fl)
 {
 	struct file_lock *fl;
 
-	list_for_each_entry(fl, &blocked_list, fl_link) {
+	hash_for_each_possible(blocked_hash, fl, fl_link,
+			       posix_owner_key(block_fl)) {
 		if (posix_same_owner(fl, block_fl))
 			return fl->fl_next;
 	}
 	return NULL;
 }
 
+/* Must be called with the blocked_lock_lock held! */
 static int posix_locks_deadlock(struct file_lock *caller_fl,
 				struct file_lock *block_fl)
 {
@@ -697,8 +826,8 @@ static int posix_locks_deadlock(struct file_lock *caller_fl,
 	return 0;
 }
 
-/* Try to create a FLOCK lock on filp. We always insert new FLOCK locks
- * after any leases, but before any posix locks.
+/* Try to create a FLOCK lock on filp. New FLOCK locks are added at the
+ * tail of the inode's flock list.
  *
  * Note that if called with an FL_EXISTS argument, the caller may determine
  * whether or not a lock was successfully freed by testing the return
@@ -707,33 +836,33 @@ static int posix_locks_deadlock(struct file_lock *caller_fl,
 static int flock_lock_file(struct file *filp, struct file_lock *request)
 {
 	struct file_lock *new_fl = NULL;
-	struct file_lock **before;
-	struct inode * inode = file_inode(filp);
+	struct file_lock *fl;
+	struct file_lock_context *ctx;
+	struct inode *inode = file_inode(filp);
 	int error = 0;
 	int found = 0;
 
+	ctx = locks_get_lock_context(inode);
+	if (!ctx)
+		return -ENOMEM;
+
 	if (!(request->fl_flags & FL_ACCESS) && (request->fl_type != F_UNLCK)) {
 		new_fl = locks_alloc_lock();
 		if (!new_fl)
 			return -ENOMEM;
 	}
 
-	lock_flocks();
+	spin_lock(&ctx->flc_lock);
 	if (request->fl_flags & FL_ACCESS)
 		goto find_conflict;
 
-	for_each_lock(inode, before) {
-		struct file_lock *fl = *before;
-		if (IS_POSIX(fl))
-			break;
-		if (IS_LEASE(fl))
-			continue;
+	list_for_each_entry(fl, &ctx->flc_flock, fl_list) {
 		if (filp != fl->fl_file)
 			continue;
 		if (request->fl_type == fl->fl_type)
 			goto out;
 		found = 1;
-		locks_delete_lock(before);
+		locks_delete_lock(fl);
 		break;
 	}
 
@@ -748,18 +877,13 @@ static int flock_lock_file(struct file *filp, struct file_lock *request)
 	 * give it the opportunity to lock the file.
 	 */
 	if (found) {
-		unlock_flocks();
+		spin_unlock(&ctx->flc_lock);
 		cond_resched();
-		lock_flocks();
+		spin_lock(&ctx->flc_lock);
 	}
 
 find_conflict:
-	for_each_lock(inode, before) {
-		struct file_lock *fl = *before;
-		if (IS_POSIX(fl))
-			break;
-		if (IS_LEASE(fl))
-			continue;
+	list_for_each_entry(fl, &ctx->flc_flock, fl_list) {
 		if (!flock_locks_conflict(request, fl))
 			continue;
 		error = -EAGAIN;
@@ -772,12 +896,12 @@ find_conflict:
 	if (request->fl_flags & FL_ACCESS)
 		goto out;
 	locks_copy_lock(new_fl, request);
-	locks_insert_lock(before, new_fl);
+	locks_insert_lock(new_fl, &ctx->flc_flock);
 	new_fl = NULL;
 	error = 0;
 
 out:
-	unlock_flocks();
+	spin_unlock(&ctx->flc_lock);
 	if (new_fl)
 		locks_free_lock(new_fl);
 	return error;
@@ -785,14 +909,18 @@ out:
 
 static int __posix_lock_file(struct inode *inode, struct file_lock *request, struct file_lock *conflock)
 {
-	struct file_lock *fl;
+	struct file_lock *fl, *tmp;
 	struct file_lock *new_fl = NULL;
 	struct file_lock *new_fl2 = NULL;
 	struct file_lock *left = NULL;
 	struct file_lock *right = NULL;
-	struct file_lock **before;
+	struct file_lock_context *ctx;
 	int error, added = 0;
 
+	ctx = locks_get_lock_context(inode);
+	if (!ctx)
+		return -ENOMEM;
+
 	/*
 	 * We may need two file_lock structures for this operation,
 	 * so we get them in advance to avoid races.
@@ -806,12 +934,9 @@ static int __posix_lock_file(struct inode *inode, struct file_lock *request, str
 		new_fl2 = locks_alloc_lock();
 	}
 
-	lock_flocks();
+	spin_lock(&ctx->flc_lock);
 	if (request->fl_type != F_UNLCK) {
-		for_each_lock(inode, before) {
-			fl = *before;
-			if (!IS_POSIX(fl))
-				continue;
+		list_for_each_entry(fl, &ctx->flc_posix, fl_list) {
 			if (!posix_locks_conflict(request, fl))
 				continue;
 			if (conflock)
@@ -819,34 +944,37 @@ static int __posix_lock_file(struct inode *inode, struct file_lock *request, str
 			error = -EAGAIN;
 			if (!(request->fl_flags & FL_SLEEP))
 				goto out;
+			/*
+			 * Deadlock detection and insertion into the blocked
+			 * hash must be done under the same blocked_lock_lock.
+			 */
 			error = -EDEADLK;
-			if (posix_locks_deadlock(request, fl))
-				goto out;
-			error = FILE_LOCK_DEFERRED;
-			locks_insert_block(fl, request);
+			spin_lock(&blocked_lock_lock);
+			if (likely(!posix_locks_deadlock(request, fl))) {
+				error = FILE_LOCK_DEFERRED;
+				__locks_insert_block(fl, request);
+			}
+			spin_unlock(&blocked_lock_lock);
 			goto out;
-  		}
-  	}
+		}
+	}
 
 	/* If we're just looking for a conflict, we're done. */
 	error = 0;
 	if (request->fl_flags & FL_ACCESS)
 		goto out;
 
-	/*
-	 * Find the first old lock with the same owner as the new lock.
-	 */
-	
-	before = &inode->i_flock;
-
-	/* First skip locks owned by other processes.  */
-	while ((fl = *before) && (!IS_POSIX(fl) ||
-				  !posix_same_owner(request, fl))) {
-		before = &fl->fl_next;
+	/* Find the first old lock with the same owner as the new lock. */
+	list_for_each_entry(fl, &ctx->flc_posix, fl_list) {
+		if (posix_same_owner(request, fl))
+			break;
 	}
 
 	/* Process locks with this owner.  */
-	while ((fl = *before) && posix_same_owner(request, fl)) {
+	list_for_each_entry_safe_from(fl, tmp, &ctx->flc_posix, fl_list) {
+		if (!posix_same_owner(request, fl))
+			break;
+
 		/* Detect adjacent or overlapping regions (if same lock type)
 		 */
 		if (request->fl_type == fl->fl_type) {
@@ -855,7 +983,7 @@ static int __posix_lock_file(struct inode *inode, struct file_lock *request, str
 			 * is OFFSET_MAX, end + 1 will become negative.
 			 */
 			if (fl->fl_end < request->fl_start - 1)
-				goto next_lock;
+				continue;
 			/* If the next lock in the list has entirely bigger
 			 * addresses than the new one, insert the lock here.
 			 */
@@ -876,7 +1004,7 @@ static int __posix_lock_file(struct inode *inode, struct file_lock *request, str
 			else
 				request->fl_end = fl->fl_end;
 			if (added) {
-				locks_delete_lock(before);
+				locks_delete_lock(fl);
 				continue;
 			}
 			request = fl;
@@ -887,7 +1015,7 @@ static int __posix_lock_file(struct inode *inode, struct file_lock *request, str
 			 * more complex.
 			 */
 			if (fl->fl_end < request->fl_start)
-				goto next_lock;
+				continue;
 			if (fl->fl_start > request->fl_end)
 				break;
 			if (request->fl_type == F_UNLCK)
@@ -906,7 +1034,7 @@ static int __posix_lock_file(struct inode *inode, struct file_lock *request, str
 				 * one (This may happen several times).
 				 */
 				if (added) {
-					locks_delete_lock(before);
+					locks_delete_lock(fl);
 					continue;
 				}
 				/* Replace the old lock with the new one.
@@ -924,17 +1052,14 @@ static int __posix_lock_file(struct inode *inode, struct file_lock *request, str
 				added = 1;
 			}
 		}
-		/* Go on to next lock.
-		 */
-	next_lock:
-		before = &fl->fl_next;
 	}
 
 	/*
 	 * The above code only modifies existing locks in case of
 	 * merging or replacing.  If new lock(s) need to be inserted
 	 * all modifications are done bellow this, so it's safe yet to
-	 * bail out.
+	 * bail out.  From here on, new locks go in front of fl, which
+	 * is either the list head or the first lock past the new one.
 	 */
 	error = -ENOLCK; /* "no luck" */
 	if (right && left == right && !new_fl2)
@@ -953,7 +1078,8 @@ static int __posix_lock_file(struct inode *inode, struct file_lock *request, str
 			goto out;
 		}
 		locks_copy_lock(new_fl, request);
-		locks_insert_lock(before, new_fl);
+		locks_insert_lock(new_fl, &fl->fl_list);
+		fl = new_fl;
 		new_fl = NULL;
 	}
 	if (right) {
@@ -964,7 +1090,7 @@ static int __posix_lock_file(struct inode *inode, struct file_lock *request, str
 			left = new_fl2;
 			new_fl2 = NULL;
 			locks_copy_lock(left, right);
-			locks_insert_lock(before, left);
+			locks_insert_lock(left, &fl->fl_list);
 		}
 		right->fl_start = request->fl_end + 1;
 		locks_wake_up_blocks(right);
@@ -974,7 +1100,7 @@ static int __posix_lock_file(struct inode *inode, struct file_lock *request, str
 		locks_wake_up_blocks(left);
 	}
  out:
-	unlock_flocks();
+	spin_unlock(&ctx->flc_lock);
 	/*
 	 * Free any unused locks.
 	 */
@@ -1044,20 +1170,25 @@ EXPORT_SYMBOL(posix_lock_file_wait);
 int locks_mandatory_locked(struct inode *inode)
 {
 	fl_owner_t owner = current->files;
+	struct file_lock_context *ctx = inode->i_flctx;
 	struct file_lock *fl;
+	int ret = 0;
+
+	if (!ctx || list_empty_careful(&ctx->flc_posix))
+		return 0;
 
 	/*
 	 * Search the lock list for this inode for any POSIX locks.
 	 */
-	lock_flocks();
-	for (fl = inode->i_flock; fl != NULL; fl = fl->fl_next) {
-		if (!IS_POSIX(fl))
-			continue;
-		if (fl->fl_owner != owner)
+	spin_lock(&ctx->flc_lock);
+	list_for_each_entry(fl, &ctx->flc_posix, fl_list) {
+		if (fl->fl_owner != owner) {
+			ret = -EAGAIN;
 			break;
+		}
 	}
-	unlock_flocks();
-	return fl ? -EAGAIN : 0;
+	spin_unlock(&ctx->flc_lock);
+	return ret;
 }
 
 /**
@@ -1125,10 +1256,12 @@ static void lease_clear_pending(struct file_lock *fl, int arg)
 	}
 }
 
-/* We already had a lease on this file; just change its type */
-int lease_modify(struct file_lock **before, int arg)
+/*
+ * We already had a lease on this file; just change its type.
+ * Must be called with the inode's flc_lock held.
+ */
+int lease_modify(struct file_lock *fl, int arg)
 {
-	struct file_lock *fl = *before;
 	int error = assign_type(fl, arg);
 
 	if (error)
@@ -1145,7 +1278,7 @@ int lease_modify(struct file_lock **before, int arg)
 			printk(KERN_ERR "locks_delete_lock: fasync == %p\n", fl->fl_fasync);
 			fl->fl_fasync = NULL;
 		}
-		locks_delete_lock(before);
+		locks_delete_lock(fl);
 	}
 	return 0;
 }
@@ -1160,19 +1293,19 @@ static bool past_time(unsigned long then)
 	return time_after(jiffies, then);
 }
 
+/* Must be called with the inode's flc_lock held. */
 static void time_out_leases(struct inode *inode)
 {
-	struct file_lock **before;
-	struct file_lock *fl;
+	struct file_lock_context *ctx = inode->i_flctx;
+	struct file_lock *fl, *tmp;
 
-	before = &inode->i_flock;
-	while ((fl = *before) && IS_LEASE(fl) && lease_breaking(fl)) {
+	list_for_each_entry_safe(fl, tmp, &ctx->flc_lease, fl_list) {
+		if (!lease_breaking(fl))
+			continue;
 		if (past_time(fl->fl_downgrade_time))
-			lease_modify(before, F_RDLCK);
+			lease_modify(fl, F_RDLCK);
 		if (past_time(fl->fl_break_time))
-			lease_modify(before, F_UNLCK);
-		if (fl == *before)	/* lease_modify may have freed fl */
-			before = &fl->fl_next;
+			lease_modify(fl, F_UNLCK);
 	}
 }
 
@@ -1189,28 +1322,32 @@ static void time_out_leases(struct inode *inode)
 int __break_lease(struct inode *inode, unsigned int mode)
 {
 	int error = 0;
-	struct file_lock *new_fl, *flock;
-	struct file_lock *fl;
+	struct file_lock_context *ctx = inode->i_flctx;
+	struct file_lock *new_fl, *fl;
 	unsigned long break_time;
 	int i_have_this_lease = 0;
 	int want_write = (mode & O_ACCMODE) != O_RDONLY;
 
+	/* break_lease() has checked that there is a context */
+	if (WARN_ON_ONCE(!ctx))
+		return 0;
+
 	new_fl = lease_alloc(NULL, want_write ? F_WRLCK : F_RDLCK);
 	if (IS_ERR(new_fl))
 		return PTR_ERR(new_fl);
 
-	lock_flocks();
+	spin_lock(&ctx->flc_lock);
 
 	time_out_leases(inode);
 
-	flock = inode->i_flock;
-	if ((flock == NULL) || !IS_LEASE(flock))
+	if (list_empty(&ctx->flc_lease))
 		goto out;
 
-	if (!locks_conflict(flock, new_fl))
+	fl = list_first_entry(&ctx->flc_lease, struct file_lock, fl_list);
+	if (!locks_conflict(fl, new_fl))
 		goto out;
 
-	for (fl = flock; fl && IS_LEASE(fl); fl = fl->fl_next)
+	list_for_each_entry(fl, &ctx->flc_lease, fl_list)
 		if (fl->fl_owner == current->files)
 			i_have_this_lease = 1;
 
@@ -1221,14 +1358,14 @@ int __break_lease(struct inode *inode, unsigned int mode)
 			break_time++;	/* so that 0 means no break time */
 	}
 
-	for (fl = flock; fl && IS_LEASE(fl); fl = fl->fl_next) {
+	list_for_each_entry(fl, &ctx->flc_lease, fl_list) {
 		if (want_write) {
 			if (fl->fl_flags & FL_UNLOCK_PENDING)
 				continue;
 			fl->fl_flags |= FL_UNLOCK_PENDING;
 			fl->fl_break_time = break_time;
 		} else {
-			if (lease_breaking(flock))
+			if (lease_breaking(fl))
 				continue;
 			fl->fl_flags |= FL_DOWNGRADE_PENDING;
 			fl->fl_downgrade_time = break_time;
@@ -1241,18 +1378,19 @@ int __break_lease(struct inode *inode, unsigned int mode)
 		goto out;
 	}
 
+	fl = list_first_entry(&ctx->flc_lease, struct file_lock, fl_list);
 restart:
-	break_time = flock->fl_break_time;
+	break_time = fl->fl_break_time;
 	if (break_time != 0)
 		break_time -= jiffies;
 	if (break_time == 0)
 		break_time++;
-	locks_insert_block(flock, new_fl);
-	unlock_flocks();
+	locks_insert_block(fl, new_fl);
+	spin_unlock(&ctx->flc_lock);
 	error = wait_event_interruptible_timeout(new_fl->fl_wait,
 						!new_fl->fl_next, break_time);
-	lock_flocks();
-	__locks_delete_block(new_fl);
+	spin_lock(&ctx->flc_lock);
+	locks_delete_block(new_fl);
 	if (error >= 0) {
 		if (error == 0)
 			time_out_leases(inode);
@@ -1260,16 +1398,15 @@ restart:
 		 * Wait for the next conflicting lease that has not been
 		 * broken yet
 		 */
-		for (flock = inode->i_flock; flock && IS_LEASE(flock);
-				flock = flock->fl_next) {
-			if (locks_conflict(new_fl, flock))
+		list_for_each_entry(fl, &ctx->flc_lease, fl_list) {
+			if (locks_conflict(new_fl, fl))
 				goto restart;
 		}
 		error = 0;
 	}
 
 out:
-	unlock_flocks();
+	spin_unlock(&ctx->flc_lock);
 	locks_free_lock(new_fl);
 	return error;
 }
@@ -1287,8 +1424,20 @@ EXPORT_SYMBOL(__break_lease);
  */
 void lease_get_mtime(struct inode *inode, struct timespec *time)
 {
-	struct file_lock *flock = inode->i_flock;
-	if (flock && IS_LEASE(flock) && (flock->fl_type == F_WRLCK))
+	struct file_lock_context *ctx = inode->i_flctx;
+	struct file_lock *fl;
+	int has_lease = 0;
+
+	if (ctx && !list_empty_careful(&ctx->flc_lease)) {
+		spin_lock(&ctx->flc_lock);
+		fl = list_first_entry_or_null(&ctx->flc_lease,
+					      struct file_lock, fl_list);
+		if (fl && fl->fl_type == F_WRLCK)
+			has_lease = 1;
+		spin_unlock(&ctx->flc_lock);
+	}
+
+	if (has_lease)
 		*time = current_fs_time(inode->i_sb);
 	else
 		*time = inode->i_mtime;
@@ -1321,27 +1470,32 @@ EXPORT_SYMBOL(lease_get_mtime);
  */
 int fcntl_getlease(struct file *filp)
 {
+	struct inode *inode = file_inode(filp);
+	struct file_lock_context *ctx = inode->i_flctx;
 	struct file_lock *fl;
 	int type = F_UNLCK;
 
-	lock_flocks();
-	time_out_leases(file_inode(filp));
-	for (fl = file_inode(filp)->i_flock; fl && IS_LEASE(fl);
-			fl = fl->fl_next) {
+	if (!ctx || list_empty_careful(&ctx->flc_lease))
+		return type;
+
+	spin_lock(&ctx->flc_lock);
+	time_out_leases(inode);
+	list_for_each_entry(fl, &ctx->flc_lease, fl_list) {
 		if (fl->fl_file == filp) {
 			type = target_leasetype(fl);
 			break;
 		}
 	}
-	unlock_flocks();
+	spin_unlock(&ctx->flc_lock);
 	return type;
 }
 
 int generic_add_lease(struct file *filp, long arg, struct file_lock **flp)
 {
-	struct file_lock *fl, **before, **my_before = NULL, *lease;
+	struct file_lock *fl, *my_fl = NULL, *lease;
 	struct dentry *dentry = filp->f_path.dentry;
 	struct inode *inode = dentry->d_inode;
+	struct file_lock_context *ctx = inode->i_flctx;
 	int error;
 
 	lease = *flp;
@@ -1350,7 +1504,7 @@ int generic_add_lease(struct file *filp, long arg, struct file_lock **flp)
 	if ((arg == F_RDLCK) && (atomic_read(&inode->i_writecount) > 0))
 		goto out;
 	if ((arg == F_WRLCK)
-	    && ((dentry->d_count > 1)
+	    && ((d_count(dentry) > 1)
 		|| (atomic_read(&inode->i_count) > 1)))
 		goto out;
 
@@ -1363,11 +1517,9 @@ int generic_add_lease(struct file *filp, long arg, struct file_lock **flp)
 	 * except for this filp.
 	 */
 	error = -EAGAIN;
-	for (before = &inode->i_flock;
-			((fl = *before) != NULL) && IS_LEASE(fl);
-			before = &fl->fl_next) {
+	list_for_each_entry(fl, &ctx->flc_lease, fl_list) {
 		if (fl->fl_file == filp) {
-			my_before = before;
+			my_fl = fl;
 			continue;
 		}
 		/*
@@ -1384,10 +1536,10 @@ int generic_add_lease(struct file *filp, long arg, struct file_lock **flp)
 			goto out;
 	}
 
-	if (my_before != NULL) {
-		error = lease->fl_lmops->lm_change(my_before, arg);
+	if (my_fl != NULL) {
+		error = lease->fl_lmops->lm_change(my_fl, arg);
 		if (!error)
-			*flp = *my_before;
+			*flp = my_fl;
 		goto out;
 	}
 
@@ -1395,7 +1547,7 @@ int generic_add_lease(struct file *filp, long arg, struct file_lock **flp)
 	if (!leases_enable)
 		goto out;
 
-	locks_insert_lock(before, lease);
+	locks_insert_lock(lease, &ctx->flc_lease);
 	return 0;
 
 out:
@@ -1404,16 +1556,15 @@ out:
 
 int generic_delete_lease(struct file *filp, struct file_lock **flp)
 {
-	struct file_lock *fl, **before;
+	struct file_lock *fl;
 	struct dentry *dentry = filp->f_path.dentry;
 	struct inode *inode = dentry->d_inode;
+	struct file_lock_context *ctx = inode->i_flctx;
 
-	for (before = &inode->i_flock;
-			((fl = *before) != NULL) && IS_LEASE(fl);
-			before = &fl->fl_next) {
+	list_for_each_entry(fl, &ctx->flc_lease, fl_list) {
 		if (fl->fl_file != filp)
 			continue;
-		return (*flp)->fl_lmops->lm_change(before, F_UNLCK);
+		return (*flp)->fl_lmops->lm_change(fl, F_UNLCK);
 	}
 	return -EAGAIN;
 }
@@ -1427,7 +1578,7 @@ int generic_delete_lease(struct file *filp, struct file_lock **flp)
  *	The (input) flp->fl_lmops->lm_break function is required
  *	by break_lease().
  *
- *	Called with file_lock_lock held.
+ *	Called with the inode's flc_lock held.
  */
 int generic_setlease(struct file *filp, long arg, struct file_lock **flp)
 {
@@ -1496,11 +1647,16 @@ static int __vfs_setlease(struct file *filp, long arg, struct file_lock **lease)
 
 int vfs_setlease(struct file *filp, long arg, struct file_lock **lease)
 {
+	struct file_lock_context *ctx;
 	int error;
 
-	lock_flocks();
+	ctx = locks_get_lock_context(file_inode(filp));
+	if (!ctx)
+		return -ENOMEM;
+
+	spin_lock(&ctx->flc_lock);
 	error = __vfs_setlease(filp, arg, lease);
-	unlock_flocks();
+	spin_unlock(&ctx->flc_lock);
 
 	return error;
 }
@@ -1518,9 +1674,14 @@ static int do_fcntl_delete_lease(struct file *filp)
 static int do_fcntl_add_lease(unsigned int fd, struct file *filp, long arg)
 {
 	struct file_lock *fl, *ret;
+	struct file_lock_context *ctx;
 	struct fasync_struct *new;
 	int error;
 
+	ctx = locks_get_lock_context(file_inode(filp));
+	if (!ctx)
+		return -ENOMEM;
+
 	fl = lease_alloc(filp, arg);
 	if (IS_ERR(fl))
 		return PTR_ERR(fl);
@@ -1531,10 +1692,10 @@ static int do_fcntl_add_lease(unsigned int fd, struct file *filp, long arg)
 		return -ENOMEM;
 	}
 	ret = fl;
-	lock_flocks();
+	spin_lock(&ctx->flc_lock);
 	error = __vfs_setlease(filp, arg, &ret);
 	if (error) {
-		unlock_flocks();
+		spin_unlock(&ctx->flc_lock);
 		locks_free_lock(fl);
 		goto out_free_fasync;
 	}
@@ -1551,7 +1712,7 @@ static int do_fcntl_add_lease(unsigned int fd, struct file *filp, long arg)
 		new = NULL;
 
 	error = __f_setown(filp, task_pid(current), PIDTYPE_PID, 0);
-	unlock_flocks();
+	spin_unlock(&ctx->flc_lock);
 
 out_free_fasync:
 	if (new)
@@ -1885,7 +2046,7 @@ again:
 	 */
 	/*
 	 * we need that spin_lock here - it prevents reordering between
-	 * update of inode->i_flock and check for it done in close().
+	 * update of the inode's lock lists and check for it done in close().
 	 * rcu_read_lock() wouldn't do.
 	 */
 	spin_lock(&current->files->file_lock);
@@ -2022,6 +2183,7 @@ out:
  */
 void locks_remove_posix(struct file *filp, fl_owner_t owner)
 {
+	struct file_lock_context *ctx = file_inode(filp)->i_flctx;
 	struct file_lock lock;
 
 	/*
@@ -2029,7 +2191,7 @@ void locks_remove_posix(struct file *filp, fl_owner_t owner)
 	 * posix_lock_file().  Another process could be setting a lock on this
 	 * file at the same time, but we wouldn't remove that lock anyway.
 	 */
-	if (!file_inode(filp)->i_flock)
+	if (!ctx || list_empty_careful(&ctx->flc_posix))
 		return;
 
 	lock.fl_type = F_UNLCK;
@@ -2055,11 +2217,13 @@ EXPORT_SYMBOL(locks_remove_posix);
  */
 void locks_remove_flock(struct file *filp)
 {
-	struct inode * inode = file_inode(filp);
-	struct file_lock *fl;
-	struct file_lock **before;
+	struct file_lock_context *ctx = file_inode(filp)->i_flctx;
+	struct file_lock *fl, *tmp;
 
-	if (!inode->i_flock)
+	if (!ctx)
+		return;
+	if (list_empty_careful(&ctx->flc_flock) &&
+	    list_empty_careful(&ctx->flc_lease))
 		return;
 
 	if (filp->f_op && filp->f_op->flock) {
@@ -2075,25 +2239,15 @@ void locks_remove_flock(struct file *filp)
 			fl.fl_ops->fl_release_private(&fl);
 	}
 
-	lock_flocks();
-	before = &inode->i_flock;
+	spin_lock(&ctx->flc_lock);
+	list_for_each_entry_safe(fl, tmp, &ctx->flc_flock, fl_list)
+		if (fl->fl_file == filp)
+			locks_delete_lock(fl);
 
-	while ((fl = *before) != NULL) {
-		if (fl->fl_file == filp) {
-			if (IS_FLOCK(fl)) {
-				locks_delete_lock(before);
-				continue;
-			}
-			if (IS_LEASE(fl)) {
-				lease_modify(before, F_UNLCK);
-				continue;
-			}
-			/* What? */
-			BUG();
- 		}
-		before = &fl->fl_next;
-	}
-	unlock_flocks();
+	list_for_each_entry_safe(fl, tmp, &ctx->flc_lease, fl_list)
+		if (fl->fl_file == filp)
+			lease_modify(fl, F_UNLCK);
+	spin_unlock(&ctx->flc_lock);
 }
 
 /**
@@ -2108,12 +2262,12 @@ posix_unblock_lock(struct file *filp, struct file_lock *waiter)
 {
 	int status = 0;
 
-	lock_flocks();
+	spin_lock(&blocked_lock_lock);
 	if (waiter->fl_next)
 		__locks_delete_block(waiter);
 	else
 		status = -ENOENT;
-	unlock_flocks();
+	spin_unlock(&blocked_lock_lock);
 	return status;
 }
 
@@ -2139,6 +2293,11 @@ EXPORT_SYMBOL_GPL(vfs_cancel_lock);
 #include <linux/proc_fs.h>
 #include <linux/seq_file.h>
 
+struct locks_iterator {
+	int	li_cpu;
+	loff_t	li_pos;
+};
+
 static void lock_get_status(struct seq_file *f, struct file_lock *fl,
 			    loff_t id, char *pfx)
 {
@@ -2212,37 +2371,41 @@ static void lock_get_status(struct seq_file *f, struct file_lock *fl,
 
 static int locks_show(struct seq_file *f, void *v)
 {
+	struct locks_iterator *iter = f->private;
 	struct file_lock *fl, *bfl;
 
-	fl = list_entry(v, struct file_lock, fl_link);
+	fl = hlist_entry(v, struct file_lock, fl_link);
 
-	lock_get_status(f, fl, *((loff_t *)f->private), "");
+	lock_get_status(f, fl, iter->li_pos, "");
 
 	list_for_each_entry(bfl, &fl->fl_block, fl_block)
-		lock_get_status(f, bfl, *((loff_t *)f->private), " ->");
+		lock_get_status(f, bfl, iter->li_pos, " ->");
 
 	return 0;
 }
 
 static void *locks_start(struct seq_file *f, loff_t *pos)
 {
-	loff_t *p = f->private;
+	struct locks_iterator *iter = f->private;
 
-	lock_flocks();
-	*p = (*pos + 1);
-	return seq_list_start(&file_lock_list, *pos);
+	iter->li_pos = *pos + 1;
+	lg_global_lock(&file_lock_lglock);
+	spin_lock(&blocked_lock_lock);
+	return seq_hlist_start_percpu(&file_lock_list, &iter->li_cpu, *pos);
 }
 
 static void *locks_next(struct seq_file *f, void *v, loff_t *pos)
 {
-	loff_t *p = f->private;
-	++*p;
-	return seq_list_next(v, &file_lock_list, pos);
+	struct locks_iterator *iter = f->private;
+
+	++iter->li_pos;
+	return seq_hlist_next_percpu(v, &file_lock_list, &iter->li_cpu, pos);
 }
 
 static void locks_stop(struct seq_file *f, void *v)
 {
-	unlock_flocks();
+	spin_unlock(&blocked_lock_lock);
+	lg_global_unlock(&file_lock_lglock);
 }
 
 static const struct seq_operations locks_seq_operations = {
@@ -2254,7 +2417,8 @@ static const struct seq_operations locks_seq_operations = {
 
 static int locks_open(struct inode *inode, struct file *filp)
 {
-	return seq_open_private(filp, &locks_seq_operations, sizeof(loff_t));
+	return seq_open_private(filp, &locks_seq_operations,
+					sizeof(struct locks_iterator));
 }
 
 static const struct file_operations proc_locks_operations = {
@@ -2287,26 +2451,32 @@ module_init(proc_locks_init);
  */
 int lock_may_read(struct inode *inode, loff_t start, unsigned long len)
 {
+	struct file_lock_context *ctx = inode->i_flctx;
 	struct file_lock *fl;
 	int result = 1;
-	lock_flocks();
-	for (fl = inode->i_flock; fl != NULL; fl = fl->fl_next) {
-		if (IS_POSIX(fl)) {
-			if (fl->fl_type == F_RDLCK)
-				continue;
-			if ((fl->fl_end < start) || (fl->fl_start > (start + len)))
-				continue;
-		} else if (IS_FLOCK(fl)) {
-			if (!(fl->fl_type & LOCK_MAND))
-				continue;
-			if (fl->fl_type & LOCK_READ)
-				continue;
-		} else
+
+	if (!ctx)
+		return result;
+
+	spin_lock(&ctx->flc_lock);
+	list_for_each_entry(fl, &ctx->flc_posix, fl_list) {
+		if (fl->fl_type == F_RDLCK)
+			continue;
+		if ((fl->fl_end < start) || (fl->fl_start > (start + len)))
 			continue;
 		result = 0;
-		break;
+		goto out;
+	}
+	list_for_each_entry(fl, &ctx->flc_flock, fl_list) {
+		if (!(fl->fl_type & LOCK_MAND))
+			continue;
+		if (fl->fl_type & LOCK_READ)
+			continue;
+		result = 0;
+		goto out;
 	}
-	unlock_flocks();
+out:
+	spin_unlock(&ctx->flc_lock);
 	return result;
 }
 
@@ -2327,24 +2497,30 @@ EXPORT_SYMBOL(lock_may_read);
  */
 int lock_may_write(struct inode *inode, loff_t start, unsigned long len)
 {
+	struct file_lock_context *ctx = inode->i_flctx;
 	struct file_lock *fl;
 	int result = 1;
-	lock_flocks();
-	for (fl = inode->i_flock; fl != NULL; fl = fl->fl_next) {
-		if (IS_POSIX(fl)) {
-			if ((fl->fl_end < start) || (fl->fl_start > (start + len)))
-				continue;
-		} else if (IS_FLOCK(fl)) {
-			if (!(fl->fl_type & LOCK_MAND))
-				continue;
-			if (fl->fl_type & LOCK_WRITE)
-				continue;
-		} else
+
+	if (!ctx)
+		return result;
+
+	spin_lock(&ctx->flc_lock);
+	list_for_each_entry(fl, &ctx->flc_posix, fl_list) {
+		if ((fl->fl_end < start) || (fl->fl_start > (start + len)))
 			continue;
 		result = 0;
-		break;
+		goto out;
 	}
-	unlock_flocks();
+	list_for_each_entry(fl, &ctx->flc_flock, fl_list) {
+		if (!(fl->fl_type & LOCK_MAND))
+			continue;
+		if (fl->fl_type & LOCK_WRITE)
+			continue;
+		result = 0;
+		goto out;
+	}
+out:
+	spin_unlock(&ctx->flc_lock);
 	return result;
 }
 
@@ -2352,9 +2528,19 @@ EXPORT_SYMBOL(lock_may_write);
 
 static int __init filelock_init(void)
 {
+	int i;
+
+	flctx_cache = kmem_cache_create("file_lock_ctx",
+			sizeof(struct file_lock_context), 0, SLAB_PANIC, NULL);
+
 	filelock_cache = kmem_cache_create("file_lock_cache",
 			sizeof(struct file_lock), 0, SLAB_PANIC, NULL);
 
+	lg_lock_init(&file_lock_lglock, "file_lock_lglock");
+
+	for_each_possible_cpu(i)
+		INIT_HLIST_HEAD(per_cpu_ptr(&file_lock_list, i));
+
 	return 0;
 }
 
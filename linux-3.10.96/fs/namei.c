@@ -523,12 +523,17 @@ static inline void unlock_rcu_walk(void)
  * unlazy_walk attempts to legitimize the current nd->path, nd->root and dentry
  * for ref-walk mode.  @dentry must be a path found by a do_lookup call on
  * @nd or NULL.  Must be called from rcu-walk context.
+ *
+ * On failure we have left rcu-walk as well, with nothing held in nd->path,
+ * so that references taken on the way can be dropped with dput().
  */
 static int unlazy_walk(struct nameidata *nd, struct dentry *dentry)
 {
 	struct fs_struct *fs = current->fs;
 	struct dentry *parent = nd->path.dentry;
+	struct dentry *put_parent = NULL, *put_child = NULL;
 	int want_root = 0;
+	int err;
 
 	BUG_ON(!(nd->flags & LOOKUP_RCU));
 	if (nd->root.mnt && !(nd->flags & LOOKUP_ROOT)) {
@@ -538,29 +543,40 @@ static int unlazy_walk(struct nameidata *nd, struct dentry *dentry)
 				nd->root.dentry != fs->root.dentry)
 			goto err_root;
 	}
-	spin_lock(&parent->d_lock);
+
+	/*
+	 * For a negative lookup, the lookup sequence point is the parent's
+	 * sequence point, and it only needs to revalidate the parent dentry.
+	 *
+	 * For a positive lookup, both the parent and the dentry have to be
+	 * moved from the RCU domain to be properly refcounted.  The sequence
+	 * number in the dentry validates *both*, since we checked the
+	 * sequence number of the parent after we got the child sequence
+	 * number: if the child has not moved, the parent is still valid.
+	 *
+	 * d_rcu_to_refcount() takes the references without d_lock unless
+	 * somebody else holds it.  If it fails with -ECHILD, the reference
+	 * is still held and is dropped below, after unlock_rcu_walk().
+	 */
 	if (!dentry) {
-		if (!__d_rcu_to_refcount(parent, nd->seq))
-			goto err_parent;
+		err = d_rcu_to_refcount(parent, &parent->d_seq, nd->seq);
+		if (err == -ECHILD)
+			put_parent = parent;
+		if (err)
+			goto err_root;
 		BUG_ON(nd->inode != parent->d_inode);
 	} else {
-		if (dentry->d_parent != parent)
-			goto err_parent;
-		spin_lock_nested(&dentry->d_lock, DENTRY_D_LOCK_NESTED);
-		if (!__d_rcu_to_refcount(dentry, nd->seq))
+		err = d_rcu_to_refcount(dentry, &dentry->d_seq, nd->seq);
+		if (err == -ECHILD)
+			put_child = dentry;
+		if (err)
+			goto err_root;
+		err = d_rcu_to_refcount(parent, &dentry->d_seq, nd->seq);
+		if (err == -ECHILD)
+			put_parent = parent;
+		if (err)
 			goto err_child;
-		/*
-		 * If the sequence check on the child dentry passed, then
-		 * the child has not been removed from its parent. This
-		 * means the parent dentry must be valid and able to take
-		 * a reference at this point.
-		 */
-		BUG_ON(!IS_ROOT(dentry) && dentry->d_parent != parent);
-		BUG_ON(!parent->d_count);
-		parent->d_count++;
-		spin_unlock(&dentry->d_lock);
 	}
-	spin_unlock(&parent->d_lock);
 	if (want_root) {
 		path_get(&nd->root);
 		spin_unlock(&fs->lock);
@@ -572,12 +588,18 @@ static int unlazy_walk(struct nameidata *nd, struct dentry *dentry)
 	return 0;
 
 err_child:
-	spin_unlock(&dentry->d_lock);
-err_parent:
-	spin_unlock(&parent->d_lock);
+	put_child = dentry;
 err_root:
 	if (want_root)
 		spin_unlock(&fs->lock);
+	nd->flags &= ~LOOKUP_RCU;
+	if (!(nd->flags & LOOKUP_ROOT))
+		nd->root.mnt = NULL;
+	nd->path.mnt = NULL;
+	nd->path.dentry = NULL;
+	unlock_rcu_walk();
+	dput(put_child);
+	dput(put_parent);
 	return -ECHILD;
 }
 
@@ -605,14 +627,14 @@ static int complete_walk(struct nameidata *nd)
 		nd->flags &= ~LOOKUP_RCU;
 		if (!(nd->flags & LOOKUP_ROOT))
 			nd->root.mnt = NULL;
-		spin_lock(&dentry->d_lock);
-		if (unlikely(!__d_rcu_to_refcount(dentry, nd->seq))) {
-			spin_unlock(&dentry->d_lock);
+		status = d_rcu_to_refcount(dentry, &dentry->d_seq, nd->seq);
+		if (unlikely(status)) {
 			unlock_rcu_walk();
+			if (status == -ECHILD)
+				dput(dentry);
 			return -ECHILD;
 		}
 		BUG_ON(nd->inode != dentry->d_inode);
-		spin_unlock(&dentry->d_lock);
 		mntget(nd->path.mnt);
 		unlock_rcu_walk();
 	}
@@ -3406,7 +3428,7 @@ void dentry_unhash(struct dentry *dentry)
 {
 	shrink_dcache_parent(dentry);
 	spin_lock(&dentry->d_lock);
-	if (dentry->d_count == 1)
+	if (d_count(dentry) == 1)
 		__d_drop(dentry);
 	spin_unlock(&dentry->d_lock);
 }
@@ -519,10 +519,20 @@ int nfs_getattr(struct vfsmount *mnt, struct dentry *dentry, struct kstat *stat)
 {
 	struct inode *inode = dentry->d_inode;
 	int need_atime = NFS_I(inode)->cache_validity & NFS_INO_INVALID_ATIME;
+	u32 request_mask = stat->request_mask;
+	unsigned int query_flags = stat->query_flags;
 	int err = 0;
 
-	/* Flush out writes to the server in order to update c/mtime.  */
-	if (S_ISREG(inode->i_mode)) {
+	/* The caller is happy with whatever we have cached. */
+	if ((query_flags & AT_STATX_SYNC_TYPE) == AT_STATX_DONT_SYNC)
+		goto out_fill;
+
+	/*
+	 * Flush out writes to the server in order to update c/mtime, but
+	 * only if the caller is going to look at them.
+	 */
+	if (S_ISREG(inode->i_mode) &&
+	    (request_mask & (STATX_CTIME | STATX_MTIME))) {
 		nfs_inode_dio_wait(inode);
 		err = filemap_write_and_wait(inode->i_mapping);
 		if (err)
@@ -541,15 +551,28 @@ int nfs_getattr(struct vfsmount *mnt, struct dentry *dentry, struct kstat *stat)
  	if ((mnt->mnt_flags & MNT_NOATIME) ||
  	    ((mnt->mnt_flags & MNT_NODIRATIME) && S_ISDIR(inode->i_mode)))
 		need_atime = 0;
+	if (!(request_mask & STATX_ATIME))
+		need_atime = 0;
 
-	if (need_atime)
+	/*
+	 * Type, inode number and rdev never change under us; if nothing
+	 * else was asked for, there is nothing to revalidate.
+	 */
+	if (!(query_flags & AT_STATX_FORCE_SYNC) &&
+	    !(request_mask & (STATX_MODE | STATX_NLINK | STATX_UID |
+			      STATX_GID | STATX_ATIME | STATX_MTIME |
+			      STATX_CTIME | STATX_SIZE | STATX_BLOCKS)))
+		goto out_fill;
+
+	if (need_atime || (query_flags & AT_STATX_FORCE_SYNC))
 		err = __nfs_revalidate_inode(NFS_SERVER(inode), inode);
 	else
 		err = nfs_revalidate_inode(NFS_SERVER(inode), inode);
-	if (!err) {
-		generic_fillattr(inode, stat);
-		stat->ino = nfs_compat_user_ino64(NFS_FILEID(inode));
-	}
+	if (err)
+		goto out;
+out_fill:
+	generic_fillattr(inode, stat);
+	stat->ino = nfs_compat_user_ino64(NFS_FILEID(inode));
 out:
 	return err;
 }
@@ -899,6 +899,7 @@ int nfs_updatepage(struct file *file, struct page *page,
 {
 	struct nfs_open_context *ctx = nfs_file_open_context(file);
 	struct inode	*inode = page_file_mapping(page)->host;
+	struct file_lock_context *flctx = inode->i_flctx;
 	int		status = 0;
 
 	nfs_inc_stats(inode, NFSIOS_VFSUPDATEPAGE);
@@ -914,7 +915,8 @@ int nfs_updatepage(struct file *file, struct page *page,
 	 * inefficiencies.
 	 */
 	if (nfs_write_pageuptodate(page, inode) &&
-			inode->i_flock == NULL &&
+			(!flctx || (list_empty_careful(&flctx->flc_flock) &&
+				    list_empty_careful(&flctx->flc_posix))) &&
 			!(file->f_flags & O_DSYNC)) {
 		count = max(count + offset, nfs_page_length(page));
 		offset = 0;
@@ -2641,13 +2641,13 @@ static void nfsd_break_one_deleg(struct nfs4_delegation *dp)
 
 	list_add_tail(&dp->dl_recall_lru, &nn->del_recall_lru);
 
-	/* only place dl_time is set. protected by lock_flocks*/
+	/* only place dl_time is set. protected by the inode's flc_lock */
 	dp->dl_time = get_seconds();
 
 	nfsd4_cb_recall(dp);
 }
 
-/* Called from break_lease() with lock_flocks() held. */
+/* Called from break_lease() with the inode's flc_lock held. */
 static void nfsd_break_deleg_cb(struct file_lock *fl)
 {
 	struct nfs4_file *fp = (struct nfs4_file *)fl->fl_owner;
@@ -2676,7 +2676,7 @@ static void nfsd_break_deleg_cb(struct file_lock *fl)
 }
 
 static
-int nfsd_change_deleg_cb(struct file_lock **onlist, int arg)
+int nfsd_change_deleg_cb(struct file_lock *onlist, int arg)
 {
 	if (arg & F_UNLCK)
 		return lease_modify(onlist, arg);
@@ -4536,19 +4536,22 @@ out_nfserr:
 static int
 check_for_locks(struct nfs4_file *filp, struct nfs4_lockowner *lowner)
 {
-	struct file_lock **flpp;
+	struct file_lock *fl;
 	struct inode *inode = filp->fi_inode;
+	struct file_lock_context *flctx = inode->i_flctx;
 	int status = 0;
 
-	lock_flocks();
-	for (flpp = &inode->i_flock; *flpp != NULL; flpp = &(*flpp)->fl_next) {
-		if ((*flpp)->fl_owner == (fl_owner_t)lowner) {
+	if (!flctx || list_empty_careful(&flctx->flc_posix))
+		return status;
+
+	spin_lock(&flctx->flc_lock);
+	list_for_each_entry(fl, &flctx->flc_posix, fl_list) {
+		if (fl->fl_owner == (fl_owner_t)lowner) {
 			status = 1;
-			goto out;
+			break;
 		}
 	}
-out:
-	unlock_flocks();
+	spin_unlock(&flctx->flc_lock);
 	return status;
 }
 
@@ -14,12 +14,15 @@
 #include <linux/file.h>
 #include <linux/fs.h>
 #include <linux/dirent.h>
+#include <linux/namei.h>
 #include <linux/security.h>
 #include <linux/syscalls.h>
 #include <linux/unistd.h>
 
 #include <asm/uaccess.h>
 
+#include "internal.h"
+
 int vfs_readdir(struct file *file, filldir_t filler, void *buf)
 {
 	struct inode *inode = file_inode(file);
@@ -300,3 +303,231 @@ SYSCALL_DEFINE3(getdents64, unsigned int, fd,
 	fdput(f);
 	return error;
 }
+
+/*
+ * getdents_statx(): getdents64 with the statx() result of each entry
+ * folded in, so that tree walkers (du, rsync, indexers) don't need a
+ * separate path walk and stat per name.
+ *
+ * Names are first buffered in a page, because we must not call back into
+ * the filesystem's ->lookup() from the filldir callback; then, with i_mutex
+ * held as lookup_one_len() requires, each name is looked up relative to the
+ * directory (a dcache hit, or an inode cache hit for a recently read
+ * directory) and handed to ->getattr() with the caller's request mask.
+ * This is the same scheme nfsd uses for READDIRPLUS.
+ *
+ * Records are assembled in a kernel buffer and only copied to userspace
+ * once i_mutex has been dropped, so a fault on the user buffer never takes
+ * mmap_sem under it.  Whenever we stop short of what vfs_readdir() handed
+ * us (user buffer full, fatal signal, fault), the directory is seeked back
+ * to the first entry not returned, so no entry is lost.
+ */
+struct dirstat_dirent {
+	u64		ino;
+	loff_t		offset;
+	int		namlen;
+	unsigned int	d_type;
+	char		name[];
+};
+
+struct dirstat_buf {
+	char		*dirent;
+	size_t		used;
+	int		full;
+};
+
+static int dirstat_filldir(void *__buf, const char *name, int namlen,
+			   loff_t offset, u64 ino, unsigned int d_type)
+{
+	struct dirstat_buf *buf = __buf;
+	struct dirstat_dirent *de = (void *)(buf->dirent + buf->used);
+	unsigned int reclen;
+
+	reclen = ALIGN(sizeof(struct dirstat_dirent) + namlen, sizeof(u64));
+	if (buf->used + reclen > PAGE_SIZE) {
+		buf->full = 1;
+		return -EINVAL;
+	}
+
+	de->namlen = namlen;
+	de->offset = offset;
+	de->ino = ino;
+	de->d_type = d_type;
+	memcpy(de->name, name, namlen);
+	buf->used += reclen;
+
+	return 0;
+}
+
+/*
+ * Called with the directory's i_mutex held.  Leaves stat->result_mask at
+ * zero if the entry can't be stat'ed without a full path walk: ".." and
+ * mountpoints would need to cross mounts, and the name may have gone away
+ * since it was read.
+ */
+static void dirstat_getattr(struct file *file, struct dirstat_dirent *de,
+			    u32 mask, unsigned int flags, struct kstat *stat)
+{
+	struct path path;
+	struct dentry *dentry;
+
+	memset(stat, 0, sizeof(*stat));
+
+	if (de->namlen == 1 && de->name[0] == '.') {
+		if (vfs_getattr_mask(&file->f_path, stat, mask, flags))
+			stat->result_mask = 0;
+		return;
+	}
+
+	dentry = lookup_one_len(de->name, file->f_path.dentry, de->namlen);
+	if (IS_ERR(dentry))
+		return;
+	if (dentry->d_inode && !d_mountpoint(dentry)) {
+		path.mnt = file->f_path.mnt;
+		path.dentry = dentry;
+		if (vfs_getattr_mask(&path, stat, mask, flags))
+			stat->result_mask = 0;
+	}
+	dput(dentry);
+}
+
+#define DIRSTAT_OUT_ORDER	1
+#define DIRSTAT_OUT_SIZE	(PAGE_SIZE << DIRSTAT_OUT_ORDER)
+
+static unsigned int dirstat_reclen(struct dirstat_dirent *de)
+{
+	return ALIGN(offsetof(struct linux_dirent_statx, d_name) +
+		     de->namlen + 1, sizeof(u64));
+}
+
+static void dirstat_fill(void *out, struct dirstat_dirent *de,
+			 loff_t next_offset, struct kstat *stat)
+{
+	struct linux_dirent_statx *dirent = out;
+	unsigned int reclen = dirstat_reclen(de);
+
+	memset(dirent, 0, reclen);
+	dirent->d_ino = de->ino;
+	dirent->d_off = next_offset;
+	dirent->d_reclen = reclen;
+	dirent->d_type = de->d_type;
+	fill_statx(&dirent->d_stat, stat);
+	memcpy(dirent->d_name, de->name, de->namlen);
+}
+
+static struct dirstat_dirent *dirstat_next(struct dirstat_dirent *de)
+{
+	return (void *)de + ALIGN(sizeof(*de) + de->namlen, sizeof(u64));
+}
+
+SYSCALL_DEFINE5(getdents_statx, unsigned int, fd,
+		struct linux_dirent_statx __user *, dirent, unsigned int, count,
+		unsigned int, mask, unsigned int, flags)
+{
+	char __user *ubuf = (char __user *)dirent;
+	struct dirstat_buf buf;
+	struct dirstat_dirent *de, *end, *chunk;
+	struct kstat stat;
+	struct inode *dir_inode;
+	struct fd f;
+	unsigned int remaining = count;
+	loff_t end_pos;
+	char *out;
+	int error = 0;
+
+	if (flags & ~KSTAT_QUERY_FLAGS)
+		return -EINVAL;
+	if ((flags & AT_STATX_SYNC_TYPE) == AT_STATX_SYNC_TYPE)
+		return -EINVAL;
+	if (mask & STATX__RESERVED)
+		return -EINVAL;
+	if (!access_ok(VERIFY_WRITE, dirent, count))
+		return -EFAULT;
+
+	f = fdget(fd);
+	if (!f.file)
+		return -EBADF;
+	dir_inode = file_inode(f.file);
+
+	error = -ENOMEM;
+	buf.dirent = (void *)__get_free_page(GFP_KERNEL);
+	if (!buf.dirent)
+		goto out;
+	out = (void *)__get_free_pages(GFP_KERNEL, DIRSTAT_OUT_ORDER);
+	if (!out)
+		goto out_free;
+
+	while (1) {
+		buf.used = 0;
+		buf.full = 0;
+
+		error = vfs_readdir(f.file, dirstat_filldir, &buf);
+		if (buf.full)
+			error = 0;
+		if (error < 0 || !buf.used)
+			break;
+
+		/* Where the next vfs_readdir() would pick up. */
+		end_pos = f.file->f_pos;
+		de = (struct dirstat_dirent *)buf.dirent;
+		end = (struct dirstat_dirent *)(buf.dirent + buf.used);
+
+		while (de < end) {
+			size_t len = 0;
+
+			if (dirstat_reclen(de) > remaining) {
+				if (remaining == count)
+					error = -EINVAL; /* Buffer too small */
+				break;
+			}
+
+			/*
+			 * ->lookup() and ->getattr() expect i_mutex, as they
+			 * would have it within readdir.  User memory is only
+			 * touched once it has been dropped again.
+			 */
+			error = mutex_lock_killable(&dir_inode->i_mutex);
+			if (error)
+				break;
+			chunk = de;
+			while (de < end) {
+				struct dirstat_dirent *next = dirstat_next(de);
+				unsigned int reclen = dirstat_reclen(de);
+				loff_t next_pos;
+
+				if (len + reclen > remaining ||
+				    len + reclen > DIRSTAT_OUT_SIZE)
+					break;
+				next_pos = next < end ? next->offset : end_pos;
+				dirstat_getattr(f.file, de, mask, flags, &stat);
+				dirstat_fill(out + len, de, next_pos, &stat);
+				len += reclen;
+				de = next;
+			}
+			mutex_unlock(&dir_inode->i_mutex);
+
+			if (copy_to_user(ubuf, out, len)) {
+				de = chunk;
+				error = -EFAULT;
+				break;
+			}
+			ubuf += len;
+			remaining -= len;
+		}
+
+		if (de < end) {
+			/* Rewind to the first entry not returned to the user */
+			vfs_llseek(f.file, de->offset, SEEK_SET);
+			break;
+		}
+	}
+
+	free_pages((unsigned long)out, DIRSTAT_OUT_ORDER);
+out_free:
+	free_page((unsigned long)buf.dirent);
+	if (remaining != count)
+		error = count - remaining;
+out:
+	fdput(f);
+	return error;
+}
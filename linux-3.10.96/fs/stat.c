@@ -18,6 +18,8 @@
 #include <asm/uaccess.h>
 #include <asm/unistd.h>
 
+#include "internal.h"
+
 void generic_fillattr(struct inode *inode, struct kstat *stat)
 {
 	stat->dev = inode->i_sb->s_dev;
@@ -37,11 +39,28 @@ void generic_fillattr(struct inode *inode, struct kstat *stat)
 
 EXPORT_SYMBOL(generic_fillattr);
 
-int vfs_getattr(struct path *path, struct kstat *stat)
+/**
+ * vfs_getattr_mask - Get the attributes of a path, honouring a request mask
+ * @path: file to get attributes from
+ * @stat: structure to return attributes in
+ * @request_mask: STATX_xxx flags indicating what the caller wants
+ * @query_flags: AT_STATX_xxx flags indicating how far to go to sync them
+ *
+ * The request mask and sync mode are passed down to ->getattr() through
+ * @stat.  A filesystem may use them to avoid revalidating attributes nobody
+ * asked for; generic_fillattr() always fills in everything it can anyway.
+ */
+int vfs_getattr_mask(struct path *path, struct kstat *stat,
+		     u32 request_mask, unsigned int query_flags)
 {
 	struct inode *inode = path->dentry->d_inode;
 	int retval;
 
+	memset(stat, 0, sizeof(*stat));
+	stat->result_mask |= STATX_BASIC_STATS;
+	stat->request_mask = request_mask & STATX_ALL;
+	stat->query_flags = query_flags & KSTAT_QUERY_FLAGS;
+
 	retval = security_inode_getattr(path->mnt, path->dentry);
 	if (retval)
 		return retval;
@@ -52,6 +71,13 @@ int vfs_getattr(struct path *path, struct kstat *stat)
 	generic_fillattr(inode, stat);
 	return 0;
 }
+EXPORT_SYMBOL(vfs_getattr_mask);
+
+int vfs_getattr(struct path *path, struct kstat *stat)
+{
+	return vfs_getattr_mask(path, stat, STATX_BASIC_STATS,
+				AT_STATX_SYNC_AS_STAT);
+}
 
 EXPORT_SYMBOL(vfs_getattr);
 
@@ -68,27 +94,37 @@ int vfs_fstat(unsigned int fd, struct kstat *stat)
 }
 EXPORT_SYMBOL(vfs_fstat);
 
-int vfs_fstatat(int dfd, const char __user *filename, struct kstat *stat,
-		int flag)
+/**
+ * vfs_statx - Get basic and extra attributes by filename
+ * @dfd: A file descriptor representing the base dir for a relative filename
+ * @filename: The name of the file of interest
+ * @flags: Flags to control the query (AT_SYMLINK_NOFOLLOW, AT_STATX_xxx, ...)
+ * @stat: The result structure to fill in.
+ * @request_mask: STATX_xxx flags indicating what the caller wants
+ *
+ * Returns 0 on success or a negative error code.
+ */
+int vfs_statx(int dfd, const char __user *filename, int flags,
+	      struct kstat *stat, u32 request_mask)
 {
 	struct path path;
 	int error = -EINVAL;
 	unsigned int lookup_flags = 0;
 
-	if ((flag & ~(AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT |
-		      AT_EMPTY_PATH)) != 0)
+	if ((flags & ~(AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT |
+		       AT_EMPTY_PATH | KSTAT_QUERY_FLAGS)) != 0)
 		goto out;
 
-	if (!(flag & AT_SYMLINK_NOFOLLOW))
+	if (!(flags & AT_SYMLINK_NOFOLLOW))
 		lookup_flags |= LOOKUP_FOLLOW;
-	if (flag & AT_EMPTY_PATH)
+	if (flags & AT_EMPTY_PATH)
 		lookup_flags |= LOOKUP_EMPTY;
 retry:
 	error = user_path_at(dfd, filename, lookup_flags, &path);
 	if (error)
 		goto out;
 
-	error = vfs_getattr(&path, stat);
+	error = vfs_getattr_mask(&path, stat, request_mask, flags);
 	path_put(&path);
 	if (retry_estale(error, lookup_flags)) {
 		lookup_flags |= LOOKUP_REVAL;
@@ -97,6 +133,17 @@ retry:
 out:
 	return error;
 }
+EXPORT_SYMBOL(vfs_statx);
+
+int vfs_fstatat(int dfd, const char __user *filename, struct kstat *stat,
+		int flag)
+{
+	if ((flag & ~(AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT |
+		      AT_EMPTY_PATH)) != 0)
+		return -EINVAL;
+
+	return vfs_statx(dfd, filename, flag, stat, STATX_BASIC_STATS);
+}
 EXPORT_SYMBOL(vfs_fstatat);
 
 int vfs_stat(const char __user *name, struct kstat *stat)
@@ -426,6 +473,75 @@ SYSCALL_DEFINE4(fstatat64, int, dfd, const char __user *, filename,
 }
 #endif /* __ARCH_WANT_STAT64 || __ARCH_WANT_COMPAT_STAT64 */
 
+/* Convert @stat into the user-visible layout; @tmp must be zeroed. */
+void fill_statx(struct statx *tmp, const struct kstat *stat)
+{
+	tmp->stx_mask = stat->result_mask;
+	tmp->stx_blksize = stat->blksize;
+	tmp->stx_attributes = stat->attributes;
+	tmp->stx_nlink = stat->nlink;
+	tmp->stx_uid = from_kuid_munged(current_user_ns(), stat->uid);
+	tmp->stx_gid = from_kgid_munged(current_user_ns(), stat->gid);
+	tmp->stx_mode = stat->mode;
+	tmp->stx_ino = stat->ino;
+	tmp->stx_size = stat->size;
+	tmp->stx_blocks = stat->blocks;
+	tmp->stx_attributes_mask = stat->attributes_mask;
+	tmp->stx_atime.tv_sec = stat->atime.tv_sec;
+	tmp->stx_atime.tv_nsec = stat->atime.tv_nsec;
+	tmp->stx_btime.tv_sec = stat->btime.tv_sec;
+	tmp->stx_btime.tv_nsec = stat->btime.tv_nsec;
+	tmp->stx_ctime.tv_sec = stat->ctime.tv_sec;
+	tmp->stx_ctime.tv_nsec = stat->ctime.tv_nsec;
+	tmp->stx_mtime.tv_sec = stat->mtime.tv_sec;
+	tmp->stx_mtime.tv_nsec = stat->mtime.tv_nsec;
+	tmp->stx_rdev_major = MAJOR(stat->rdev);
+	tmp->stx_rdev_minor = MINOR(stat->rdev);
+	tmp->stx_dev_major = MAJOR(stat->dev);
+	tmp->stx_dev_minor = MINOR(stat->dev);
+}
+
+static int cp_statx(const struct kstat *stat, struct statx __user *buffer)
+{
+	struct statx tmp;
+
+	memset(&tmp, 0, sizeof(tmp));
+	fill_statx(&tmp, stat);
+
+	return copy_to_user(buffer, &tmp, sizeof(tmp)) ? -EFAULT : 0;
+}
+
+/**
+ * sys_statx - System call to get enhanced stats
+ * @dfd: Base directory to pathwalk from *or* fd to stat.
+ * @filename: File to stat or "" with AT_EMPTY_PATH
+ * @flags: AT_* flags to control pathwalk.
+ * @mask: Parts of statx struct actually required.
+ * @buffer: Result buffer.
+ *
+ * Note that fstat() can be emulated by setting dfd to the fd of interest,
+ * supplying "" as the filename and setting AT_EMPTY_PATH in the flags.
+ */
+SYSCALL_DEFINE5(statx,
+		int, dfd, const char __user *, filename, unsigned, flags,
+		unsigned int, mask,
+		struct statx __user *, buffer)
+{
+	struct kstat stat;
+	int error;
+
+	if (mask & STATX__RESERVED)
+		return -EINVAL;
+	if ((flags & AT_STATX_SYNC_TYPE) == AT_STATX_SYNC_TYPE)
+		return -EINVAL;
+
+	error = vfs_statx(dfd, filename, flags, &stat, mask);
+	if (error)
+		return error;
+
+	return cp_statx(&stat, buffer);
+}
+
 /* Caller is here responsible for sufficient locking (ie. inode->i_lock) */
 void __inode_add_bytes(struct inode *inode, loff_t bytes)
 {
@@ -13,6 +13,32 @@ extern u32  crc32_be(u32 crc, unsigned char const *p, size_t len);
 
 extern u32  __crc32c_le(u32 crc, unsigned char const *p, size_t len);
 
+/*
+ * An architecture with CRC instructions selects ARCH_HAS_CRC32 and
+ * provides crc32_arch_enabled(), crc32_le_arch() and __crc32c_le_arch();
+ * crc32_le() and __crc32c_le() use those once crc32_arch_enabled()
+ * says the running cpu can.
+ */
+#ifdef CONFIG_ARCH_HAS_CRC32
+#include <asm/crc32.h>
+#else
+static inline bool crc32_arch_enabled(void)
+{
+	return false;
+}
+
+static inline u32 crc32_le_arch(u32 crc, unsigned char const *p, size_t len)
+{
+	return crc;
+}
+
+static inline u32 __crc32c_le_arch(u32 crc, unsigned char const *p,
+				   size_t len)
+{
+	return crc;
+}
+#endif
+
 #define crc32(seed, data, length)  crc32_le(seed, (unsigned char const *)(data), length)
 
 /*
@@ -68,4 +68,17 @@ static inline void exit_pi_state_list(struct task_struct *curr)
 {
 }
 #endif
+
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+extern int futex_hash_prctl(unsigned long arg2, unsigned long arg3);
+extern void futex_mm_release(struct mm_struct *mm);
+#else
+static inline int futex_hash_prctl(unsigned long arg2, unsigned long arg3)
+{
+	return -EINVAL;
+}
+static inline void futex_mm_release(struct mm_struct *mm)
+{
+}
+#endif
 #endif
@@ -0,0 +1,40 @@
+/*
+ * Lightweight lock contention profiling, see kernel/lock_profile.c.
+ *
+ * Files that use LOCK_CONTENDED() and want it profiled define
+ * LOCK_PROFILE_HOOKS before their first include and include this
+ * header after the others.
+ */
+#ifndef __LINUX_LOCK_PROFILE_H
+#define __LINUX_LOCK_PROFILE_H
+
+#include <linux/types.h>
+#include <linux/lockdep.h>
+
+#ifdef CONFIG_LOCK_PROFILE
+
+static inline bool lock_profile_active(void)
+{
+	return static_key_false(&lock_profile_key);
+}
+
+#else /* CONFIG_LOCK_PROFILE */
+
+static inline bool lock_profile_active(void)
+{
+	return false;
+}
+
+static inline u64 lock_profile_clock(void)
+{
+	return 0;
+}
+
+static inline void lock_profile_contended(const char *type, void *lock,
+					  unsigned long ip, u64 start)
+{
+}
+
+#endif /* CONFIG_LOCK_PROFILE */
+
+#endif /* __LINUX_LOCK_PROFILE_H */
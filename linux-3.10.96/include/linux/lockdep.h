@@ -418,6 +418,16 @@ struct lock_class_key { };
 
 #endif /* !LOCKDEP */
 
+#ifdef CONFIG_LOCK_PROFILE
+#include <linux/jump_label.h>
+
+/* Lock contention profiler, see kernel/lock_profile.c */
+extern struct static_key lock_profile_key;
+extern u64 lock_profile_clock(void);
+extern void lock_profile_contended(const char *type, void *lock,
+				   unsigned long ip, u64 start);
+#endif
+
 #ifdef CONFIG_LOCK_STAT
 
 extern void lock_contended(struct lockdep_map *lock, unsigned long ip);
@@ -437,9 +447,32 @@ do {								\
 #define lock_contended(lockdep_map, ip) do {} while (0)
 #define lock_acquired(lockdep_map, ip) do {} while (0)
 
+#if defined(CONFIG_LOCK_PROFILE) && defined(LOCK_PROFILE_HOOKS)
+
+/*
+ * The contention profiler hooks the out-of-line lock functions, which
+ * define LOCK_PROFILE_HOOKS before their includes.
+ */
+#define LOCK_CONTENDED(_lock, try, lock)				\
+do {									\
+	if (!static_key_false(&lock_profile_key)) {			\
+		lock(_lock);						\
+	} else if (!try(_lock)) {					\
+		u64 __lp_start = lock_profile_clock();			\
+									\
+		lock(_lock);						\
+		lock_profile_contended(#lock, (_lock), _RET_IP_,	\
+				       __lp_start);			\
+	}								\
+} while (0)
+
+#else
+
 #define LOCK_CONTENDED(_lock, try, lock) \
 	lock(_lock)
 
+#endif
+
 #endif /* CONFIG_LOCK_STAT */
 
 #ifdef CONFIG_LOCKDEP
@@ -452,6 +485,21 @@ do {								\
 #define LOCK_CONTENDED_FLAGS(_lock, try, lock, lockfl, flags) \
 	LOCK_CONTENDED((_lock), (try), (lock))
 
+#elif defined(CONFIG_LOCK_PROFILE) && defined(LOCK_PROFILE_HOOKS)
+
+#define LOCK_CONTENDED_FLAGS(_lock, try, lock, lockfl, flags)		\
+do {									\
+	if (!static_key_false(&lock_profile_key)) {			\
+		lockfl((_lock), (flags));				\
+	} else if (!try(_lock)) {					\
+		u64 __lp_start = lock_profile_clock();			\
+									\
+		lockfl((_lock), (flags));				\
+		lock_profile_contended(#lock, (_lock), _RET_IP_,	\
+				       __lp_start);			\
+	}								\
+} while (0)
+
 #else /* CONFIG_LOCKDEP */
 
 #define LOCK_CONTENDED_FLAGS(_lock, try, lock, lockfl, flags) \
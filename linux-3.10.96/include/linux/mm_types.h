@@ -22,6 +22,7 @@
 #define AT_VECTOR_SIZE (2*(AT_VECTOR_SIZE_ARCH + AT_VECTOR_SIZE_BASE + 1))
 
 struct address_space;
+struct futex_hash_bucket;
 
 #define USE_SPLIT_PTLOCKS	(NR_CPUS >= CONFIG_SPLIT_PTLOCK_CPUS)
 
@@ -512,6 +513,11 @@ struct mm_struct {
 	 * PROT_NONE or PROT_NUMA mapped page.
 	 */
 	bool tlb_flush_pending;
+#endif
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+	/* private hash for PROCESS_PRIVATE futexes, see prctl(PR_FUTEX_HASH) */
+	struct futex_hash_bucket *futex_phash;
+	unsigned long futex_phash_slots;
 #endif
 	struct uprobes_state uprobes_state;
 };
@@ -1011,8 +1011,10 @@ static inline notrace void rcu_read_unlock_sched_notrace(void)
 
 #ifdef CONFIG_RCU_NOCB_CPU
 extern bool rcu_is_nocb_cpu(int cpu);
+extern void rcu_nocb_offload_cpus(const struct cpumask *mask);
 #else
 static inline bool rcu_is_nocb_cpu(int cpu) { return false; }
+static inline void rcu_nocb_offload_cpus(const struct cpumask *mask) { }
 #endif /* #else #ifdef CONFIG_RCU_NOCB_CPU */
 
 
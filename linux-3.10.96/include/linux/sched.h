@@ -799,6 +799,22 @@ extern int sched_domain_level_max;
 
 struct sched_group;
 
+/*
+ * State shared by all CPUs of a last-level-cache domain. idle_cores holds
+ * CPUs whose SMT siblings were all idle when they last entered idle; stale
+ * entries are cleared lazily by the wakeup path when it finds a busy
+ * sibling, so the idle entry path only ever sets bits.
+ */
+struct sched_domain_shared {
+	atomic_t	ref;
+	unsigned long	idle_cores[0];
+};
+
+static inline struct cpumask *sds_idle_cores(struct sched_domain_shared *sds)
+{
+	return to_cpumask(sds->idle_cores);
+}
+
 struct sched_domain {
 	/* These fields must be setup */
 	struct sched_domain *parent;	/* top domain must be null terminated */
@@ -827,6 +843,9 @@ struct sched_domain {
 
 	u64 last_update;
 
+	/* idle cpu search cost, see select_idle_cpu() */
+	u64 avg_scan_cost;
+
 #ifdef CONFIG_SCHEDSTATS
 	/* load_balance() stats */
 	unsigned int lb_count[CPU_MAX_IDLE_TYPES];
@@ -865,6 +884,7 @@ struct sched_domain {
 		void *private;		/* used during construction */
 		struct rcu_head rcu;	/* used during destruction */
 	};
+	struct sched_domain_shared *shared;
 
 	unsigned int span_weight;
 	/*
@@ -972,6 +992,9 @@ struct sched_statistics {
 	u64			nr_wakeups_affine_attempts;
 	u64			nr_wakeups_passive;
 	u64			nr_wakeups_idle;
+
+	/* set at wakeup, consumed when the task next gets a cpu */
+	u64			wakeup_start;
 };
 #endif
 /* һʵ(һ)һһָḶ̌һԼжУ
@@ -1039,6 +1062,48 @@ struct sched_rt_entity {
 #endif
 };
 
+struct sched_dl_entity {
+	struct rb_node	rb_node;
+
+	/*
+	 * Original scheduling parameters. Copied here from sched_attr
+	 * during sched_setattr(), they will remain the same until
+	 * the next sched_setattr().
+	 */
+	u64 dl_runtime;		/* maximum runtime for each instance	*/
+	u64 dl_deadline;	/* relative deadline of each instance	*/
+	u64 dl_period;		/* separation of two instances (period) */
+	u64 dl_bw;		/* dl_runtime / dl_deadline		*/
+
+	/*
+	 * Actual scheduling parameters. Initialized with the values above,
+	 * they are continously updated during task execution. Note that
+	 * the remaining runtime could be < 0 in case we are in overrun.
+	 */
+	s64 runtime;		/* remaining runtime for this instance	*/
+	u64 deadline;		/* absolute deadline for this instance	*/
+	unsigned int flags;	/* specifying the scheduler behaviour	*/
+
+	/*
+	 * Some bool flags:
+	 *
+	 * @dl_throttled tells if we exhausted the runtime. If so, the
+	 * task has to wait for a replenishment to be performed at the
+	 * next firing of dl_timer.
+	 *
+	 * @dl_new tells if a new instance arrived. If so we must
+	 * start executing it with full runtime and reset its absolute
+	 * deadline;
+	 */
+	int dl_throttled, dl_new;
+
+	/*
+	 * Bandwidth enforcement timer. Each -deadline task has its
+	 * own bandwidth to be enforced, thus we need one timer per task.
+	 */
+	struct hrtimer dl_timer;
+};
+
 
 struct rcu_node;
 
@@ -1074,6 +1139,12 @@ struct task_struct {
 	const struct sched_class *sched_class;//
 	struct sched_entity se;//Ӧcfsʵ
 	struct sched_rt_entity rt;//
+	struct sched_dl_entity dl;
+#ifdef CONFIG_SCHED_CORE
+	struct rb_node core_node;
+	unsigned long core_cookie;	/* effective cookie: task's or group's */
+	unsigned long core_task_cookie;	/* set through prctl(PR_SCHED_CORE) */
+#endif
 #ifdef CONFIG_CGROUP_SCHED
 	struct task_group *sched_task_group;//ڽ
 #endif
@@ -1119,6 +1190,7 @@ struct task_struct {
 	struct list_head tasks;
 #ifdef CONFIG_SMP
 	struct plist_node pushable_tasks;
+	struct rb_node pushable_dl_tasks;
 #endif
 
 	struct mm_struct *mm, *active_mm;
@@ -1943,6 +2015,8 @@ extern int sched_setscheduler(struct task_struct *, int,
 			      const struct sched_param *);
 extern int sched_setscheduler_nocheck(struct task_struct *, int,
 				      const struct sched_param *);
+extern int sched_setattr(struct task_struct *,
+			 const struct sched_attr *);
 extern struct task_struct *idle_task(int cpu);
 /**
  * is_idle_task - is the specified task an idle task?
@@ -2022,9 +2096,22 @@ extern void wake_up_new_task(struct task_struct *tsk);
 #else
  static inline void kick_process(struct task_struct *tsk) { }
 #endif
-extern void sched_fork(struct task_struct *p);
+extern int sched_fork(struct task_struct *p);
 extern void sched_dead(struct task_struct *p);
 
+#ifdef CONFIG_SCHED_CORE
+extern void sched_core_free(struct task_struct *p);
+extern int sched_core_share_pid(unsigned int cmd, pid_t pid, int scope,
+				unsigned long uaddr);
+#else
+static inline void sched_core_free(struct task_struct *p) { }
+static inline int sched_core_share_pid(unsigned int cmd, pid_t pid, int scope,
+				       unsigned long uaddr)
+{
+	return -EINVAL;
+}
+#endif
+
 extern void proc_caches_init(void);
 extern void flush_signals(struct task_struct *);
 extern void __flush_signals(struct task_struct *);
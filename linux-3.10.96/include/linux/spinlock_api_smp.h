@@ -116,7 +116,8 @@ static inline unsigned long __raw_spin_lock_irqsave(raw_spinlock_t *lock)
 #ifdef CONFIG_LOCKDEP
 	LOCK_CONTENDED(lock, do_raw_spin_trylock, do_raw_spin_lock);
 #else
-	do_raw_spin_lock_flags(lock, &flags);
+	LOCK_CONTENDED_FLAGS(lock, do_raw_spin_trylock, do_raw_spin_lock,
+			     do_raw_spin_lock_flags, &flags);
 #endif
 	return flags;
 }
@@ -18,7 +18,19 @@
 #include <linux/time.h>
 #include <linux/uidgid.h>
 
+#define KSTAT_QUERY_FLAGS (AT_STATX_SYNC_TYPE)
+
+/*
+ * request_mask and query_flags are filled in by the VFS before calling
+ * ->getattr(); a filesystem may use them to skip fetching attributes the
+ * caller did not ask for, and reports what it did fill in in result_mask.
+ */
 struct kstat {
+	u32		request_mask;	/* STATX_* the caller wants */
+	unsigned int	query_flags;	/* AT_STATX_* sync mode */
+	u32		result_mask;	/* What fields the user got */
+	u64		attributes;	/* STATX_ATTR_* flags */
+	u64		attributes_mask; /* STATX_ATTR_* flags supported */
 	u64		ino;
 	dev_t		dev;
 	umode_t		mode;
@@ -30,6 +42,7 @@ struct kstat {
 	struct timespec  atime;
 	struct timespec	mtime;
 	struct timespec	ctime;
+	struct timespec	btime;		/* File creation time */
 	unsigned long	blksize;
 	unsigned long long	blocks;
 };
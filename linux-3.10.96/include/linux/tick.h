@@ -131,6 +131,11 @@ static inline int tick_nohz_tick_stopped(void)
 	return __this_cpu_read(tick_cpu_sched.tick_stopped);
 }
 
+static inline int tick_nohz_tick_stopped_cpu(int cpu)
+{
+	return per_cpu(tick_cpu_sched, cpu).tick_stopped;
+}
+
 extern void tick_nohz_idle_enter(void);
 extern void tick_nohz_idle_exit(void);
 extern void tick_nohz_irq_exit(void);
@@ -144,6 +149,11 @@ static inline int tick_nohz_tick_stopped(void)
 	return 0;
 }
 
+static inline int tick_nohz_tick_stopped_cpu(int cpu)
+{
+	return 0;
+}
+
 static inline void tick_nohz_idle_enter(void) { }
 static inline void tick_nohz_idle_exit(void) { }
 
@@ -158,12 +168,39 @@ static inline u64 get_cpu_iowait_time_us(int cpu, u64 *unused) { return -1; }
 # endif /* !CONFIG_NO_HZ_COMMON */
 
 #ifdef CONFIG_NO_HZ_FULL
+extern bool have_nohz_full_mask;
+extern cpumask_var_t housekeeping_mask;
+
 extern void tick_nohz_init(void);
 extern int tick_nohz_full_cpu(int cpu);
 extern void tick_nohz_full_check(void);
 extern void tick_nohz_full_kick(void);
 extern void tick_nohz_full_kick_all(void);
 extern void tick_nohz_task_switch(struct task_struct *tsk);
+
+/*
+ * Housekeeping CPUs are the ones outside the nohz_full range: they take
+ * over the unbound work, timers and kthreads the full dynticks CPUs are
+ * spared from.
+ */
+static inline const struct cpumask *housekeeping_cpumask(void)
+{
+	if (have_nohz_full_mask)
+		return housekeeping_mask;
+	return cpu_possible_mask;
+}
+
+static inline int housekeeping_any_cpu(void)
+{
+	if (have_nohz_full_mask)
+		return cpumask_any_and(housekeeping_mask, cpu_online_mask);
+	return smp_processor_id();
+}
+
+static inline bool is_housekeeping_cpu(int cpu)
+{
+	return !tick_nohz_full_cpu(cpu);
+}
 #else
 static inline void tick_nohz_init(void) { }
 static inline int tick_nohz_full_cpu(int cpu) { return 0; }
@@ -171,6 +208,18 @@ static inline void tick_nohz_full_check(void) { }
 static inline void tick_nohz_full_kick(void) { }
 static inline void tick_nohz_full_kick_all(void) { }
 static inline void tick_nohz_task_switch(struct task_struct *tsk) { }
+
+static inline const struct cpumask *housekeeping_cpumask(void)
+{
+	return cpu_possible_mask;
+}
+
+static inline int housekeeping_any_cpu(void)
+{
+	return smp_processor_id();
+}
+
+static inline bool is_housekeeping_cpu(int cpu) { return true; }
 #endif
 
 
@@ -29,6 +29,7 @@
 
 struct vm_area_struct;
 struct mm_struct;
+struct page;
 struct inode;
 
 #ifdef CONFIG_ARCH_SUPPORTS_UPROBES
@@ -125,6 +126,8 @@ extern void uprobe_notify_resume(struct pt_regs *regs);
 extern bool uprobe_deny_signal(void);
 extern bool __weak arch_uprobe_skip_sstep(struct arch_uprobe *aup, struct pt_regs *regs);
 extern void uprobe_clear_state(struct mm_struct *mm);
+extern void __weak arch_uprobe_copy_ixol(struct page *page, unsigned long vaddr,
+					 void *src, unsigned long len);
 #else /* !CONFIG_UPROBES */
 struct uprobes_state {
 };
@@ -692,9 +692,28 @@ __SC_COMP(__NR_process_vm_writev, sys_process_vm_writev, \
 __SYSCALL(__NR_kcmp, sys_kcmp)
 #define __NR_finit_module 273
 __SYSCALL(__NR_finit_module, sys_finit_module)
+#define __NR_sched_setattr 274
+__SYSCALL(__NR_sched_setattr, sys_sched_setattr)
+#define __NR_sched_getattr 275
+__SYSCALL(__NR_sched_getattr, sys_sched_getattr)
+/*
+ * 276-290 (renameat2 ... pkey_free) are allocated upstream but not
+ * implemented here.  They are left to sys_ni_syscall so that libcs built
+ * against newer headers get -ENOSYS and fall back.
+ */
+#define __NR_statx 291
+__SYSCALL(__NR_statx, sys_statx)
+
+/*
+ * getdents_statx is not an upstream syscall.  Keep it well clear of the
+ * range upstream allocates from (and below the deprecated calls at 1024)
+ * so a future upstream number can never alias it.
+ */
+#define __NR_getdents_statx 1000
+__SYSCALL(__NR_getdents_statx, sys_getdents_statx)
 
 #undef __NR_syscalls
-#define __NR_syscalls 274
+#define __NR_syscalls 1001
 
 /*
  * All syscalls below here should go away really,
@@ -149,4 +149,29 @@
 
 #define PR_GET_TID_ADDRESS	40
 
+/*
+ * Core scheduling: tasks only share an SMT core with tasks carrying the
+ * same cookie.  arg3 is the pid, arg4 the scope it applies to, and for
+ * PR_SCHED_CORE_GET arg5 points to an unsigned long receiving an opaque
+ * identifier of the cookie (0 if none).
+ */
+#define PR_SCHED_CORE			62
+# define PR_SCHED_CORE_GET		0
+# define PR_SCHED_CORE_CREATE		1 /* create unique core_sched cookie */
+# define PR_SCHED_CORE_SHARE_TO		2 /* push core_sched cookie to pid */
+# define PR_SCHED_CORE_SHARE_FROM	3 /* pull core_sched cookie from pid */
+# define PR_SCHED_CORE_MAX		4
+# define PR_SCHED_CORE_SCOPE_THREAD		0
+# define PR_SCHED_CORE_SCOPE_THREAD_GROUP	1
+# define PR_SCHED_CORE_SCOPE_PROCESS_GROUP	2
+
+/*
+ * Set up / query a private hash table for the PROCESS_PRIVATE futexes
+ * of the calling process. The table size must be a power of two and can
+ * only be set while the process is single threaded.
+ */
+#define PR_FUTEX_HASH			78
+# define PR_FUTEX_HASH_SET_SLOTS	1
+# define PR_FUTEX_HASH_GET_SLOTS	2
+
 #endif /* _LINUX_PRCTL_H */
@@ -62,6 +62,12 @@
 #include <linux/ptrace.h>
 #include <linux/sched/rt.h>
 #include <linux/hugetlb.h>
+#include <linux/bootmem.h>
+#include <linux/vmalloc.h>
+#include <linux/log2.h>
+#include <linux/prctl.h>
+#include <linux/workqueue.h>
+#include <linux/moduleparam.h>
 
 #include <asm/futex.h>
 
@@ -71,8 +77,6 @@
 int __read_mostly futex_cmpxchg_enabled;
 #endif
 
-#define FUTEX_HASHBITS (CONFIG_BASE_SMALL ? 4 : 8)
-
 /*
  * Futex flags used to encode options to functions and preserve them across
  * restarts.
@@ -150,19 +154,46 @@ static const struct futex_q futex_q_init = {
 struct futex_hash_bucket {
 	spinlock_t lock;
 	struct plist_head chain;
-};
-
-static struct futex_hash_bucket futex_queues[1<<FUTEX_HASHBITS];
+} ____cacheline_aligned_in_smp;
 
 /*
- * We hash on the keys returned from get_futex_key (see below).
+ * The global hash table is sized at boot from the number of possible
+ * CPUs (see futex_init()), so that unrelated futexes on large machines
+ * do not keep colliding on the same bucket lock.
  */
-static struct futex_hash_bucket *hash_futex(union futex_key *key)
+static unsigned long __read_mostly futex_hashsize;
+static struct futex_hash_bucket *futex_queues __read_mostly;
+
+static inline struct futex_hash_bucket *
+__hash_futex(union futex_key *key, struct futex_hash_bucket *queues,
+	     unsigned long size)
 {
 	u32 hash = jhash2((u32*)&key->both.word,
 			  (sizeof(key->both.word)+sizeof(key->both.ptr))/4,
 			  key->both.offset);
-	return &futex_queues[hash & ((1 << FUTEX_HASHBITS)-1)];
+	return &queues[hash & (size - 1)];
+}
+
+/*
+ * We hash on the keys returned from get_futex_key (see below).
+ *
+ * PROCESS_PRIVATE keys of an mm that set up its own hash table via
+ * prctl(PR_FUTEX_HASH) go to that table, so that one process' lock
+ * storms never contend with another's. Everything else goes to the
+ * global table.
+ */
+static struct futex_hash_bucket *hash_futex(union futex_key *key)
+{
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+	if (!(key->both.offset & (FUT_OFF_INODE | FUT_OFF_MMSHARED))) {
+		struct mm_struct *mm = key->private.mm;
+
+		if (mm && mm->futex_phash)
+			return __hash_futex(key, mm->futex_phash,
+					    mm->futex_phash_slots);
+	}
+#endif
+	return __hash_futex(key, futex_queues, futex_hashsize);
 }
 
 /*
@@ -2884,17 +2915,322 @@ static void __init futex_detect_cmpxchg(void)
 #endif
 }
 
+static void futex_hash_init(struct futex_hash_bucket *queues,
+			    unsigned long size)
+{
+	unsigned long i;
+
+	for (i = 0; i < size; i++) {
+		plist_head_init(&queues[i].chain);
+		spin_lock_init(&queues[i].lock);
+	}
+}
+
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+static struct futex_hash_bucket *futex_hash_alloc(unsigned long slots)
+{
+	size_t size = slots * sizeof(struct futex_hash_bucket);
+	struct futex_hash_bucket *queues;
+
+	if (size <= PAGE_SIZE)
+		queues = kmalloc(size, GFP_KERNEL);
+	else
+		queues = vmalloc(size);
+	if (queues)
+		futex_hash_init(queues, slots);
+	return queues;
+}
+
+static void futex_hash_free(struct futex_hash_bucket *queues)
+{
+	if (is_vmalloc_addr(queues))
+		vfree(queues);
+	else
+		kfree(queues);
+}
+
+/*
+ * Install a private hash table for PROCESS_PRIVATE futexes of the
+ * current mm. The table can only be set up while the mm has a single
+ * user: there can't be any waiter queued in the global table for this
+ * mm then, so no futex_q is left behind in a table nobody looks at.
+ * Once installed the table is never replaced until the mm goes away.
+ */
+static int futex_hash_set_slots(unsigned long slots)
+{
+	struct mm_struct *mm = current->mm;
+	struct futex_hash_bucket *queues;
+
+	if (!mm)
+		return -EINVAL;
+	if (slots < 2 || slots > futex_hashsize || !is_power_of_2(slots))
+		return -EINVAL;
+	if (!current_is_single_threaded())
+		return -EBUSY;
+	if (mm->futex_phash)
+		return -EBUSY;
+
+	queues = futex_hash_alloc(slots);
+	if (!queues)
+		return -ENOMEM;
+
+	mm->futex_phash_slots = slots;
+	mm->futex_phash = queues;
+	return 0;
+}
+
+int futex_hash_prctl(unsigned long arg2, unsigned long arg3)
+{
+	struct mm_struct *mm = current->mm;
+
+	switch (arg2) {
+	case PR_FUTEX_HASH_SET_SLOTS:
+		return futex_hash_set_slots(arg3);
+	case PR_FUTEX_HASH_GET_SLOTS:
+		if (arg3)
+			return -EINVAL;
+		return (mm && mm->futex_phash) ? mm->futex_phash_slots : 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+/*
+ * Called from mmput() once the last user is gone: nobody can be
+ * hashing a private key of this mm anymore.
+ */
+void futex_mm_release(struct mm_struct *mm)
+{
+	if (mm->futex_phash) {
+		futex_hash_free(mm->futex_phash);
+		mm->futex_phash = NULL;
+		mm->futex_phash_slots = 0;
+	}
+}
+#endif /* CONFIG_FUTEX_PRIVATE_HASH */
+
 static int __init futex_init(void)
 {
-	int i;
+	unsigned int futex_shift;
+
+#if CONFIG_BASE_SMALL
+	futex_hashsize = 16;
+#else
+	futex_hashsize = roundup_pow_of_two(256 * num_possible_cpus());
+#endif
+
+	futex_queues = alloc_large_system_hash("futex", sizeof(*futex_queues),
+					       futex_hashsize, 0,
+					       futex_hashsize < 256 ? HASH_SMALL : 0,
+					       &futex_shift, NULL,
+					       futex_hashsize, futex_hashsize);
+	futex_hashsize = 1UL << futex_shift;
 
 	futex_detect_cmpxchg();
 
-	for (i = 0; i < ARRAY_SIZE(futex_queues); i++) {
-		plist_head_init(&futex_queues[i].chain);
-		spin_lock_init(&futex_queues[i].lock);
-	}
+	futex_hash_init(futex_queues, futex_hashsize);
 
 	return 0;
 }
 __initcall(futex_init);
+
+#ifdef CONFIG_FUTEX_HASH_BENCH
+/*
+ * Futex hash collision benchmark.
+ *
+ * Simulates bench_procs processes with bench_futexes PROCESS_PRIVATE
+ * futexes each, first hashed into the global table and then into one
+ * private table of bench_slots buckets per process, and reports:
+ *
+ *  - how many keys share their bucket with a key of another process,
+ *  - the longest bucket chain,
+ *  - the average cost of a queue/dequeue cycle under the bucket lock,
+ *    with every online CPU hammering its process' futexes at once.
+ *
+ * The keys are never dereferenced, so the fake mm pointers only need to
+ * be distinct and laid out like slab objects.
+ */
+static int bench_procs = 16;
+module_param(bench_procs, int, 0444);
+static int bench_futexes = 64;
+module_param(bench_futexes, int, 0444);
+static int bench_loops = 100000;
+module_param(bench_loops, int, 0444);
+static int bench_slots = 16;
+module_param(bench_slots, int, 0444);
+
+struct futex_bench {
+	union futex_key *keys;
+	struct futex_hash_bucket **tables;	/* per process, NULL: global */
+	unsigned long slots;
+	atomic_t nr_cpus;
+	atomic64_t total_ns;
+};
+
+/* schedule_on_each_cpu() work items can't carry an argument */
+static struct futex_bench *futex_bench_cur;
+
+static struct futex_hash_bucket *
+futex_bench_hash(struct futex_bench *fb, int proc, int nr)
+{
+	union futex_key *key = &fb->keys[proc * bench_futexes + nr];
+
+	if (fb->tables)
+		return __hash_futex(key, fb->tables[proc], fb->slots);
+	return __hash_futex(key, futex_queues, futex_hashsize);
+}
+
+static void futex_bench_collisions(struct futex_bench *fb, const char *name)
+{
+	int *owner, *count;
+	struct futex_hash_bucket *base;
+	unsigned long size, shared = 0, max = 0;
+	int proc, nr;
+
+	/* Private tables are per process: index all of them side by side. */
+	size = fb->tables ? fb->slots * bench_procs : futex_hashsize;
+	owner = vmalloc(size * sizeof(int));
+	count = vzalloc(size * sizeof(int));
+	if (!owner || !count)
+		goto out;
+	memset(owner, 0xff, size * sizeof(int));
+
+	for (proc = 0; proc < bench_procs; proc++) {
+		base = fb->tables ? fb->tables[proc] : futex_queues;
+		for (nr = 0; nr < bench_futexes; nr++) {
+			unsigned long idx = futex_bench_hash(fb, proc, nr) - base;
+
+			if (fb->tables)
+				idx += proc * fb->slots;
+			if (owner[idx] == -1)
+				owner[idx] = proc;
+			else if (owner[idx] != proc)
+				owner[idx] = -2;
+			if (++count[idx] > max)
+				max = count[idx];
+		}
+	}
+
+	for (proc = 0; proc < bench_procs; proc++) {
+		base = fb->tables ? fb->tables[proc] : futex_queues;
+		for (nr = 0; nr < bench_futexes; nr++) {
+			unsigned long idx = futex_bench_hash(fb, proc, nr) - base;
+
+			if (fb->tables)
+				idx += proc * fb->slots;
+			if (owner[idx] == -2)
+				shared++;
+		}
+	}
+
+	pr_info("futex bench [%s]: %d keys, %lu shared with another process, longest chain %lu\n",
+		name, bench_procs * bench_futexes, shared, max);
+out:
+	vfree(count);
+	vfree(owner);
+}
+
+static void futex_bench_work(struct work_struct *work)
+{
+	struct futex_bench *fb = futex_bench_cur;
+	int proc = raw_smp_processor_id() % bench_procs;
+	struct futex_hash_bucket *hb;
+	struct futex_q q = futex_q_init;
+	u64 start, ns = 0;
+	int i;
+
+	start = local_clock();
+	for (i = 0; i < bench_loops; i++) {
+		hb = futex_bench_hash(fb, proc, i % bench_futexes);
+		spin_lock(&hb->lock);
+		plist_node_init(&q.list, MAX_RT_PRIO);
+		plist_add(&q.list, &hb->chain);
+		plist_del(&q.list, &hb->chain);
+		spin_unlock(&hb->lock);
+		if (!(i & 1023)) {
+			/* don't count time spent letting others run */
+			ns += local_clock() - start;
+			cond_resched();
+			start = local_clock();
+		}
+	}
+	ns += local_clock() - start;
+	atomic64_add(ns, &fb->total_ns);
+	atomic_inc(&fb->nr_cpus);
+}
+
+static void futex_bench_run(struct futex_bench *fb, const char *name)
+{
+	int nr;
+
+	atomic_set(&fb->nr_cpus, 0);
+	atomic64_set(&fb->total_ns, 0);
+	futex_bench_cur = fb;
+	if (schedule_on_each_cpu(futex_bench_work))
+		return;
+
+	nr = atomic_read(&fb->nr_cpus);
+	if (nr)
+		pr_info("futex bench [%s]: %d cpus, %llu ns per queue/dequeue\n",
+			name, nr, div64_u64(atomic64_read(&fb->total_ns),
+					    (u64)nr * bench_loops));
+}
+
+static int __init futex_hash_bench(void)
+{
+	struct futex_bench fb = { };
+	char *mm_base;
+	int proc, nr;
+
+	if (bench_procs < 1 || bench_futexes < 1 || bench_loops < 1 ||
+	    bench_slots < 2 || !is_power_of_2(bench_slots))
+		return -EINVAL;
+
+	mm_base = kcalloc(bench_procs, L1_CACHE_BYTES, GFP_KERNEL);
+	fb.keys = vmalloc(bench_procs * bench_futexes * sizeof(*fb.keys));
+	if (!mm_base || !fb.keys)
+		goto out;
+
+	for (proc = 0; proc < bench_procs; proc++) {
+		for (nr = 0; nr < bench_futexes; nr++) {
+			union futex_key *key = &fb.keys[proc * bench_futexes + nr];
+			/* One futex per cacheline, as pthread mutexes tend to be. */
+			unsigned long address = 0x7f0000000000UL + nr * L1_CACHE_BYTES;
+
+			key->both.offset = address % PAGE_SIZE;
+			key->private.address = address - key->both.offset;
+			key->private.mm = (struct mm_struct *)
+					  (mm_base + proc * L1_CACHE_BYTES);
+		}
+	}
+
+	futex_bench_collisions(&fb, "global");
+	futex_bench_run(&fb, "global");
+
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+	fb.tables = kcalloc(bench_procs, sizeof(*fb.tables), GFP_KERNEL);
+	if (!fb.tables)
+		goto out;
+	fb.slots = bench_slots;
+	for (proc = 0; proc < bench_procs; proc++) {
+		fb.tables[proc] = futex_hash_alloc(bench_slots);
+		if (!fb.tables[proc])
+			goto out_free;
+	}
+
+	futex_bench_collisions(&fb, "private");
+	futex_bench_run(&fb, "private");
+
+out_free:
+	for (proc = 0; proc < bench_procs; proc++)
+		if (fb.tables[proc])
+			futex_hash_free(fb.tables[proc]);
+	kfree(fb.tables);
+#endif
+out:
+	vfree(fb.keys);
+	kfree(mm_base);
+	return 0;
+}
+late_initcall(futex_hash_bench);
+#endif /* CONFIG_FUTEX_HASH_BENCH */
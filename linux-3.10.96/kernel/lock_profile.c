@@ -0,0 +1,405 @@
+/*
+ * kernel/lock_profile.c
+ *
+ * Lightweight lock contention profiling.
+ *
+ * Unlike lock_stat this does not need lockdep.  When enabled, the
+ * contended slowpaths of spinlocks, rwlocks, rwsems, mutexes and
+ * rt_mutexes time their wait and account it to a per-cpu table keyed
+ * by lock type and acquiring callsite.  Each entry keeps the count,
+ * total and maximum wait and a log2 histogram of the wait times.  While
+ * disabled, the lock fastpaths only carry a static branch.
+ *
+ * Without lockdep there are no lock classes, so the last lock address
+ * seen at a callsite is kept as a hint; for static locks it resolves to
+ * a symbol.
+ *
+ * /sys/kernel/debug/lock_profile/enable	0/1 to stop/start profiling
+ * /sys/kernel/debug/lock_profile/stats		callsites by total wait,
+ *						write to reset
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/cpu.h>
+#include <linux/debugfs.h>
+#include <linux/export.h>
+#include <linux/hash.h>
+#include <linux/init.h>
+#include <linux/irqflags.h>
+#include <linux/kernel.h>
+#include <linux/lock_profile.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/vmalloc.h>
+
+#define LP_HASH_BITS	8
+#define LP_ENTRIES	(1 << LP_HASH_BITS)
+#define LP_MERGED_BITS	10
+#define LP_MERGED	(1 << LP_MERGED_BITS)
+
+/*
+ * Bucket 0 counts waits below 1us, bucket n waits of [2^(n-1), 2^n) us
+ * and the last bucket everything from 2^(LP_BUCKETS-2) us up.
+ */
+#define LP_BUCKETS	16
+
+struct lock_profile_entry {
+	unsigned long	ip;
+	const char	*type;
+	void		*lock;
+	unsigned long	count;
+	u64		total;
+	u64		max;
+	unsigned long	hist[LP_BUCKETS];
+};
+
+struct lock_profile_table {
+	struct lock_profile_entry entries[LP_ENTRIES];
+	unsigned long	dropped;
+};
+
+struct static_key lock_profile_key = STATIC_KEY_INIT_FALSE;
+EXPORT_SYMBOL(lock_profile_key);
+
+static DEFINE_PER_CPU(struct lock_profile_table *, lock_profile_tables);
+static DEFINE_MUTEX(lock_profile_mutex);
+static bool lock_profile_enabled;
+
+u64 lock_profile_clock(void)
+{
+	return local_clock();
+}
+EXPORT_SYMBOL(lock_profile_clock);
+
+static struct lock_profile_entry *
+lock_profile_find(struct lock_profile_entry *entries, int bits,
+		  unsigned long ip, const char *type)
+{
+	unsigned long mask = (1UL << bits) - 1;
+	unsigned long i = hash_long(ip ^ (unsigned long)type, bits);
+	unsigned long n;
+
+	for (n = 0; n <= mask; n++, i = (i + 1) & mask) {
+		struct lock_profile_entry *e = &entries[i];
+
+		if (!e->ip) {
+			/* pairs with the smp_rmb() in lock_profile_merge() */
+			e->type = type;
+			smp_wmb();
+			e->ip = ip;
+			return e;
+		}
+		if (e->ip == ip && e->type == type)
+			return e;
+	}
+
+	return NULL;
+}
+
+static int lock_profile_bucket(u64 wait)
+{
+	u64 us = div_u64(wait, NSEC_PER_USEC);
+
+	if (!us)
+		return 0;
+	return min_t(int, fls64(us), LP_BUCKETS - 1);
+}
+
+/*
+ * Called by the lock functions once a contended lock has been taken.
+ * Interrupts are disabled around the update, so the per-cpu table is
+ * never written concurrently; locks taken from NMI are not expected.
+ */
+void lock_profile_contended(const char *type, void *lock,
+			    unsigned long ip, u64 start)
+{
+	struct lock_profile_table *table;
+	struct lock_profile_entry *e;
+	unsigned long flags;
+	s64 wait;
+
+	wait = lock_profile_clock() - start;
+	if (wait < 0)
+		wait = 0;
+
+	local_irq_save(flags);
+	table = __this_cpu_read(lock_profile_tables);
+	if (!table)
+		goto out;
+
+	e = lock_profile_find(table->entries, LP_HASH_BITS, ip, type);
+	if (!e) {
+		table->dropped++;
+		goto out;
+	}
+
+	e->lock = lock;
+	e->count++;
+	e->total += wait;
+	if (wait > e->max)
+		e->max = wait;
+	e->hist[lock_profile_bucket(wait)]++;
+out:
+	local_irq_restore(flags);
+}
+EXPORT_SYMBOL(lock_profile_contended);
+
+static int lock_profile_alloc_tables(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct lock_profile_table *table;
+
+		if (per_cpu(lock_profile_tables, cpu))
+			continue;
+		table = vzalloc_node(sizeof(*table), cpu_to_node(cpu));
+		if (!table)
+			return -ENOMEM;
+		per_cpu(lock_profile_tables, cpu) = table;
+	}
+
+	return 0;
+}
+
+static void lock_profile_reset_cpu(void *unused)
+{
+	struct lock_profile_table *table = __this_cpu_read(lock_profile_tables);
+
+	if (table)
+		memset(table, 0, sizeof(*table));
+}
+
+/*
+ * Recorders update their table with interrupts off, so clearing each
+ * online cpu's table from an IPI cannot race with them.
+ */
+static void lock_profile_reset(void)
+{
+	int cpu;
+
+	get_online_cpus();
+	on_each_cpu(lock_profile_reset_cpu, NULL, 1);
+	for_each_possible_cpu(cpu) {
+		struct lock_profile_table *table;
+
+		table = per_cpu(lock_profile_tables, cpu);
+		if (!cpu_online(cpu) && table)
+			memset(table, 0, sizeof(*table));
+	}
+	put_online_cpus();
+}
+
+static int lock_profile_enable_get(void *data, u64 *val)
+{
+	*val = lock_profile_enabled;
+	return 0;
+}
+
+static int lock_profile_enable_set(void *data, u64 val)
+{
+	int ret = 0;
+
+	mutex_lock(&lock_profile_mutex);
+	if (val && !lock_profile_enabled) {
+		ret = lock_profile_alloc_tables();
+		if (!ret) {
+			lock_profile_enabled = true;
+			static_key_slow_inc(&lock_profile_key);
+		}
+	} else if (!val && lock_profile_enabled) {
+		lock_profile_enabled = false;
+		static_key_slow_dec(&lock_profile_key);
+	}
+	mutex_unlock(&lock_profile_mutex);
+
+	return ret;
+}
+
+DEFINE_SIMPLE_ATTRIBUTE(lock_profile_enable_fops, lock_profile_enable_get,
+			lock_profile_enable_set, "%llu\n");
+
+struct lock_profile_snapshot {
+	struct lock_profile_entry entries[LP_MERGED];
+	struct lock_profile_entry *sorted[LP_MERGED];
+	int nr;
+	unsigned long dropped;
+};
+
+static int lock_profile_cmp(const void *a, const void *b)
+{
+	const struct lock_profile_entry *ea = *(struct lock_profile_entry **)a;
+	const struct lock_profile_entry *eb = *(struct lock_profile_entry **)b;
+
+	if (ea->total == eb->total)
+		return 0;
+	return ea->total < eb->total ? 1 : -1;
+}
+
+/*
+ * Fold the per-cpu tables into one and sort it by total wait.  The
+ * tables are read without stopping the recorders, so an entry may be
+ * caught half updated; that is fine for statistics.
+ */
+static void lock_profile_merge(struct lock_profile_snapshot *snap)
+{
+	int cpu, i, b;
+
+	for_each_possible_cpu(cpu) {
+		struct lock_profile_table *table;
+
+		table = per_cpu(lock_profile_tables, cpu);
+		if (!table)
+			continue;
+
+		snap->dropped += ACCESS_ONCE(table->dropped);
+		for (i = 0; i < LP_ENTRIES; i++) {
+			struct lock_profile_entry *src = &table->entries[i];
+			struct lock_profile_entry *dst;
+			unsigned long ip = ACCESS_ONCE(src->ip);
+			const char *type;
+
+			if (!ip)
+				continue;
+			smp_rmb();
+			/* NULL if the table was reset under us */
+			type = ACCESS_ONCE(src->type);
+			if (!type)
+				continue;
+			dst = lock_profile_find(snap->entries, LP_MERGED_BITS,
+						ip, type);
+			if (!dst) {
+				snap->dropped += src->count;
+				continue;
+			}
+			dst->lock = src->lock;
+			dst->count += src->count;
+			dst->total += src->total;
+			dst->max = max(dst->max, src->max);
+			for (b = 0; b < LP_BUCKETS; b++)
+				dst->hist[b] += src->hist[b];
+		}
+	}
+
+	for (i = 0; i < LP_MERGED; i++)
+		if (snap->entries[i].ip && snap->entries[i].count)
+			snap->sorted[snap->nr++] = &snap->entries[i];
+	sort(snap->sorted, snap->nr, sizeof(snap->sorted[0]),
+	     lock_profile_cmp, NULL);
+}
+
+/* "do_raw_spin_lock" -> "spin_lock", "__down_read" -> "down_read" */
+static const char *lock_profile_type_name(const char *type)
+{
+	if (!strncmp(type, "do_raw_", 7))
+		return type + 7;
+	while (*type == '_')
+		type++;
+	return type;
+}
+
+static int lock_profile_stats_show(struct seq_file *m, void *v)
+{
+	struct lock_profile_snapshot *snap = m->private;
+	int i, b;
+
+	seq_printf(m, "# times in us, histogram buckets <1us, <2us, <4us ... >=%dus\n",
+		   1 << (LP_BUCKETS - 2));
+	seq_printf(m, "# %-14s %10s %12s %10s %10s  callsite (lock)\n",
+		   "type", "count", "total", "max", "avg");
+
+	for (i = 0; i < snap->nr; i++) {
+		struct lock_profile_entry *e = snap->sorted[i];
+
+		seq_printf(m, "%-16s %10lu %12llu %10llu %10llu  %pS (%pS)\n",
+			   lock_profile_type_name(e->type), e->count,
+			   div_u64(e->total, NSEC_PER_USEC),
+			   div_u64(e->max, NSEC_PER_USEC),
+			   div_u64(div_u64(e->total, e->count), NSEC_PER_USEC),
+			   (void *)e->ip, e->lock);
+		seq_puts(m, " ");
+		for (b = 0; b < LP_BUCKETS; b++)
+			seq_printf(m, " %lu", e->hist[b]);
+		seq_putc(m, '\n');
+	}
+
+	if (snap->dropped)
+		seq_printf(m, "# %lu contentions dropped, table full\n",
+			   snap->dropped);
+
+	return 0;
+}
+
+static int lock_profile_stats_open(struct inode *inode, struct file *file)
+{
+	struct lock_profile_snapshot *snap;
+	int ret;
+
+	snap = vzalloc(sizeof(*snap));
+	if (!snap)
+		return -ENOMEM;
+
+	mutex_lock(&lock_profile_mutex);
+	lock_profile_merge(snap);
+	mutex_unlock(&lock_profile_mutex);
+
+	ret = single_open(file, lock_profile_stats_show, snap);
+	if (ret)
+		vfree(snap);
+	return ret;
+}
+
+static int lock_profile_stats_release(struct inode *inode, struct file *file)
+{
+	struct seq_file *m = file->private_data;
+
+	vfree(m->private);
+	return single_release(inode, file);
+}
+
+static ssize_t lock_profile_stats_write(struct file *file,
+					const char __user *buf,
+					size_t count, loff_t *ppos)
+{
+	mutex_lock(&lock_profile_mutex);
+	lock_profile_reset();
+	mutex_unlock(&lock_profile_mutex);
+
+	return count;
+}
+
+static const struct file_operations lock_profile_stats_fops = {
+	.owner		= THIS_MODULE,
+	.open		= lock_profile_stats_open,
+	.read		= seq_read,
+	.write		= lock_profile_stats_write,
+	.llseek		= seq_lseek,
+	.release	= lock_profile_stats_release,
+};
+
+static int __init lock_profile_init(void)
+{
+	struct dentry *dir;
+
+	dir = debugfs_create_dir("lock_profile", NULL);
+	if (!dir)
+		return -ENOMEM;
+
+	if (!debugfs_create_file("enable", 0600, dir, NULL,
+				 &lock_profile_enable_fops) ||
+	    !debugfs_create_file("stats", 0600, dir, NULL,
+				 &lock_profile_stats_fops)) {
+		debugfs_remove_recursive(dir);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+late_initcall(lock_profile_init);
@@ -0,0 +1,584 @@
+/*
+ * Module-based torture test facility for locking
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Modelled on kernel/rcutorture.c.
+ *
+ * Writer (and, for reader-writer locks, reader) kthreads hammer on one
+ * lock of the selected type. Besides checking mutual exclusion, every
+ * thread counts its acquisitions so that the throughput of a lock
+ * implementation can be compared as the number of contenders grows:
+ * load the module several times with increasing nwriters_stress.
+ */
+#include <linux/types.h>
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/kthread.h>
+#include <linux/err.h>
+#include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <linux/rwsem.h>
+#include <linux/smp.h>
+#include <linux/interrupt.h>
+#include <linux/sched.h>
+#include <linux/atomic.h>
+#include <linux/moduleparam.h>
+#include <linux/delay.h>
+#include <linux/slab.h>
+#include <linux/random.h>
+#include <linux/jiffies.h>
+#include <linux/math64.h>
+#include <linux/cpu.h>
+
+MODULE_LICENSE("GPL");
+
+static int nwriters_stress = -1; /* # writer threads, defaults to 2*ncpus */
+static int nreaders_stress = -1; /* # reader threads, defaults to nwriters */
+static int stat_interval = 60;	/* Interval between stats, in seconds. */
+				/*  Zero means "only at end of test". */
+static int hold_delay_ns;		/* Extra critical section length (ns). */
+static bool cpu_bind;		/* Bind each writer to its own CPU. */
+static bool verbose;		/* Print more debug info. */
+static char *torture_type = "spin_lock"; /* What lock to torture. */
+
+module_param(nwriters_stress, int, 0444);
+MODULE_PARM_DESC(nwriters_stress, "Number of write-locking stress-test threads");
+module_param(nreaders_stress, int, 0444);
+MODULE_PARM_DESC(nreaders_stress, "Number of read-locking stress-test threads");
+module_param(stat_interval, int, 0644);
+MODULE_PARM_DESC(stat_interval, "Number of seconds between stats printk()s");
+module_param(hold_delay_ns, int, 0444);
+MODULE_PARM_DESC(hold_delay_ns, "Additional lock hold time (ns)");
+module_param(cpu_bind, bool, 0444);
+MODULE_PARM_DESC(cpu_bind, "Bind writers round-robin to online CPUs");
+module_param(verbose, bool, 0444);
+MODULE_PARM_DESC(verbose, "Enable verbose debugging printk()s");
+module_param(torture_type, charp, 0444);
+MODULE_PARM_DESC(torture_type,
+		 "Type of lock to torture (spin_lock, spin_lock_irq, mutex_lock, rwsem_lock)");
+
+#define TORTURE_FLAG "-torture:"
+#define PRINTK_STRING(s) \
+	do { pr_alert("%s" TORTURE_FLAG s "\n", torture_type); } while (0)
+#define VERBOSE_PRINTK_STRING(s) \
+	do { if (verbose) pr_alert("%s" TORTURE_FLAG s "\n", torture_type); } while (0)
+#define VERBOSE_PRINTK_ERRSTRING(s) \
+	do { if (verbose) pr_alert("%s" TORTURE_FLAG "!!! " s "\n", torture_type); } while (0)
+
+static struct task_struct *stats_task;
+static struct task_struct **writer_tasks;
+static struct task_struct **reader_tasks;
+
+static int nrealwriters_stress;
+static int nrealreaders_stress;
+static bool lock_is_write_held;
+static atomic_t lock_readers_held;
+static atomic_t cur_ops_fail;
+static unsigned long start_jiffies;
+
+struct lock_stress_stats {
+	long n_lock_fail;
+	long n_lock_acquired;
+};
+
+static struct lock_stress_stats *lwsa;	/* writer statistics */
+static struct lock_stress_stats *lrsa;	/* reader statistics */
+
+/*
+ * Operations vector for selecting different types of tests.
+ */
+struct lock_torture_ops {
+	void (*init)(void);
+	int (*writelock)(void);
+	void (*write_delay)(struct rnd_state *trsp);
+	void (*writeunlock)(void);
+	int (*readlock)(void);
+	void (*read_delay)(struct rnd_state *trsp);
+	void (*readunlock)(void);
+	const char *name;
+};
+
+static struct lock_torture_ops *cur_ops;
+
+/*
+ * Definitions for lock torture testing.
+ */
+
+static void torture_lock_hold(struct rnd_state *trsp, int longdelay_us)
+{
+	u64 range = (u64)nrealwriters_stress * 2000 * longdelay_us;
+	u64 rand;
+
+	if (hold_delay_ns)
+		ndelay(hold_delay_ns);
+
+	/*
+	 * We want a long delay occasionally to force massive contention.
+	 * The rwsem reader path gets here with no writers at all, in which
+	 * case there is nobody to contend with.
+	 */
+	if (!range)
+		return;
+	/* range can exceed 32 bits, so no do_div(); rand % range == 0 */
+	rand = prandom_u32_state(trsp);
+	if (rand == div64_u64(rand, range) * range)
+		udelay(longdelay_us);
+}
+
+static DEFINE_SPINLOCK(torture_spinlock);
+
+static int torture_spin_lock_write_lock(void) __acquires(torture_spinlock)
+{
+	spin_lock(&torture_spinlock);
+	return 0;
+}
+
+static void torture_spin_lock_write_delay(struct rnd_state *trsp)
+{
+	torture_lock_hold(trsp, 100);
+#ifdef CONFIG_PREEMPT
+	if (!(prandom_u32_state(trsp) % (nrealwriters_stress * 20000)))
+		preempt_schedule();  /* Allow test to be preempted. */
+#endif
+}
+
+static void torture_spin_lock_write_unlock(void) __releases(torture_spinlock)
+{
+	spin_unlock(&torture_spinlock);
+}
+
+static struct lock_torture_ops spin_lock_ops = {
+	.writelock	= torture_spin_lock_write_lock,
+	.write_delay	= torture_spin_lock_write_delay,
+	.writeunlock	= torture_spin_lock_write_unlock,
+	.name		= "spin_lock"
+};
+
+static unsigned long torture_spinlock_flags;
+
+static int torture_spin_lock_write_lock_irq(void)
+__acquires(torture_spinlock)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&torture_spinlock, flags);
+	torture_spinlock_flags = flags;
+	return 0;
+}
+
+static void torture_lock_spin_write_unlock_irq(void)
+__releases(torture_spinlock)
+{
+	spin_unlock_irqrestore(&torture_spinlock, torture_spinlock_flags);
+}
+
+static struct lock_torture_ops spin_lock_irq_ops = {
+	.writelock	= torture_spin_lock_write_lock_irq,
+	.write_delay	= torture_spin_lock_write_delay,
+	.writeunlock	= torture_lock_spin_write_unlock_irq,
+	.name		= "spin_lock_irq"
+};
+
+static DEFINE_MUTEX(torture_mutex);
+
+static int torture_mutex_lock(void) __acquires(torture_mutex)
+{
+	mutex_lock(&torture_mutex);
+	return 0;
+}
+
+static void torture_mutex_delay(struct rnd_state *trsp)
+{
+	torture_lock_hold(trsp, 5000);
+}
+
+static void torture_mutex_unlock(void) __releases(torture_mutex)
+{
+	mutex_unlock(&torture_mutex);
+}
+
+static struct lock_torture_ops mutex_lock_ops = {
+	.writelock	= torture_mutex_lock,
+	.write_delay	= torture_mutex_delay,
+	.writeunlock	= torture_mutex_unlock,
+	.name		= "mutex_lock"
+};
+
+static DECLARE_RWSEM(torture_rwsem);
+
+static int torture_rwsem_down_write(void) __acquires(torture_rwsem)
+{
+	down_write(&torture_rwsem);
+	return 0;
+}
+
+static void torture_rwsem_write_delay(struct rnd_state *trsp)
+{
+	torture_lock_hold(trsp, 5000);
+}
+
+static void torture_rwsem_up_write(void) __releases(torture_rwsem)
+{
+	up_write(&torture_rwsem);
+}
+
+static int torture_rwsem_down_read(void) __acquires(torture_rwsem)
+{
+	down_read(&torture_rwsem);
+	return 0;
+}
+
+static void torture_rwsem_read_delay(struct rnd_state *trsp)
+{
+	torture_lock_hold(trsp, 2000);
+}
+
+static void torture_rwsem_up_read(void) __releases(torture_rwsem)
+{
+	up_read(&torture_rwsem);
+}
+
+static struct lock_torture_ops rwsem_lock_ops = {
+	.writelock	= torture_rwsem_down_write,
+	.write_delay	= torture_rwsem_write_delay,
+	.writeunlock	= torture_rwsem_up_write,
+	.readlock	= torture_rwsem_down_read,
+	.read_delay	= torture_rwsem_read_delay,
+	.readunlock	= torture_rwsem_up_read,
+	.name		= "rwsem_lock"
+};
+
+/*
+ * Lock torture writer kthread.  Repeatedly acquires and releases
+ * the lock, checking for duplicate acquisitions.
+ */
+static int lock_torture_writer(void *arg)
+{
+	struct lock_stress_stats *lwsp = arg;
+	struct rnd_state rand;
+
+	VERBOSE_PRINTK_STRING("lock_torture_writer task started");
+	prandom_seed_state(&rand, (u64)(unsigned long)lwsp ^ jiffies);
+	set_user_nice(current, 19);
+
+	do {
+		if ((prandom_u32_state(&rand) & 0xfffff) == 0)
+			schedule_timeout_uninterruptible(1);
+		cur_ops->writelock();
+		if (WARN_ON_ONCE(lock_is_write_held))
+			lwsp->n_lock_fail++;
+		lock_is_write_held = 1;
+		if (WARN_ON_ONCE(atomic_read(&lock_readers_held)))
+			lwsp->n_lock_fail++;
+		lwsp->n_lock_acquired++;
+		cur_ops->write_delay(&rand);
+		lock_is_write_held = 0;
+		cur_ops->writeunlock();
+	} while (!kthread_should_stop());
+	VERBOSE_PRINTK_STRING("lock_torture_writer task stopping");
+	return 0;
+}
+
+/*
+ * Lock torture reader kthread.  Repeatedly acquires and releases
+ * the reader lock.
+ */
+static int lock_torture_reader(void *arg)
+{
+	struct lock_stress_stats *lrsp = arg;
+	struct rnd_state rand;
+
+	VERBOSE_PRINTK_STRING("lock_torture_reader task started");
+	prandom_seed_state(&rand, (u64)(unsigned long)lrsp ^ jiffies);
+	set_user_nice(current, 19);
+
+	do {
+		if ((prandom_u32_state(&rand) & 0xfffff) == 0)
+			schedule_timeout_uninterruptible(1);
+		cur_ops->readlock();
+		atomic_inc(&lock_readers_held);
+		if (WARN_ON_ONCE(lock_is_write_held))
+			lrsp->n_lock_fail++;
+		lrsp->n_lock_acquired++;
+		cur_ops->read_delay(&rand);
+		atomic_dec(&lock_readers_held);
+		cur_ops->readunlock();
+	} while (!kthread_should_stop());
+	VERBOSE_PRINTK_STRING("lock_torture_reader task stopping");
+	return 0;
+}
+
+/*
+ * Create a lock-torture-statistics message in the specified buffer.
+ */
+static void __lock_torture_stats_print(char *page,
+				       struct lock_stress_stats *statp,
+				       int n_stress, bool write)
+{
+	unsigned long secs = (jiffies - start_jiffies) / HZ;
+	bool fail = 0;
+	int i;
+	long max = 0, min = statp ? statp[0].n_lock_acquired : 0;
+	long long sum = 0;
+
+	for (i = 0; i < n_stress; i++) {
+		if (statp[i].n_lock_fail)
+			fail = true;
+		sum += statp[i].n_lock_acquired;
+		if (max < statp[i].n_lock_acquired)
+			max = statp[i].n_lock_acquired;
+		if (min > statp[i].n_lock_acquired)
+			min = statp[i].n_lock_acquired;
+	}
+	page += sprintf(page,
+			"%s:  Threads: %d Total: %llu Per-sec: %llu Max/Min: %ld/%ld %s  Fail: %d %s\n",
+			write ? "Writes" : "Reads ", n_stress, sum,
+			secs ? div64_u64(sum, secs) : 0ULL, max, min,
+			max / 2 > min ? "???" : "", fail, fail ? "!!!" : "");
+	if (fail)
+		atomic_inc(&cur_ops_fail);
+}
+
+/*
+ * Print torture statistics.  Caller must ensure that there is only one
+ * call to this function at a given time!!!  This is normally accomplished
+ * by relying on the module system to only have one copy of the module
+ * loaded, and then by giving the lock_torture_stats kthread full control
+ * (or the init/cleanup functions when lock_torture_stats thread is not
+ * running).
+ */
+static void lock_torture_stats_print(void)
+{
+	int size = nrealwriters_stress * 200 + 8192;
+	char *buf;
+
+	if (cur_ops->readlock)
+		size += nrealreaders_stress * 200 + 8192;
+
+	buf = kmalloc(size, GFP_KERNEL);
+	if (!buf) {
+		pr_err("lock_torture_stats_print: Out of memory, need: %d",
+		       size);
+		return;
+	}
+
+	__lock_torture_stats_print(buf, lwsa, nrealwriters_stress, true);
+	pr_alert("%s" TORTURE_FLAG "%s", torture_type, buf);
+	if (cur_ops->readlock) {
+		__lock_torture_stats_print(buf, lrsa, nrealreaders_stress,
+					   false);
+		pr_alert("%s" TORTURE_FLAG "%s", torture_type, buf);
+	}
+	kfree(buf);
+}
+
+/*
+ * Periodically prints torture statistics, if periodic statistics printing
+ * was specified via the stat_interval module parameter.
+ */
+static int lock_torture_stats(void *arg)
+{
+	VERBOSE_PRINTK_STRING("lock_torture_stats task started");
+	do {
+		schedule_timeout_interruptible(stat_interval * HZ);
+		lock_torture_stats_print();
+	} while (!kthread_should_stop());
+	VERBOSE_PRINTK_STRING("lock_torture_stats task stopping");
+	return 0;
+}
+
+static inline void
+lock_torture_print_module_parms(struct lock_torture_ops *cur_ops,
+				const char *tag)
+{
+	pr_alert("%s" TORTURE_FLAG
+		 "--- %s: nwriters_stress=%d nreaders_stress=%d stat_interval=%d hold_delay_ns=%d cpu_bind=%d verbose=%d\n",
+		 torture_type, tag, nrealwriters_stress, nrealreaders_stress,
+		 stat_interval, hold_delay_ns, cpu_bind, verbose);
+}
+
+static void lock_torture_cleanup(void)
+{
+	int i;
+
+	if (writer_tasks) {
+		for (i = 0; i < nrealwriters_stress; i++) {
+			if (writer_tasks[i]) {
+				VERBOSE_PRINTK_STRING(
+					"Stopping lock_torture_writer task");
+				kthread_stop(writer_tasks[i]);
+			}
+			writer_tasks[i] = NULL;
+		}
+		kfree(writer_tasks);
+		writer_tasks = NULL;
+	}
+
+	if (reader_tasks) {
+		for (i = 0; i < nrealreaders_stress; i++) {
+			if (reader_tasks[i]) {
+				VERBOSE_PRINTK_STRING(
+					"Stopping lock_torture_reader task");
+				kthread_stop(reader_tasks[i]);
+			}
+			reader_tasks[i] = NULL;
+		}
+		kfree(reader_tasks);
+		reader_tasks = NULL;
+	}
+
+	if (stats_task) {
+		VERBOSE_PRINTK_STRING("Stopping lock_torture_stats task");
+		kthread_stop(stats_task);
+	}
+	stats_task = NULL;
+
+	if (lwsa) {
+		lock_torture_stats_print();  /* -After- the stats thread is stopped! */
+
+		if (atomic_read(&cur_ops_fail))
+			lock_torture_print_module_parms(cur_ops,
+							"End of test: FAILURE");
+		else
+			lock_torture_print_module_parms(cur_ops,
+							"End of test: SUCCESS");
+	}
+
+	kfree(lwsa);
+	lwsa = NULL;
+	kfree(lrsa);
+	lrsa = NULL;
+}
+
+static int __init lock_torture_init(void)
+{
+	int i, cpu;
+	int firsterr = 0;
+	static struct lock_torture_ops *torture_ops[] = {
+		&spin_lock_ops, &spin_lock_irq_ops,
+		&mutex_lock_ops, &rwsem_lock_ops,
+	};
+
+	/* Process args and tell the world that the torturer is on the job. */
+	for (i = 0; i < ARRAY_SIZE(torture_ops); i++) {
+		cur_ops = torture_ops[i];
+		if (strcmp(torture_type, cur_ops->name) == 0)
+			break;
+	}
+	if (i == ARRAY_SIZE(torture_ops)) {
+		pr_alert("lock-torture: invalid torture type: \"%s\"\n",
+			 torture_type);
+		pr_alert("lock-torture types:");
+		for (i = 0; i < ARRAY_SIZE(torture_ops); i++)
+			pr_alert(" %s", torture_ops[i]->name);
+		pr_alert("\n");
+		return -EINVAL;
+	}
+	if (cur_ops->init)
+		cur_ops->init(); /* no "goto unwind" prior to this point!!! */
+
+	if (nwriters_stress >= 0)
+		nrealwriters_stress = nwriters_stress;
+	else
+		nrealwriters_stress = 2 * num_online_cpus();
+	if (cur_ops->readlock) {
+		if (nreaders_stress >= 0)
+			nrealreaders_stress = nreaders_stress;
+		else
+			nrealreaders_stress = nrealwriters_stress;
+	}
+	lock_torture_print_module_parms(cur_ops, "Start of test");
+
+	/* Initialize the statistics so that each run gets its own numbers. */
+	lock_is_write_held = 0;
+	atomic_set(&lock_readers_held, 0);
+	atomic_set(&cur_ops_fail, 0);
+	start_jiffies = jiffies;
+
+	lwsa = kcalloc(nrealwriters_stress, sizeof(*lwsa), GFP_KERNEL);
+	writer_tasks = kcalloc(nrealwriters_stress, sizeof(writer_tasks[0]),
+			       GFP_KERNEL);
+	if (!lwsa || !writer_tasks) {
+		VERBOSE_PRINTK_ERRSTRING("out of memory");
+		firsterr = -ENOMEM;
+		goto unwind;
+	}
+	if (cur_ops->readlock) {
+		lrsa = kcalloc(nrealreaders_stress, sizeof(*lrsa), GFP_KERNEL);
+		reader_tasks = kcalloc(nrealreaders_stress,
+				       sizeof(reader_tasks[0]), GFP_KERNEL);
+		if (!lrsa || !reader_tasks) {
+			VERBOSE_PRINTK_ERRSTRING("out of memory");
+			firsterr = -ENOMEM;
+			goto unwind;
+		}
+	}
+
+	/*
+	 * With cpu_bind, no two spinning writers share a CPU as long as
+	 * nwriters_stress <= ncpus, so that the numbers reflect the lock
+	 * rather than the scheduler.
+	 */
+	get_online_cpus();
+	cpu = cpumask_first(cpu_online_mask);
+	for (i = 0; i < nrealwriters_stress; i++) {
+		VERBOSE_PRINTK_STRING("Creating lock_torture_writer task");
+		writer_tasks[i] = kthread_create(lock_torture_writer, &lwsa[i],
+						 "lock_torture_writer");
+		if (IS_ERR(writer_tasks[i])) {
+			put_online_cpus();
+			firsterr = PTR_ERR(writer_tasks[i]);
+			VERBOSE_PRINTK_ERRSTRING("Failed to create writer");
+			writer_tasks[i] = NULL;
+			goto unwind;
+		}
+		if (cpu_bind) {
+			kthread_bind(writer_tasks[i], cpu);
+			cpu = cpumask_next(cpu, cpu_online_mask);
+			if (cpu >= nr_cpu_ids)
+				cpu = cpumask_first(cpu_online_mask);
+		}
+		wake_up_process(writer_tasks[i]);
+	}
+	put_online_cpus();
+	for (i = 0; i < nrealreaders_stress; i++) {
+		VERBOSE_PRINTK_STRING("Creating lock_torture_reader task");
+		reader_tasks[i] = kthread_run(lock_torture_reader, &lrsa[i],
+					      "lock_torture_reader");
+		if (IS_ERR(reader_tasks[i])) {
+			firsterr = PTR_ERR(reader_tasks[i]);
+			VERBOSE_PRINTK_ERRSTRING("Failed to create reader");
+			reader_tasks[i] = NULL;
+			goto unwind;
+		}
+	}
+	if (stat_interval > 0) {
+		VERBOSE_PRINTK_STRING("Creating lock_torture_stats task");
+		stats_task = kthread_run(lock_torture_stats, NULL,
+					 "lock_torture_stats");
+		if (IS_ERR(stats_task)) {
+			firsterr = PTR_ERR(stats_task);
+			VERBOSE_PRINTK_ERRSTRING("Failed to create stats");
+			stats_task = NULL;
+			goto unwind;
+		}
+	}
+	return 0;
+
+unwind:
+	lock_torture_cleanup();
+	return firsterr;
+}
+
+module_init(lock_torture_init);
+module_exit(lock_torture_cleanup);
@@ -51,7 +51,6 @@
 #include <linux/kthread.h>
 #include <linux/prefetch.h>
 #include <linux/delay.h>
-#include <linux/stop_machine.h>
 #include <linux/random.h>
 
 #include "rcutree.h"
@@ -75,6 +74,8 @@ static struct lock_class_key rcu_fqs_class[RCU_NUM_LVLS];
 	.orphan_donetail = &sname##_state.orphan_donelist, \
 	.barrier_mutex = __MUTEX_INITIALIZER(sname##_state.barrier_mutex), \
 	.onoff_mutex = __MUTEX_INITIALIZER(sname##_state.onoff_mutex), \
+	.expedited_mutex = __MUTEX_INITIALIZER(sname##_state.expedited_mutex), \
+	.expedited_wq = __WAIT_QUEUE_HEAD_INITIALIZER(sname##_state.expedited_wq), \
 	.name = #sname, \
 	.abbr = sabbr, \
 }
@@ -180,6 +181,8 @@ void rcu_sched_qs(int cpu)
 	if (rdp->passed_quiesce == 0)
 		trace_rcu_grace_period("rcu_sched", rdp->gpnum, "cpuqs");
 	rdp->passed_quiesce = 1;
+	if (unlikely(rdp->exp_qs_needed))
+		rcu_report_exp_rdp(&rcu_sched_state, rdp);
 }
 
 void rcu_bh_qs(int cpu)
@@ -229,6 +232,7 @@ static void rcu_start_gp_advanced(struct rcu_state *rsp, struct rcu_node *rnp,
 static void force_qs_rnp(struct rcu_state *rsp, int (*f)(struct rcu_data *));
 static void force_quiescent_state(struct rcu_state *rsp);
 static int rcu_pending(int cpu);
+static void rcu_report_exp_rdp(struct rcu_state *rsp, struct rcu_data *rdp);
 
 /*
  * Return the number of RCU-sched batches processed thus far for debug & stats.
@@ -2560,64 +2564,170 @@ void synchronize_rcu_bh(void)
 }
 EXPORT_SYMBOL_GPL(synchronize_rcu_bh);
 
-static int synchronize_sched_expedited_cpu_stop(void *data)
+/*
+ * Report that the specified CPU has passed through a quiescent state
+ * on behalf of the current expedited RCU-sched grace period, clearing
+ * its bit in its leaf rcu_node structure's ->expmask and propagating
+ * up the tree as each ->expmask empties.  Wakes up the task driving
+ * the expedited grace period once the root's ->expmask is empty.
+ */
+static void rcu_report_exp_rdp(struct rcu_state *rsp, struct rcu_data *rdp)
 {
+	unsigned long flags;
+	unsigned long mask = rdp->grpmask;
+	struct rcu_node *rnp = rdp->mynode;
+
+	rdp->exp_qs_needed = false;
+	raw_spin_lock_irqsave(&rnp->lock, flags);
+	for (;;) {
+		if (!(rnp->expmask & mask))
+			break;	/* Already reported. */
+		rnp->expmask &= ~mask;
+		if (rnp->expmask)
+			break;	/* Others in this group still to report. */
+		if (rnp->parent == NULL) {
+			raw_spin_unlock_irqrestore(&rnp->lock, flags);
+			smp_mb(); /* Order reports before the wakeup. */
+			wake_up(&rsp->expedited_wq);
+			return;
+		}
+		mask = rnp->grpmask;
+		raw_spin_unlock(&rnp->lock); /* irqs remain disabled. */
+		rnp = rnp->parent;
+		raw_spin_lock(&rnp->lock); /* irqs already disabled. */
+	}
+	raw_spin_unlock_irqrestore(&rnp->lock, flags);
+}
+
+/*
+ * IPI handler for synchronize_sched_expedited().  An interrupt from idle
+ * is a quiescent state in its own right.  Otherwise we might have
+ * interrupted an RCU-sched read-side critical section, so ask for a
+ * context switch and let rcu_sched_qs() report it.
+ */
+static void synchronize_sched_expedited_ipi(void *data)
+{
+	struct rcu_state *rsp = data;
+	struct rcu_data *rdp = this_cpu_ptr(rsp->rda);
+
+	if (!(ACCESS_ONCE(rdp->mynode->expmask) & rdp->grpmask))
+		return;
+	if (rcu_is_cpu_rrupt_from_idle()) {
+		rcu_report_exp_rdp(rsp, rdp);
+		return;
+	}
+	rdp->exp_qs_needed = true;
+	set_tsk_need_resched(current);
+}
+
+/*
+ * Set up the rcu_node tree's ->expmask fields for a new expedited grace
+ * period, then IPI each online CPU that the snapshot does not already
+ * show to be quiescent: CPUs in dynticks-idle mode (which includes
+ * adaptive-ticks CPUs running in userspace) and the CPU we are running
+ * on, which cannot be in a read-side critical section.  Those CPUs are
+ * never disturbed.  The caller must hold ->expedited_mutex and prevent
+ * CPU hotplug.
+ */
+static void sync_sched_exp_select_cpus(struct rcu_state *rsp)
+{
+	int cpu;
+	unsigned long bit;
+	unsigned long flags;
+	unsigned long mask;
+	struct rcu_data *rdp;
+	struct rcu_node *rnp;
+	struct rcu_node *rnp_up;
+
+	rcu_for_each_nonleaf_node_breadth_first(rsp, rnp) {
+		raw_spin_lock_irqsave(&rnp->lock, flags);
+		rnp->expmask = 0;
+		raw_spin_unlock_irqrestore(&rnp->lock, flags);
+	}
+
 	/*
-	 * There must be a full memory barrier on each affected CPU
-	 * between the time that try_stop_cpus() is called and the
-	 * time that it returns.
-	 *
-	 * In the current initial implementation of cpu_stop, the
-	 * above condition is already met when the control reaches
-	 * this point and the following smp_mb() is not strictly
-	 * necessary.  Do smp_mb() anyway for documentation and
-	 * robustness against future implementation changes.
+	 * Compute each leaf's mask.  Leaves are all empty at this point,
+	 * as the previous expedited grace period ended with an empty root.
 	 */
-	smp_mb(); /* See above comment block. */
-	return 0;
+	rcu_for_each_leaf_node(rsp, rnp) {
+		mask = 0;
+		bit = 1;
+		for (cpu = rnp->grplo; cpu <= rnp->grphi; cpu++, bit <<= 1) {
+			if (!(rnp->qsmaskinit & bit))
+				continue;
+			rdp = per_cpu_ptr(rsp->rda, cpu);
+			if (cpu == raw_smp_processor_id() ||
+			    !(atomic_add_return(0, &rdp->dynticks->dynticks) & 0x1)) {
+				atomic_long_inc(&rsp->expedited_idle);
+				continue;
+			}
+			mask |= bit;
+		}
+		if (!mask)
+			continue;
+
+		/*
+		 * Set the ancestors' bits before the leaf's own.  A stale
+		 * IPI or a leftover ->exp_qs_needed can report as soon as
+		 * the leaf bit is visible, and if that emptied the leaf
+		 * before the parent bits were set, they would never be
+		 * cleared and the waiter would sleep forever.
+		 */
+		for (rnp_up = rnp; rnp_up->parent; rnp_up = rnp_up->parent) {
+			raw_spin_lock_irqsave(&rnp_up->parent->lock, flags);
+			rnp_up->parent->expmask |= rnp_up->grpmask;
+			raw_spin_unlock_irqrestore(&rnp_up->parent->lock, flags);
+		}
+		raw_spin_lock_irqsave(&rnp->lock, flags);
+		rnp->expmask = mask;
+		raw_spin_unlock_irqrestore(&rnp->lock, flags);
+	}
+
+	/* Now that the whole tree is set up, ask for the quiescent states. */
+	rcu_for_each_leaf_node(rsp, rnp) {
+		mask = ACCESS_ONCE(rnp->expmask);
+		bit = 1;
+		for (cpu = rnp->grplo; cpu <= rnp->grphi; cpu++, bit <<= 1) {
+			if (!(mask & bit))
+				continue;
+			atomic_long_inc(&rsp->expedited_ipis);
+			smp_call_function_single(cpu,
+						 synchronize_sched_expedited_ipi,
+						 rsp, 0);
+		}
+	}
 }
 
 /**
  * synchronize_sched_expedited - Brute-force RCU-sched grace period
  *
  * Wait for an RCU-sched grace period to elapse, but use a "big hammer"
- * approach to force the grace period to end quickly.  This consumes
- * significant time on all CPUs and is unfriendly to real-time workloads,
- * so is thus not recommended for any sort of common-case code.  In fact,
- * if you are using synchronize_sched_expedited() in a loop, please
- * restructure your code to batch your updates, and then use a single
- * synchronize_sched() instead.
+ * approach to force the grace period to end quickly.  This IPIs every
+ * online CPU that is not idle, and forces a context switch on those
+ * that are running something, so is still unfriendly to real-time
+ * workloads and is thus not recommended for any sort of common-case code.
+ * In fact, if you are using synchronize_sched_expedited() in a loop,
+ * please restructure your code to batch your updates, and then use a
+ * single synchronize_sched() instead.
  *
  * Note that it is illegal to call this function while holding any lock
  * that is acquired by a CPU-hotplug notifier.  And yes, it is also illegal
  * to call this function from a CPU-hotplug notifier.  Failing to observe
  * these restriction will result in deadlock.
  *
- * This implementation can be thought of as an application of ticket
- * locking to RCU, with sync_sched_expedited_started and
- * sync_sched_expedited_done taking on the roles of the halves
- * of the ticket-lock word.  Each task atomically increments
- * sync_sched_expedited_started upon entry, snapshotting the old value,
- * then attempts to stop all the CPUs.  If this succeeds, then each
- * CPU will have executed a context switch, resulting in an RCU-sched
- * grace period.  We are then done, so we use atomic_cmpxchg() to
- * update sync_sched_expedited_done to match our snapshot -- but
- * only if someone else has not already advanced past our snapshot.
- *
- * On the other hand, if try_stop_cpus() fails, we check the value
- * of sync_sched_expedited_done.  If it has advanced past our
- * initial snapshot, then someone else must have forced a grace period
- * some time after we took our snapshot.  In this case, our work is
- * done for us, and we can simply return.  Otherwise, we try again,
- * but keep our initial snapshot for purposes of checking for someone
- * doing our work for us.
- *
- * If we fail too many times in a row, we fall back to synchronize_sched().
+ * Concurrent callers share grace periods using a ticket scheme:
+ * ->expedited_start is incremented by each caller on entry, and
+ * ->expedited_done records the highest ticket known to be covered by
+ * a completed expedited grace period.  Expedited grace periods are
+ * serialized by ->expedited_mutex; whoever gets it first checks whether
+ * its ticket has been covered while it waited, and if not, snapshots
+ * ->expedited_start and drives a grace period covering every caller
+ * that had taken a ticket by then.
  */
 void synchronize_sched_expedited(void)
 {
-	long firstsnap, s, snap;
-	int trycount = 0;
+	long s, snap;
+	struct rcu_node *rnp;
 	struct rcu_state *rsp = &rcu_sched_state;
 
 	/*
@@ -2641,79 +2751,36 @@ void synchronize_sched_expedited(void)
 	 * full memory barrier.
 	 */
 	snap = atomic_long_inc_return(&rsp->expedited_start);
-	firstsnap = snap;
-	get_online_cpus();
-	WARN_ON_ONCE(cpu_is_offline(raw_smp_processor_id()));
-
-	/*
-	 * Each pass through the following loop attempts to force a
-	 * context switch on each CPU.
-	 */
-	while (try_stop_cpus(cpu_online_mask,
-			     synchronize_sched_expedited_cpu_stop,
-			     NULL) == -EAGAIN) {
-		put_online_cpus();
-		atomic_long_inc(&rsp->expedited_tryfail);
-
-		/* Check to see if someone else did our work for us. */
-		s = atomic_long_read(&rsp->expedited_done);
-		if (ULONG_CMP_GE((ulong)s, (ulong)firstsnap)) {
-			/* ensure test happens before caller kfree */
-			smp_mb__before_atomic_inc(); /* ^^^ */
-			atomic_long_inc(&rsp->expedited_workdone1);
-			return;
-		}
-
-		/* No joy, try again later.  Or just synchronize_sched(). */
-		if (trycount++ < 10) {
-			udelay(trycount * num_online_cpus());
-		} else {
-			wait_rcu_gp(call_rcu_sched);
-			atomic_long_inc(&rsp->expedited_normal);
-			return;
-		}
-
-		/* Recheck to see if someone else did our work for us. */
-		s = atomic_long_read(&rsp->expedited_done);
-		if (ULONG_CMP_GE((ulong)s, (ulong)firstsnap)) {
-			/* ensure test happens before caller kfree */
-			smp_mb__before_atomic_inc(); /* ^^^ */
-			atomic_long_inc(&rsp->expedited_workdone2);
-			return;
-		}
-
-		/*
-		 * Refetching sync_sched_expedited_started allows later
-		 * callers to piggyback on our grace period.  We retry
-		 * after they started, so our grace period works for them,
-		 * and they started after our first try, so their grace
-		 * period works for us.
-		 */
-		get_online_cpus();
-		snap = atomic_long_read(&rsp->expedited_start);
-		smp_mb(); /* ensure read is before try_stop_cpus(). */
+	mutex_lock(&rsp->expedited_mutex);
+
+	/* Check to see if someone else did our work for us. */
+	s = atomic_long_read(&rsp->expedited_done);
+	if (ULONG_CMP_GE((ulong)s, (ulong)snap)) {
+		mutex_unlock(&rsp->expedited_mutex);
+		/* ensure test happens before caller kfree */
+		smp_mb__before_atomic_inc(); /* ^^^ */
+		atomic_long_inc(&rsp->expedited_workdone);
+		return;
 	}
-	atomic_long_inc(&rsp->expedited_stoppedcpus);
 
 	/*
-	 * Everyone up to our most recent fetch is covered by our grace
-	 * period.  Update the counter, but only if our work is still
-	 * relevant -- which it won't be if someone who started later
-	 * than we did already did their update.
+	 * Refetching ->expedited_start lets everyone who has taken a ticket
+	 * so far piggyback on our grace period: they started before it did.
 	 */
-	do {
-		atomic_long_inc(&rsp->expedited_done_tries);
-		s = atomic_long_read(&rsp->expedited_done);
-		if (ULONG_CMP_GE((ulong)s, (ulong)snap)) {
-			/* ensure test happens before caller kfree */
-			smp_mb__before_atomic_inc(); /* ^^^ */
-			atomic_long_inc(&rsp->expedited_done_lost);
-			break;
-		}
-	} while (atomic_long_cmpxchg(&rsp->expedited_done, s, snap) != s);
-	atomic_long_inc(&rsp->expedited_done_exit);
+	snap = atomic_long_read(&rsp->expedited_start);
+	smp_mb(); /* ensure read is before the CPUs are sampled. */
 
+	get_online_cpus();
+	WARN_ON_ONCE(cpu_is_offline(raw_smp_processor_id()));
+	sync_sched_exp_select_cpus(rsp);
+	rnp = rcu_get_root(rsp);
+	wait_event(rsp->expedited_wq, !ACCESS_ONCE(rnp->expmask));
+	smp_mb(); /* ensure quiescent states are seen before caller kfree */
 	put_online_cpus();
+	atomic_long_inc(&rsp->expedited_gps);
+
+	atomic_long_set(&rsp->expedited_done, snap);
+	mutex_unlock(&rsp->expedited_mutex);
 }
 EXPORT_SYMBOL_GPL(synchronize_sched_expedited);
 
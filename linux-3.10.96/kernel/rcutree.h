@@ -129,7 +129,10 @@ struct rcu_node {
 	unsigned long expmask;	/* Groups that have ->blkd_tasks */
 				/*  elements that need to drain to allow the */
 				/*  current expedited grace period to */
-				/*  complete (only for TREE_PREEMPT_RCU). */
+				/*  complete (in the TREE_PREEMPT_RCU tree), */
+				/*  or CPUs or groups that still owe the */
+				/*  current expedited RCU-sched grace period */
+				/*  a quiescent state (in the rcu_sched tree). */
 	unsigned long qsmaskinit;
 				/* Per-GP initial value for qsmask & expmask. */
 	unsigned long grpmask;	/* Mask to apply to parent qsmask. */
@@ -245,6 +248,8 @@ struct rcu_data {
 	bool		preemptible;	/* Preemptible RCU? */
 	struct rcu_node *mynode;	/* This CPU's leaf of hierarchy */
 	unsigned long grpmask;		/* Mask to apply to leaf qsmask. */
+	bool		exp_qs_needed;	/* Expedited GP asked this CPU */
+					/*  for a context switch. */
 #ifdef CONFIG_RCU_CPU_STALL_INFO
 	unsigned long	ticks_this_gp;	/* The number of scheduling-clock */
 					/*  ticks this CPU has handled */
@@ -324,7 +329,14 @@ struct rcu_data {
 	int nocb_p_count;		/* # CBs being invoked by kthread */
 	int nocb_p_count_lazy;		/*  (approximate). */
 	wait_queue_head_t nocb_wq;	/* For nocb kthreads to sleep on. */
-	struct task_struct *nocb_kthread;
+	struct task_struct *nocb_kthread; /* This CPU's node's kthread. */
+	struct rcu_data *nocb_leader;	/* Node's first no-CBs CPU. */
+	struct rcu_data *nocb_next_follower;
+					/* Next no-CBs CPU on this node. */
+	struct rcu_head *nocb_gp_head;	/* CBs waiting for grace period. */
+	struct rcu_head **nocb_gp_tail;
+	unsigned long n_nocb_batches;	/* # batches invoked by kthread. */
+	long nocb_max_batch;		/* Largest batch invoked by kthread. */
 #endif /* #ifdef CONFIG_RCU_NOCB_CPU */
 
 	/* 8) RCU CPU stall data. */
@@ -414,17 +426,15 @@ struct rcu_state {
 						/*  _rcu_barrier(). */
 	/* End of fields guarded by barrier_mutex. */
 
+	struct mutex expedited_mutex;		/* One expedited GP at a time. */
+	wait_queue_head_t expedited_wq;		/* Wait for ->expmask to clear. */
 	atomic_long_t expedited_start;		/* Starting ticket. */
 	atomic_long_t expedited_done;		/* Done ticket. */
 	atomic_long_t expedited_wrap;		/* # near-wrap incidents. */
-	atomic_long_t expedited_tryfail;	/* # acquisition failures. */
-	atomic_long_t expedited_workdone1;	/* # done by others #1. */
-	atomic_long_t expedited_workdone2;	/* # done by others #2. */
-	atomic_long_t expedited_normal;		/* # fallbacks to normal. */
-	atomic_long_t expedited_stoppedcpus;	/* # successful stop_cpus. */
-	atomic_long_t expedited_done_tries;	/* # tries to update _done. */
-	atomic_long_t expedited_done_lost;	/* # times beaten to _done. */
-	atomic_long_t expedited_done_exit;	/* # times exited _done loop. */
+	atomic_long_t expedited_workdone;	/* # done by others. */
+	atomic_long_t expedited_gps;		/* # expedited GPs driven. */
+	atomic_long_t expedited_ipis;		/* # CPUs IPIed. */
+	atomic_long_t expedited_idle;		/* # CPUs found quiescent. */
 
 	unsigned long jiffies_force_qs;		/* Time at which to invoke */
 						/*  force_quiescent_state(). */
@@ -42,6 +42,8 @@
 static cpumask_var_t rcu_nocb_mask; /* CPUs to have callbacks offloaded. */
 static bool have_rcu_nocb_mask;	    /* Was rcu_nocb_mask allocated? */
 static bool __read_mostly rcu_nocb_poll;    /* Offload kthread are to poll. */
+static cpumask_var_t rcu_nocb_kthread_mask; /* Where offload kthreads run. */
+static bool have_rcu_nocb_kthread_mask;	/* Was it allocated? */
 static char __initdata nocb_buf[NR_CPUS * 5];
 #endif /* #ifdef CONFIG_RCU_NOCB_CPU */
 
@@ -1975,14 +1977,21 @@ static void increment_cpu_stall_ticks(void)
 
 /*
  * Offload callback processing from the boot-time-specified set of CPUs
- * specified by rcu_nocb_mask.  For each CPU in the set, there is a
- * kthread created that pulls the callbacks from the corresponding CPU,
- * waits for a grace period to elapse, and invokes the callbacks.
- * The no-CBs CPUs do a wake_up() on their kthread when they insert
+ * specified by rcu_nocb_mask.  For each NUMA node with CPUs in the set,
+ * there is a kthread created that pulls the callbacks from each of the
+ * node's no-CBs CPUs, waits for a single grace period to elapse on behalf
+ * of all of them, and invokes the callbacks.  The first no-CBs CPU of
+ * each node is the "leader": its ->nocb_wq is where the kthread sleeps,
+ * and the others are chained from it through ->nocb_next_follower.
+ * The no-CBs CPUs do a wake_up() on their node's kthread when they insert
  * a callback into any empty list, unless the rcu_nocb_poll boot parameter
  * has been specified, in which case each kthread actively polls its
- * CPU.  (Which isn't so great for energy efficiency, but which does
- * reduce RCU's overhead on that CPU.)
+ * CPUs.  (Which isn't so great for energy efficiency, but which does
+ * reduce RCU's overhead on those CPUs.)
+ *
+ * The kthreads may run anywhere unless the rcu_nocb_kthread_cpus boot
+ * parameter names the housekeeping CPUs they are to be confined to,
+ * preferring those on the kthread's own node.
  *
  * This is intended to be used in conjunction with Frederic Weisbecker's
  * adaptive-idle work, which would seriously reduce OS jitter on CPUs
@@ -2011,6 +2020,16 @@ static int __init parse_rcu_nocb_poll(char *arg)
 }
 early_param("rcu_nocb_poll", parse_rcu_nocb_poll);
 
+/* Parse the boot-time list of CPUs the offload kthreads may run on. */
+static int __init rcu_nocb_kthread_setup(char *str)
+{
+	alloc_bootmem_cpumask_var(&rcu_nocb_kthread_mask);
+	have_rcu_nocb_kthread_mask = true;
+	cpulist_parse(str, rcu_nocb_kthread_mask);
+	return 1;
+}
+__setup("rcu_nocb_kthread_cpus=", rcu_nocb_kthread_setup);
+
 /*
  * Do any no-CBs CPUs need another grace period?
  *
@@ -2060,13 +2079,27 @@ bool rcu_is_nocb_cpu(int cpu)
 	return false;
 }
 
+/*
+ * Add the specified CPUs to the no-CBs set.  This must be called before
+ * rcu_spawn_nocb_kthreads() and before these CPUs are brought online.
+ */
+void __init rcu_nocb_offload_cpus(const struct cpumask *mask)
+{
+	if (!have_rcu_nocb_mask) {
+		if (!zalloc_cpumask_var(&rcu_nocb_mask, GFP_KERNEL))
+			return;
+		have_rcu_nocb_mask = true;
+	}
+	cpumask_or(rcu_nocb_mask, rcu_nocb_mask, mask);
+}
+
 /*
  * Enqueue the specified string of rcu_head structures onto the specified
  * CPU's no-CBs lists.  The CPU is specified by rdp, the head of the
  * string by rhp, and the tail of the string by rhtp.  The non-lazy/lazy
  * counts are supplied by rhcount and rhcount_lazy.
  *
- * If warranted, also wake up the kthread servicing this CPUs queues.
+ * If warranted, also wake up the kthread servicing this CPU's node.
  */
 static void __call_rcu_nocb_enqueue(struct rcu_data *rdp,
 				    struct rcu_head *rhp,
@@ -2089,7 +2122,8 @@ static void __call_rcu_nocb_enqueue(struct rcu_data *rdp,
 		return;
 	len = atomic_long_read(&rdp->nocb_q_count);
 	if (old_rhpp == &rdp->nocb_head) {
-		wake_up(&rdp->nocb_wq); /* ... only if queue was empty ... */
+		/* ... only if queue was empty ... */
+		wake_up(&rdp->nocb_leader->nocb_wq);
 		rdp->qlen_last_fqs_check = 0;
 	} else if (len > rdp->qlen_last_fqs_check + qhimark) {
 		wake_up_process(t); /* ... or if many callbacks queued. */
@@ -2191,64 +2225,121 @@ static void rcu_nocb_wait_gp(struct rcu_data *rdp)
 	smp_mb(); /* Ensure that CB invocation happens after GP end. */
 }
 
+/* Does any no-CBs CPU on this leader's node have callbacks queued? */
+static bool rcu_nocb_node_has_cbs(struct rcu_data *leader)
+{
+	struct rcu_data *rdp;
+
+	for (rdp = leader; rdp; rdp = rdp->nocb_next_follower)
+		if (ACCESS_ONCE(rdp->nocb_head))
+			return true;
+	return false;
+}
+
 /*
- * Per-rcu_data kthread, but only for no-CBs CPUs.  Each kthread invokes
- * callbacks queued by the corresponding no-CBs CPU.
+ * Move the callbacks queued by the specified no-CBs CPU to its
+ * ->nocb_gp_head list, where they wait for the next grace period.
+ * Returns false if there were none.  The counts may lag the list, so
+ * they cannot be used to tell.
  */
-static int rcu_nocb_kthread(void *arg)
+static bool rcu_nocb_pull_cbs(struct rcu_data *rdp)
 {
-	int c, cl;
+	long c, cl;
 	struct rcu_head *list;
+
+	list = ACCESS_ONCE(rdp->nocb_head);
+	if (!list)
+		return false;
+	ACCESS_ONCE(rdp->nocb_head) = NULL;
+	rdp->nocb_gp_head = list;
+	rdp->nocb_gp_tail = xchg(&rdp->nocb_tail, &rdp->nocb_head);
+	c = atomic_long_xchg(&rdp->nocb_q_count, 0);
+	cl = atomic_long_xchg(&rdp->nocb_q_count_lazy, 0);
+	ACCESS_ONCE(rdp->nocb_p_count) += c;
+	ACCESS_ONCE(rdp->nocb_p_count_lazy) += cl;
+	return true;
+}
+
+/*
+ * Invoke the callbacks on the specified no-CBs CPU's ->nocb_gp_head
+ * list, whose grace period has now elapsed.  Unlike rcu_do_batch(),
+ * this runs in a preemptible kthread, so there is no need to limit the
+ * batch size: just let other tasks in between callbacks.
+ */
+static void rcu_nocb_invoke_cbs(struct rcu_data *rdp)
+{
+	long c, cl;
+	struct rcu_head *list = rdp->nocb_gp_head;
 	struct rcu_head *next;
-	struct rcu_head **tail;
-	struct rcu_data *rdp = arg;
+	struct rcu_head **tail = rdp->nocb_gp_tail;
+
+	rdp->nocb_gp_head = NULL;
+
+	/* Each pass through the following loop invokes a callback. */
+	trace_rcu_batch_start(rdp->rsp->name, rdp->nocb_p_count_lazy,
+			      rdp->nocb_p_count, -1);
+	c = cl = 0;
+	while (list) {
+		next = list->next;
+		/* Wait for enqueuing to complete, if needed. */
+		while (next == NULL && &list->next != tail) {
+			schedule_timeout_interruptible(1);
+			next = list->next;
+		}
+		debug_rcu_head_unqueue(list);
+		local_bh_disable();
+		if (__rcu_reclaim(rdp->rsp->name, list))
+			cl++;
+		c++;
+		local_bh_enable();
+		cond_resched();
+		list = next;
+	}
+	trace_rcu_batch_end(rdp->rsp->name, c, !!list, 0, 0, 1);
+	ACCESS_ONCE(rdp->nocb_p_count) -= c;
+	ACCESS_ONCE(rdp->nocb_p_count_lazy) -= cl;
+	rdp->n_nocbs_invoked += c;
+	rdp->n_nocb_batches++;
+	if (c > rdp->nocb_max_batch)
+		rdp->nocb_max_batch = c;
+}
+
+/*
+ * Per-node kthread, but only for nodes with no-CBs CPUs.  Each kthread
+ * invokes callbacks queued by the no-CBs CPUs on its node, passed in
+ * as the node's leader rcu_data.
+ */
+static int rcu_nocb_kthread(void *arg)
+{
+	bool gotcbs;
+	struct rcu_data *rdp;
+	struct rcu_data *my_rdp = arg;
 
 	/* Each pass through this loop invokes one batch of callbacks */
 	for (;;) {
 		/* If not polling, wait for next batch of callbacks. */
 		if (!rcu_nocb_poll)
-			wait_event_interruptible(rdp->nocb_wq, rdp->nocb_head);
-		list = ACCESS_ONCE(rdp->nocb_head);
-		if (!list) {
+			wait_event_interruptible(my_rdp->nocb_wq,
+					rcu_nocb_node_has_cbs(my_rdp));
+
+		/*
+		 * Extract queued callbacks from each of the node's CPUs,
+		 * update counts, and wait for a grace period to elapse.
+		 */
+		gotcbs = false;
+		for (rdp = my_rdp; rdp; rdp = rdp->nocb_next_follower)
+			if (rcu_nocb_pull_cbs(rdp))
+				gotcbs = true;
+		if (!gotcbs) {
 			schedule_timeout_interruptible(1);
 			flush_signals(current);
 			continue;
 		}
+		rcu_nocb_wait_gp(my_rdp);
 
-		/*
-		 * Extract queued callbacks, update counts, and wait
-		 * for a grace period to elapse.
-		 */
-		ACCESS_ONCE(rdp->nocb_head) = NULL;
-		tail = xchg(&rdp->nocb_tail, &rdp->nocb_head);
-		c = atomic_long_xchg(&rdp->nocb_q_count, 0);
-		cl = atomic_long_xchg(&rdp->nocb_q_count_lazy, 0);
-		ACCESS_ONCE(rdp->nocb_p_count) += c;
-		ACCESS_ONCE(rdp->nocb_p_count_lazy) += cl;
-		rcu_nocb_wait_gp(rdp);
-
-		/* Each pass through the following loop invokes a callback. */
-		trace_rcu_batch_start(rdp->rsp->name, cl, c, -1);
-		c = cl = 0;
-		while (list) {
-			next = list->next;
-			/* Wait for enqueuing to complete, if needed. */
-			while (next == NULL && &list->next != tail) {
-				schedule_timeout_interruptible(1);
-				next = list->next;
-			}
-			debug_rcu_head_unqueue(list);
-			local_bh_disable();
-			if (__rcu_reclaim(rdp->rsp->name, list))
-				cl++;
-			c++;
-			local_bh_enable();
-			list = next;
-		}
-		trace_rcu_batch_end(rdp->rsp->name, c, !!list, 0, 0, 1);
-		ACCESS_ONCE(rdp->nocb_p_count) -= c;
-		ACCESS_ONCE(rdp->nocb_p_count_lazy) -= cl;
-		rdp->n_nocbs_invoked += c;
+		for (rdp = my_rdp; rdp; rdp = rdp->nocb_next_follower)
+			if (rdp->nocb_gp_head)
+				rcu_nocb_invoke_cbs(rdp);
 	}
 	return 0;
 }
@@ -2260,24 +2351,80 @@ static void __init rcu_boot_init_nocb_percpu_data(struct rcu_data *rdp)
 	init_waitqueue_head(&rdp->nocb_wq);
 }
 
-/* Create a kthread for each RCU flavor for each no-CBs CPU. */
+/*
+ * Create a kthread for each RCU flavor for each node with no-CBs CPUs,
+ * chaining each node's no-CBs CPUs behind the first of them.
+ */
 static void __init rcu_spawn_nocb_kthreads(struct rcu_state *rsp)
 {
 	int cpu;
+	int nid;
 	struct rcu_data *rdp;
+	struct rcu_data *rdp_leader;
+	struct rcu_data *rdp_prev;
 	struct task_struct *t;
 
 	if (rcu_nocb_mask == NULL)
 		return;
-	for_each_cpu(cpu, rcu_nocb_mask) {
-		rdp = per_cpu_ptr(rsp->rda, cpu);
-		t = kthread_run(rcu_nocb_kthread, rdp,
-				"rcuo%c/%d", rsp->abbr, cpu);
+	for_each_node(nid) {
+		rdp_leader = rdp_prev = NULL;
+		for_each_cpu(cpu, rcu_nocb_mask) {
+			if (cpu_to_node(cpu) != nid)
+				continue;
+			rdp = per_cpu_ptr(rsp->rda, cpu);
+			if (rdp_leader == NULL)
+				rdp_leader = rdp;
+			else
+				rdp_prev->nocb_next_follower = rdp;
+			rdp->nocb_leader = rdp_leader;
+			rdp_prev = rdp;
+		}
+		if (rdp_leader == NULL)
+			continue;
+		t = kthread_run(rcu_nocb_kthread, rdp_leader,
+				"rcuo%c/n%d", rsp->abbr, nid);
 		BUG_ON(IS_ERR(t));
-		ACCESS_ONCE(rdp->nocb_kthread) = t;
+		for (rdp = rdp_leader; rdp; rdp = rdp->nocb_next_follower)
+			ACCESS_ONCE(rdp->nocb_kthread) = t;
 	}
 }
 
+/*
+ * Confine the offload kthreads to the rcu_nocb_kthread_cpus= CPUs, those
+ * on the kthread's own node if there are any.  This has to wait until
+ * the other CPUs are up, so cannot be done at spawn time.
+ */
+static int __init rcu_nocb_affine_kthreads(void)
+{
+	int cpu;
+	cpumask_var_t cm;
+	struct rcu_data *rdp;
+	struct rcu_state *rsp;
+
+	if (!have_rcu_nocb_mask || !have_rcu_nocb_kthread_mask ||
+	    !cpumask_intersects(rcu_nocb_kthread_mask, cpu_online_mask))
+		return 0;
+	if (!alloc_cpumask_var(&cm, GFP_KERNEL))
+		return -ENOMEM;
+	for_each_rcu_flavor(rsp) {
+		for_each_cpu(cpu, rcu_nocb_mask) {
+			rdp = per_cpu_ptr(rsp->rda, cpu);
+			if (rdp->nocb_leader != rdp || !rdp->nocb_kthread)
+				continue;
+			cpumask_and(cm, rcu_nocb_kthread_mask,
+				    cpumask_of_node(cpu_to_node(cpu)));
+			if (!cpumask_intersects(cm, cpu_online_mask))
+				cpumask_copy(cm, rcu_nocb_kthread_mask);
+			if (set_cpus_allowed_ptr(rdp->nocb_kthread, cm))
+				pr_warn("RCU: Could not set affinity of %s\n",
+					rdp->nocb_kthread->comm);
+		}
+	}
+	free_cpumask_var(cm);
+	return 0;
+}
+core_initcall(rcu_nocb_affine_kthreads);
+
 /* Prevent __call_rcu() from enqueuing callbacks on no-CBs CPUs */
 static bool init_nocb_callback_list(struct rcu_data *rdp)
 {
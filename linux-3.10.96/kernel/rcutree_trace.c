@@ -177,22 +177,69 @@ static const struct file_operations rcudata_fops = {
 	.release = seq_release,
 };
 
+#ifdef CONFIG_RCU_NOCB_CPU
+
+/*
+ * Per-CPU state of callback offloading: the node and leader CPU whose
+ * kthread serves this CPU, the callbacks queued for the kthread (q) and
+ * being waited on or invoked by it (p), and how it has invoked them.
+ */
+static void print_one_rcu_nocb(struct seq_file *m, struct rcu_data *rdp)
+{
+	if (!rdp->nocb_leader)
+		return;
+	seq_printf(m, "%3d%cn=%d l=%d q=%ld/%ld p=%d/%d",
+		   rdp->cpu,
+		   cpu_is_offline(rdp->cpu) ? '!' : ' ',
+		   cpu_to_node(rdp->cpu), rdp->nocb_leader->cpu,
+		   atomic_long_read(&rdp->nocb_q_count_lazy),
+		   atomic_long_read(&rdp->nocb_q_count),
+		   rdp->nocb_p_count_lazy, rdp->nocb_p_count);
+	seq_printf(m, " nci=%lu nb=%lu mb=%ld\n",
+		   rdp->n_nocbs_invoked, rdp->n_nocb_batches,
+		   rdp->nocb_max_batch);
+}
+
+static int show_rcu_nocb(struct seq_file *m, void *v)
+{
+	print_one_rcu_nocb(m, (struct rcu_data *)v);
+	return 0;
+}
+
+static const struct seq_operations rcu_nocb_op = {
+	.start = r_start,
+	.next  = r_next,
+	.stop  = r_stop,
+	.show  = show_rcu_nocb,
+};
+
+static int rcu_nocb_open(struct inode *inode, struct file *file)
+{
+	return r_open(inode, file, &rcu_nocb_op);
+}
+
+static const struct file_operations rcu_nocb_fops = {
+	.owner = THIS_MODULE,
+	.open = rcu_nocb_open,
+	.read = seq_read,
+	.llseek = no_llseek,
+	.release = seq_release,
+};
+
+#endif /* #ifdef CONFIG_RCU_NOCB_CPU */
+
 static int show_rcuexp(struct seq_file *m, void *v)
 {
 	struct rcu_state *rsp = (struct rcu_state *)m->private;
 
-	seq_printf(m, "s=%lu d=%lu w=%lu tf=%lu wd1=%lu wd2=%lu n=%lu sc=%lu dt=%lu dl=%lu dx=%lu\n",
+	seq_printf(m, "s=%lu d=%lu w=%lu wd=%lu gp=%lu ipi=%lu qs=%lu\n",
 		   atomic_long_read(&rsp->expedited_start),
 		   atomic_long_read(&rsp->expedited_done),
 		   atomic_long_read(&rsp->expedited_wrap),
-		   atomic_long_read(&rsp->expedited_tryfail),
-		   atomic_long_read(&rsp->expedited_workdone1),
-		   atomic_long_read(&rsp->expedited_workdone2),
-		   atomic_long_read(&rsp->expedited_normal),
-		   atomic_long_read(&rsp->expedited_stoppedcpus),
-		   atomic_long_read(&rsp->expedited_done_tries),
-		   atomic_long_read(&rsp->expedited_done_lost),
-		   atomic_long_read(&rsp->expedited_done_exit));
+		   atomic_long_read(&rsp->expedited_workdone),
+		   atomic_long_read(&rsp->expedited_gps),
+		   atomic_long_read(&rsp->expedited_ipis),
+		   atomic_long_read(&rsp->expedited_idle));
 	return 0;
 }
 
@@ -456,6 +503,13 @@ static int __init rcutree_trace_init(void)
 		if (!retval)
 			goto free_out;
 
+#ifdef CONFIG_RCU_NOCB_CPU
+		retval = debugfs_create_file("rcu_nocb", 0444,
+				rspdir, rsp, &rcu_nocb_fops);
+		if (!retval)
+			goto free_out;
+#endif
+
 #ifdef CONFIG_RCU_BOOST
 		if (rsp == &rcu_preempt_state) {
 			retval = debugfs_create_file("rcuboost", 0444,
@@ -14,7 +14,9 @@
 #include <linux/export.h>
 #include <linux/sched.h>
 #include <linux/sched/rt.h>
+#include <linux/sched/deadline.h>
 #include <linux/timer.h>
+#include <linux/lock_profile.h>
 
 #include "rtmutex_common.h"
 
@@ -148,14 +150,24 @@ static inline bool unlock_rt_mutex_safe(struct rt_mutex *lock)
  *
  * Return task->normal_prio when the waiter list is empty or when
  * the waiter is not allowed to do priority boosting
+ *
+ * There is no deadline inheritance: a -deadline waiter boosts a
+ * !-deadline owner to the highest RT priority only, since the owner
+ * has no reservation whose runtime and deadline could be inherited.
  */
 int rt_mutex_getprio(struct task_struct *task)
 {
+	int prio;
+
 	if (likely(!task_has_pi_waiters(task)))
 		return task->normal_prio;
 
-	return min(task_top_pi_waiter(task)->pi_list_entry.prio,
+	prio = min(task_top_pi_waiter(task)->pi_list_entry.prio,
 		   task->normal_prio);
+	if (dl_prio(prio) && !dl_prio(task->normal_prio))
+		prio = MAX_DL_PRIO;
+
+	return prio;
 }
 
 /*
@@ -930,6 +942,12 @@ rt_mutex_fastlock(struct rt_mutex *lock, int state,
 	if (!detect_deadlock && likely(rt_mutex_cmpxchg(lock, NULL, current))) {
 		rt_mutex_deadlock_account_lock(lock, current);
 		return 0;
+	} else if (lock_profile_active()) {
+		u64 start = lock_profile_clock();
+		int ret = slowfn(lock, state, NULL, detect_deadlock);
+
+		lock_profile_contended("rt_mutex_lock", lock, _RET_IP_, start);
+		return ret;
 	} else
 		return slowfn(lock, state, NULL, detect_deadlock);
 }
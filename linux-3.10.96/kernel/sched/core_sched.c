@@ -0,0 +1,199 @@
+/*
+ * Core scheduling cookies
+ *
+ * A cookie is the address of a refcounted struct sched_core_cookie; tasks
+ * holding the same one may run concurrently on the SMT siblings of a core,
+ * see the core scheduling notes in core.c.  Cookies are set through
+ * prctl(PR_SCHED_CORE) and inherited across fork().
+ */
+#include "sched.h"
+
+#include <linux/prctl.h>
+#include <linux/ptrace.h>
+#include <linux/random.h>
+#include <linux/hash.h>
+#include <linux/slab.h>
+#include <linux/pid.h>
+
+#include <asm/uaccess.h>
+
+struct sched_core_cookie {
+	atomic_t refcnt;
+};
+
+/* keeps PR_SCHED_CORE_GET from handing kernel addresses to userspace */
+static unsigned long sched_core_secret __read_mostly;
+
+static unsigned long sched_core_alloc_cookie(void)
+{
+	struct sched_core_cookie *ck = kmalloc(sizeof(*ck), GFP_KERNEL);
+
+	if (!ck)
+		return 0;
+
+	atomic_set(&ck->refcnt, 1);
+	sched_core_get();
+
+	return (unsigned long)ck;
+}
+
+static void sched_core_put_cookie(unsigned long cookie)
+{
+	struct sched_core_cookie *ck = (void *)cookie;
+
+	if (ck && atomic_dec_and_test(&ck->refcnt)) {
+		kfree(ck);
+		sched_core_put();
+	}
+}
+
+static unsigned long sched_core_get_cookie(unsigned long cookie)
+{
+	struct sched_core_cookie *ck = (void *)cookie;
+
+	if (ck)
+		atomic_inc(&ck->refcnt);
+
+	return cookie;
+}
+
+/*
+ * The prctl cookie of @p, with a reference.  Cookies are swapped under
+ * p->pi_lock, see sched_core_swap_cookie().
+ */
+static unsigned long sched_core_clone_cookie(struct task_struct *p)
+{
+	unsigned long cookie, flags;
+
+	raw_spin_lock_irqsave(&p->pi_lock, flags);
+	cookie = sched_core_get_cookie(p->core_task_cookie);
+	raw_spin_unlock_irqrestore(&p->pi_lock, flags);
+
+	return cookie;
+}
+
+static void __sched_core_set(struct task_struct *p, unsigned long cookie)
+{
+	cookie = sched_core_get_cookie(cookie);
+	cookie = sched_core_swap_cookie(p, cookie);
+	sched_core_put_cookie(cookie);
+}
+
+void sched_core_fork(struct task_struct *p)
+{
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&current->pi_lock, flags);
+	p->core_task_cookie = sched_core_get_cookie(current->core_task_cookie);
+	p->core_cookie = current->core_cookie;
+	raw_spin_unlock_irqrestore(&current->pi_lock, flags);
+}
+
+void sched_core_free(struct task_struct *p)
+{
+	sched_core_put_cookie(p->core_task_cookie);
+}
+
+int sched_core_share_pid(unsigned int cmd, pid_t pid, int scope,
+			 unsigned long uaddr)
+{
+	unsigned long cookie = 0, id = 0;
+	struct task_struct *task, *p;
+	struct pid *grp;
+	int err = 0;
+
+	if (cmd >= PR_SCHED_CORE_MAX)
+		return -EINVAL;
+	if (scope != PR_SCHED_CORE_SCOPE_THREAD &&
+	    scope != PR_SCHED_CORE_SCOPE_THREAD_GROUP &&
+	    scope != PR_SCHED_CORE_SCOPE_PROCESS_GROUP)
+		return -EINVAL;
+	if (cmd == PR_SCHED_CORE_GET) {
+		if (scope != PR_SCHED_CORE_SCOPE_THREAD || !uaddr)
+			return -EINVAL;
+	} else if (uaddr) {
+		return -EINVAL;
+	}
+
+	rcu_read_lock();
+	task = pid ? find_task_by_vpid(pid) : current;
+	if (!task) {
+		rcu_read_unlock();
+		return -ESRCH;
+	}
+	get_task_struct(task);
+	rcu_read_unlock();
+
+	/*
+	 * Check if this process has the right to modify the specified
+	 * process. Use the regular "ptrace_may_access()" checks.
+	 */
+	if (!ptrace_may_access(task, PTRACE_MODE_READ)) {
+		err = -EPERM;
+		goto out;
+	}
+
+	switch (cmd) {
+	case PR_SCHED_CORE_GET:
+		cookie = sched_core_clone_cookie(task);
+		if (cookie)
+			id = hash_long(cookie ^ sched_core_secret, BITS_PER_LONG);
+		sched_core_put_cookie(cookie);
+		err = put_user(id, (unsigned long __user *)uaddr);
+		goto out;
+
+	case PR_SCHED_CORE_CREATE:
+		cookie = sched_core_alloc_cookie();
+		if (!cookie) {
+			err = -ENOMEM;
+			goto out;
+		}
+		break;
+
+	case PR_SCHED_CORE_SHARE_TO:
+		cookie = sched_core_clone_cookie(current);
+		break;
+
+	case PR_SCHED_CORE_SHARE_FROM:
+		if (scope != PR_SCHED_CORE_SCOPE_THREAD) {
+			err = -EINVAL;
+			goto out;
+		}
+		cookie = sched_core_clone_cookie(task);
+		__sched_core_set(current, cookie);
+		goto out_put;
+	}
+
+	rcu_read_lock();
+	if (scope == PR_SCHED_CORE_SCOPE_THREAD) {
+		__sched_core_set(task, cookie);
+	} else if (scope == PR_SCHED_CORE_SCOPE_THREAD_GROUP) {
+		p = task;
+		do {
+			__sched_core_set(p, cookie);
+		} while_each_thread(task, p);
+	} else {
+		grp = task_pgrp(task);
+		do_each_pid_thread(grp, PIDTYPE_PGID, p) {
+			if (!ptrace_may_access(p, PTRACE_MODE_READ)) {
+				err = -EPERM;
+				goto out_unlock;
+			}
+			__sched_core_set(p, cookie);
+		} while_each_pid_thread(grp, PIDTYPE_PGID, p);
+	}
+out_unlock:
+	rcu_read_unlock();
+out_put:
+	sched_core_put_cookie(cookie);
+out:
+	put_task_struct(task);
+	return err;
+}
+
+static int __init sched_core_secret_init(void)
+{
+	get_random_bytes(&sched_core_secret, sizeof(sched_core_secret));
+	return 0;
+}
+late_initcall(sched_core_secret_init);
@@ -2094,25 +2094,64 @@ static inline u64 sched_cfs_bandwidth_slice(void)
 	return (u64)sysctl_sched_cfs_bandwidth_slice * NSEC_PER_USEC;
 }
 
+/* smallest slice handed out once the bandwidth pool runs low */
+static const u64 min_cfs_rq_slice = 1 * NSEC_PER_MSEC;
+
 /*
  * Replenish runtime according to assigned quota and update expiration time.
  * We use sched_clock_cpu directly instead of rq->clock to avoid adding
  * additional synchronization around rq->lock.
  *
+ * Quota left unused carries over into later periods, up to quota + burst,
+ * so a group whose average stays within its quota can absorb short spikes
+ * without being throttled.  Whatever the last period consumed beyond its
+ * own quota was paid from that reserve and is accounted as a burst.
+ *
  * requires cfs_b->lock
  */
 void __refill_cfs_bandwidth_runtime(struct cfs_bandwidth *cfs_b)
 {
 	u64 now;
+	s64 burst;
 
 	if (cfs_b->quota == RUNTIME_INF)
 		return;
 
 	now = sched_clock_cpu(smp_processor_id());
-	cfs_b->runtime = cfs_b->quota;
+
+	cfs_b->runtime += cfs_b->quota;
+	burst = cfs_b->runtime_snap - cfs_b->runtime;
+	if (burst > 0) {
+		cfs_b->burst_time += burst;
+		cfs_b->nr_burst++;
+	}
+
+	cfs_b->runtime = min(cfs_b->runtime, cfs_b->quota + cfs_b->burst);
+	cfs_b->runtime_snap = cfs_b->runtime;
 	cfs_b->runtime_expires = now + ktime_to_ns(cfs_b->period);
 }
 
+/*
+ * Size of the slice a cfs_rq pulls from the global pool.  While the pool
+ * is comfortably large this is the bandwidth slice.  Once it holds less
+ * than a slice per online cpu, shrink the slice to a fair share of what is
+ * left so that one cpu can't grab the tail of the quota while its siblings
+ * get throttled.
+ *
+ * requires cfs_b->lock
+ */
+static u64 cfs_rq_runtime_slice(struct cfs_bandwidth *cfs_b)
+{
+	u64 slice = sched_cfs_bandwidth_slice();
+	unsigned int nr = num_online_cpus();
+
+	if (cfs_b->runtime < slice * nr)
+		slice = clamp_t(u64, div_u64(cfs_b->runtime, nr),
+				min_cfs_rq_slice, slice);
+
+	return slice;
+}
+
 static inline struct cfs_bandwidth *tg_cfs_bandwidth(struct task_group *tg)
 {
 	return &tg->cfs_bandwidth;
@@ -2134,13 +2173,11 @@ static int assign_cfs_rq_runtime(struct cfs_rq *cfs_rq)
 	struct cfs_bandwidth *cfs_b = tg_cfs_bandwidth(tg);
 	u64 amount = 0, min_amount, expires;
 
-	/* note: this is a positive sum as runtime_remaining <= 0 */
-	min_amount = sched_cfs_bandwidth_slice() - cfs_rq->runtime_remaining;
-
 	raw_spin_lock(&cfs_b->lock);
-	if (cfs_b->quota == RUNTIME_INF)
-		amount = min_amount;
-	else {
+	if (cfs_b->quota == RUNTIME_INF) {
+		/* note: this is a positive sum as runtime_remaining <= 0 */
+		amount = sched_cfs_bandwidth_slice() - cfs_rq->runtime_remaining;
+	} else {
 		/*
 		 * If the bandwidth pool has become inactive, then at least one
 		 * period must have elapsed since the last consumption.
@@ -2153,6 +2190,8 @@ static int assign_cfs_rq_runtime(struct cfs_rq *cfs_rq)
 		}
 
 		if (cfs_b->runtime > 0) {
+			min_amount = cfs_rq_runtime_slice(cfs_b) -
+				     cfs_rq->runtime_remaining;
 			amount = min(cfs_b->runtime, min_amount);
 			cfs_b->runtime -= amount;
 			cfs_b->idle = 0;
@@ -2390,7 +2429,7 @@ static u64 distribute_cfs_runtime(struct cfs_bandwidth *cfs_b,
 				throttled_list) {
 		struct rq *rq = rq_of(cfs_rq);
 
-		raw_spin_lock(&rq->lock);
+		raw_spin_rq_lock(rq);
 		if (!cfs_rq_throttled(cfs_rq))
 			goto next;
 
@@ -2407,7 +2446,7 @@ static u64 distribute_cfs_runtime(struct cfs_bandwidth *cfs_b,
 			unthrottle_cfs_rq(cfs_rq);
 
 next:
-		raw_spin_unlock(&rq->lock);
+		raw_spin_rq_unlock(rq);
 
 		if (!remaining)
 			break;
@@ -2697,6 +2736,7 @@ void init_cfs_bandwidth(struct cfs_bandwidth *cfs_b)
 	raw_spin_lock_init(&cfs_b->lock);
 	cfs_b->runtime = 0;
 	cfs_b->quota = RUNTIME_INF;
+	cfs_b->burst = 0;
 	cfs_b->period = ns_to_ktime(default_cfs_period());
 
 	INIT_LIST_HEAD(&cfs_b->throttled_cfs_rq);
@@ -3340,13 +3380,173 @@ find_idlest_cpu(struct sched_group *group, struct task_struct *p, int this_cpu)
 	return idlest;
 }
 
+#ifdef CONFIG_SCHED_SMT
+static inline int core_is_idle(int core)
+{
+	int cpu;
+
+	for_each_cpu(cpu, topology_thread_cpumask(core)) {
+		if (!idle_cpu(cpu))
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * Called from pick_next_task_idle(): if all SMT siblings of this cpu are
+ * idle as well, advertise the core in the LLC idle core mask. rq->curr is
+ * still the previous task here, hence this cpu is skipped in the check.
+ */
+void update_idle_core(struct rq *rq)
+{
+	struct sched_domain_shared *sds;
+	int core = cpu_of(rq);
+	int cpu;
+
+	rcu_read_lock();
+	sds = rcu_dereference(per_cpu(sd_llc_shared, core));
+	if (!sds || cpumask_test_cpu(core, sds_idle_cores(sds)))
+		goto unlock;
+
+	for_each_cpu(cpu, topology_thread_cpumask(core)) {
+		if (cpu == core)
+			continue;
+		if (!idle_cpu(cpu))
+			goto unlock;
+	}
+	cpumask_set_cpu(core, sds_idle_cores(sds));
+unlock:
+	rcu_read_unlock();
+}
+
+/*
+ * Scan the LLC idle core mask for a core whose siblings are all idle.
+ * Entries that turn out to be stale are dropped from the mask, so the cost
+ * of a failed search is paid once per core that went busy rather than on
+ * every wakeup.
+ */
+static int select_idle_core(struct task_struct *p, struct sched_domain *sd,
+			    int target)
+{
+	struct cpumask *idle_cores;
+	int core;
+
+	if (!sd->shared)
+		return -1;
+
+	idle_cores = sds_idle_cores(sd->shared);
+	for_each_cpu_and(core, idle_cores, tsk_cpus_allowed(p)) {
+		schedstat_inc(this_rq(), sis_scanned);
+		if (core_is_idle(core)) {
+			schedstat_inc(this_rq(), sis_idle_core);
+			return core;
+		}
+		cpumask_clear_cpu(core, idle_cores);
+	}
+
+	return -1;
+}
+
+/*
+ * No whole idle core, try an idle SMT sibling of the target.
+ */
+static int select_idle_smt(struct task_struct *p, int target)
+{
+	int cpu;
+
+	for_each_cpu(cpu, topology_thread_cpumask(target)) {
+		if (!cpumask_test_cpu(cpu, tsk_cpus_allowed(p)))
+			continue;
+		if (idle_cpu(cpu))
+			return cpu;
+	}
+
+	return -1;
+}
+#else /* !CONFIG_SCHED_SMT */
+static inline int select_idle_core(struct task_struct *p,
+				   struct sched_domain *sd, int target)
+{
+	return -1;
+}
+
+static inline int select_idle_smt(struct task_struct *p, int target)
+{
+	return -1;
+}
+#endif /* CONFIG_SCHED_SMT */
+
+/*
+ * Look for any idle cpu in the LLC domain, starting right after the target
+ * and wrapping around. The number of cpus visited is proportional to how
+ * long this cpu is expected to stay idle compared to what a scan has cost
+ * on average, so that busy systems do not burn their wakeup latency on a
+ * search that is unlikely to succeed.
+ */
+static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd,
+			   int target)
+{
+	struct sched_domain *this_sd;
+	const struct cpumask *span = sched_domain_span(sd);
+	u64 avg_cost, avg_idle;
+	u64 time, cost;
+	s64 delta;
+	int cpu, nr = INT_MAX;
+
+	this_sd = rcu_dereference(*this_cpu_ptr(&sd_llc));
+	if (!this_sd)
+		return -1;
+
+	/*
+	 * Due to large variance we need a large fuzz factor; hackbench in
+	 * particular is sensitive here.
+	 */
+	avg_idle = this_rq()->avg_idle / 512;
+	avg_cost = this_sd->avg_scan_cost + 1;
+
+	if (sched_feat(SIS_AVG_CPU) && avg_idle < avg_cost)
+		return -1;
+
+	if (sched_feat(SIS_PROP)) {
+		u64 span_avg = sd->span_weight * avg_idle;
+		if (span_avg > 4 * avg_cost)
+			nr = div64_u64(span_avg, avg_cost);
+		else
+			nr = 4;
+	}
+
+	time = local_clock();
+
+	cpu = target;
+	for (;;) {
+		cpu = cpumask_next(cpu, span);
+		if (cpu >= nr_cpu_ids)
+			cpu = cpumask_first(span);
+		if (cpu == target || !nr--) {
+			cpu = -1;
+			break;
+		}
+		schedstat_inc(this_rq(), sis_scanned);
+		if (!cpumask_test_cpu(cpu, tsk_cpus_allowed(p)))
+			continue;
+		if (idle_cpu(cpu))
+			break;
+	}
+
+	time = local_clock() - time;
+	cost = this_sd->avg_scan_cost;
+	delta = (s64)(time - cost) / 8;
+	this_sd->avg_scan_cost += delta;
+
+	return cpu;
+}
+
 /*
  * Try and locate an idle CPU in the sched_domain.
  */
 static int select_idle_sibling(struct task_struct *p, int target)
 {
 	struct sched_domain *sd;
-	struct sched_group *sg;
 	int i = task_cpu(p);
 
 	if (idle_cpu(target))
@@ -3358,30 +3558,29 @@ static int select_idle_sibling(struct task_struct *p, int target)
 	if (i != target && cpus_share_cache(i, target) && idle_cpu(i))
 		return i;
 
+	sd = rcu_dereference(per_cpu(sd_llc, target));
+	if (!sd)
+		return target;
+
+	schedstat_inc(this_rq(), sis_search);
+
 	/*
-	 * Otherwise, iterate the domains and find an elegible idle cpu.
+	 * Prefer a fully idle core, then an idle sibling of the target, and
+	 * finally any idle cpu the bounded LLC scan can find.
 	 */
-	sd = rcu_dereference(per_cpu(sd_llc, target));
-	for_each_lower_domain(sd) {
-		sg = sd->groups;
-		do {
-			if (!cpumask_intersects(sched_group_cpus(sg),
-						tsk_cpus_allowed(p)))
-				goto next;
+	i = select_idle_core(p, sd, target);
+	if ((unsigned)i < nr_cpumask_bits)
+		return i;
 
-			for_each_cpu(i, sched_group_cpus(sg)) {
-				if (i == target || !idle_cpu(i))
-					goto next;
-			}
+	i = select_idle_smt(p, target);
+	if ((unsigned)i < nr_cpumask_bits)
+		return i;
 
-			target = cpumask_first_and(sched_group_cpus(sg),
-					tsk_cpus_allowed(p));
-			goto done;
-next:
-			sg = sg->next;
-		} while (sg != sd->groups);
-	}
-done:
+	i = select_idle_cpu(p, sd, target);
+	if ((unsigned)i < nr_cpumask_bits)
+		return i;
+
+	schedstat_inc(this_rq(), sis_failed);
 	return target;
 }
 
@@ -3708,6 +3907,40 @@ static struct task_struct *pick_next_task_fair(struct rq *rq)
 	return p;
 }
 
+#ifdef CONFIG_SCHED_CORE
+/*
+ * Like pick_next_task_fair() but setting nothing: the rq may be a sibling
+ * with its current task still set, and that one isn't in the tree.
+ */
+static struct task_struct *pick_task_fair(struct rq *rq)
+{
+	struct cfs_rq *cfs_rq = &rq->cfs;
+	struct sched_entity *se;
+
+	if (!cfs_rq->nr_running)
+		return NULL;
+
+	do {
+		struct sched_entity *curr = cfs_rq->curr;
+
+		if (curr && curr->on_rq)
+			update_curr(cfs_rq);
+		else
+			curr = NULL;
+
+		se = __pick_first_entity(cfs_rq);
+		if (!se || (curr && entity_before(curr, se)))
+			se = curr;
+		if (!se)
+			return NULL;
+
+		cfs_rq = group_cfs_rq(se);
+	} while (cfs_rq);
+
+	return task_of(se);
+}
+#endif
+
 /*
  * Account for a descheduled task:
  */
@@ -4195,7 +4428,7 @@ static void update_blocked_averages(int cpu)
 	struct cfs_rq *cfs_rq;
 	unsigned long flags;
 
-	raw_spin_lock_irqsave(&rq->lock, flags);
+	raw_spin_rq_lock_irqsave(rq, flags);
 	update_rq_clock(rq);
 	/*
 	 * Iterates the task_group tree in a bottom up fashion, see
@@ -4210,7 +4443,7 @@ static void update_blocked_averages(int cpu)
 		__update_blocked_averages_cpu(cfs_rq->tg, rq->cpu);
 	}
 
-	raw_spin_unlock_irqrestore(&rq->lock, flags);
+	raw_spin_rq_unlock_irqrestore(rq, flags);
 }
 
 /*
@@ -5240,7 +5473,7 @@ more_balance:
 			sd->nr_balance_failed++;
 
 		if (need_active_balance(&env)) {
-			raw_spin_lock_irqsave(&busiest->lock, flags);
+			raw_spin_rq_lock_irqsave(busiest, flags);
 
 			/* don't kick the active_load_balance_cpu_stop,
 			 * if the curr task on busiest cpu can't be
@@ -5248,7 +5481,7 @@ more_balance:
 			 */
 			if (!cpumask_test_cpu(this_cpu,
 					tsk_cpus_allowed(busiest->curr))) {
-				raw_spin_unlock_irqrestore(&busiest->lock,
+				raw_spin_rq_unlock_irqrestore(busiest,
 							    flags);
 				env.flags |= LBF_ALL_PINNED;
 				goto out_one_pinned;
@@ -5264,7 +5497,7 @@ more_balance:
 				busiest->push_cpu = this_cpu;
 				active_balance = 1;
 			}
-			raw_spin_unlock_irqrestore(&busiest->lock, flags);
+			raw_spin_rq_unlock_irqrestore(busiest, flags);
 
 			if (active_balance) {
 				stop_one_cpu_nowait(cpu_of(busiest),
@@ -5332,7 +5565,7 @@ void idle_balance(int this_cpu, struct rq *this_rq)
 	/*
 	 * Drop the rq->lock, but keep IRQ/preempt disabled.
 	 */
-	raw_spin_unlock(&this_rq->lock);
+	raw_spin_rq_unlock(this_rq);
 
 	update_blocked_averages(this_cpu);
 	rcu_read_lock();
@@ -5359,7 +5592,7 @@ void idle_balance(int this_cpu, struct rq *this_rq)
 	}
 	rcu_read_unlock();
 
-	raw_spin_lock(&this_rq->lock);
+	raw_spin_rq_lock(this_rq);
 
 	if (pulled_task || time_after(jiffies, this_rq->next_balance)) {
 		/*
@@ -5384,7 +5617,7 @@ static int active_load_balance_cpu_stop(void *data)
 	struct rq *target_rq = cpu_rq(target_cpu);
 	struct sched_domain *sd;
 
-	raw_spin_lock_irq(&busiest_rq->lock);
+	raw_spin_rq_lock_irq(busiest_rq);
 
 	/* make sure the requested cpu hasn't gone down in the meantime */
 	if (unlikely(busiest_cpu != smp_processor_id() ||
@@ -5434,7 +5667,7 @@ static int active_load_balance_cpu_stop(void *data)
 	double_unlock_balance(busiest_rq, target_rq);
 out_unlock:
 	busiest_rq->active_balance = 0;
-	raw_spin_unlock_irq(&busiest_rq->lock);
+	raw_spin_rq_unlock_irq(busiest_rq);
 	return 0;
 }
 
@@ -5684,10 +5917,10 @@ static void nohz_idle_balance(int this_cpu, enum cpu_idle_type idle)
 
 		rq = cpu_rq(balance_cpu);
 
-		raw_spin_lock_irq(&rq->lock);
+		raw_spin_rq_lock_irq(rq);
 		update_rq_clock(rq);
 		update_idle_cpu_load(rq);
-		raw_spin_unlock_irq(&rq->lock);
+		raw_spin_rq_unlock_irq(rq);
 
 		rebalance_domains(balance_cpu, CPU_IDLE);
 
@@ -5824,6 +6057,29 @@ static void rq_offline_fair(struct rq *rq)
 /*
  * scheduler tick hitting a task of our scheduling class:
  */
+#ifdef CONFIG_SCHED_CORE
+/*
+ * With nothing else queued check_preempt_tick() never fires, yet siblings
+ * forced idle by @curr only get the core back through a new core wide
+ * pick: have one after a couple of slices.
+ */
+static void task_tick_core(struct rq *rq, struct task_struct *curr)
+{
+	struct sched_entity *se = &curr->se;
+	u64 delta_exec;
+
+	if (!sched_core_enabled(rq) || !rq->core->core_forceidle ||
+	    rq->cfs.nr_running != 1)
+		return;
+
+	delta_exec = se->sum_exec_runtime - se->prev_sum_exec_runtime;
+	if (delta_exec > 2 * sched_slice(cfs_rq_of(se), se))
+		resched_task(curr);
+}
+#else
+static inline void task_tick_core(struct rq *rq, struct task_struct *curr) { }
+#endif
+
 static void task_tick_fair(struct rq *rq, struct task_struct *curr, int queued)
 {
 	struct cfs_rq *cfs_rq;
@@ -5834,6 +6090,8 @@ static void task_tick_fair(struct rq *rq, struct task_struct *curr, int queued)
 		entity_tick(cfs_rq, se, queued);
 	}
 
+	task_tick_core(rq, curr);
+
 	if (sched_feat_numa(NUMA))
 		task_tick_numa(rq, curr);
 
@@ -5853,7 +6111,7 @@ static void task_fork_fair(struct task_struct *p)
 	struct rq *rq = this_rq();
 	unsigned long flags;
 
-	raw_spin_lock_irqsave(&rq->lock, flags);
+	raw_spin_rq_lock_irqsave(rq, flags);
 
 	update_rq_clock(rq);
 
@@ -5887,7 +6145,7 @@ static void task_fork_fair(struct task_struct *p)
 
 	se->vruntime -= cfs_rq->min_vruntime;
 
-	raw_spin_unlock_irqrestore(&rq->lock, flags);
+	raw_spin_rq_unlock_irqrestore(rq, flags);
 }
 
 /*
@@ -5974,9 +6232,9 @@ static void switched_to_fair(struct rq *rq, struct task_struct *p)
  * This routine is mostly called to set cfs_rq->curr field when a task
  * migrates between groups/classes.
  */
-static void set_curr_task_fair(struct rq *rq)
+static void set_next_task_fair(struct rq *rq, struct task_struct *p)
 {
-	struct sched_entity *se = &rq->curr->se;
+	struct sched_entity *se = &p->se;
 
 	for_each_sched_entity(se) {
 		struct cfs_rq *cfs_rq = cfs_rq_of(se);
@@ -5987,6 +6245,40 @@ static void set_curr_task_fair(struct rq *rq)
 	}
 }
 
+static void set_curr_task_fair(struct rq *rq)
+{
+	set_next_task_fair(rq, rq->curr);
+}
+
+#ifdef CONFIG_SCHED_CORE
+/* a task in a throttled hierarchy can't be picked, whatever its cookie */
+bool fair_task_throttled(struct task_struct *p)
+{
+	return throttled_hierarchy(cfs_rq_of(&p->se));
+}
+
+/*
+ * Order fair tasks of different siblings: vruntimes of different cpus only
+ * compare as lag from a common point, the min_vruntime_fi of their cpu.
+ * True if @b should run rather than @a.
+ */
+bool cfs_prio_less(struct task_struct *a, struct task_struct *b)
+{
+	struct sched_entity *sea = &a->se, *seb = &b->se;
+	s64 delta;
+
+	while (parent_entity(sea))
+		sea = parent_entity(sea);
+	while (parent_entity(seb))
+		seb = parent_entity(seb);
+
+	delta = (s64)(sea->vruntime - task_rq(a)->cfs.min_vruntime_fi) -
+		(s64)(seb->vruntime - task_rq(b)->cfs.min_vruntime_fi);
+
+	return delta > 0;
+}
+#endif
+
 void init_cfs_rq(struct cfs_rq *cfs_rq)
 {
 	cfs_rq->tasks_timeline = RB_ROOT;
@@ -6122,9 +6414,9 @@ void unregister_fair_sched_group(struct task_group *tg, int cpu)
 	if (!tg->cfs_rq[cpu]->on_list)
 		return;
 
-	raw_spin_lock_irqsave(&rq->lock, flags);
+	raw_spin_rq_lock_irqsave(rq, flags);
 	list_del_leaf_cfs_rq(tg->cfs_rq[cpu]);
-	raw_spin_unlock_irqrestore(&rq->lock, flags);
+	raw_spin_rq_unlock_irqrestore(rq, flags);
 }
 
 void init_tg_cfs_entry(struct task_group *tg, struct cfs_rq *cfs_rq,
@@ -6181,10 +6473,10 @@ int sched_group_set_shares(struct task_group *tg, unsigned long shares)
 
 		se = tg->se[i];
 		/* Propagate contribution to hierarchy */
-		raw_spin_lock_irqsave(&rq->lock, flags);
+		raw_spin_rq_lock_irqsave(rq, flags);
 		for_each_sched_entity(se)
 			update_cfs_shares(group_cfs_rq(se));
-		raw_spin_unlock_irqrestore(&rq->lock, flags);
+		raw_spin_rq_unlock_irqrestore(rq, flags);
 	}
 
 done:
@@ -6233,6 +6525,9 @@ const struct sched_class fair_sched_class = {
 	.check_preempt_curr	= check_preempt_wakeup,
 
 	.pick_next_task		= pick_next_task_fair,
+#ifdef CONFIG_SCHED_CORE
+	.pick_task		= pick_task_fair,
+#endif
 	.put_prev_task		= put_prev_task_fair,
 
 #ifdef CONFIG_SMP
@@ -6247,6 +6542,7 @@ const struct sched_class fair_sched_class = {
 #endif
 
 	.set_curr_task          = set_curr_task_fair,
+	.set_next_task          = set_next_task_fair,
 	.task_tick		= task_tick_fair,
 	.task_fork		= task_fork_fair,
 
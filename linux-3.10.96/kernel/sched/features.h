@@ -56,6 +56,14 @@ SCHED_FEAT(NONTASK_POWER, true)
  */
 SCHED_FEAT(TTWU_QUEUE, true)
 
+/*
+ * Bound the LLC idle cpu scan in select_idle_sibling(): SIS_AVG_CPU skips
+ * the scan when the average idle time cannot pay for it, SIS_PROP scans a
+ * number of cpus proportional to avg_idle / avg_scan_cost.
+ */
+SCHED_FEAT(SIS_AVG_CPU, false)
+SCHED_FEAT(SIS_PROP, true)
+
 SCHED_FEAT(FORCE_SD_OVERLAP, false)
 SCHED_FEAT(RT_RUNTIME_SHARE, true)
 SCHED_FEAT(LB_MIN, false)
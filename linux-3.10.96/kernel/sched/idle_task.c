@@ -33,13 +33,25 @@ static void check_preempt_curr_idle(struct rq *rq, struct task_struct *p, int fl
 	resched_task(rq->idle);
 }
 
-static struct task_struct *pick_next_task_idle(struct rq *rq)
+static struct task_struct *pick_task_idle(struct rq *rq)
+{
+	return rq->idle;
+}
+
+static void set_next_task_idle(struct rq *rq, struct task_struct *p)
 {
 	schedstat_inc(rq, sched_goidle);
 #ifdef CONFIG_SMP
 	/* Trigger the post schedule to do an idle_enter for CFS */
 	rq->post_schedule = 1;
+	update_idle_core(rq);
 #endif
+}
+
+static struct task_struct *pick_next_task_idle(struct rq *rq)
+{
+	set_next_task_idle(rq, rq->idle);
+
 	return rq->idle;
 }
 
@@ -50,10 +62,10 @@ static struct task_struct *pick_next_task_idle(struct rq *rq)
 static void
 dequeue_task_idle(struct rq *rq, struct task_struct *p, int flags)
 {
-	raw_spin_unlock_irq(&rq->lock);
+	raw_spin_rq_unlock_irq(rq);
 	printk(KERN_ERR "bad: scheduling from the idle thread!\n");
 	dump_stack();
-	raw_spin_lock_irq(&rq->lock);
+	raw_spin_rq_lock_irq(rq);
 }
 
 static void put_prev_task_idle(struct rq *rq, struct task_struct *prev)
@@ -97,6 +109,9 @@ const struct sched_class idle_sched_class = {
 	.check_preempt_curr	= check_preempt_curr_idle,
 
 	.pick_next_task		= pick_next_task_idle,
+#ifdef CONFIG_SCHED_CORE
+	.pick_task		= pick_task_idle,
+#endif
 	.put_prev_task		= put_prev_task_idle,
 
 #ifdef CONFIG_SMP
@@ -106,6 +121,7 @@ const struct sched_class idle_sched_class = {
 #endif
 
 	.set_curr_task          = set_curr_task_idle,
+	.set_next_task          = set_next_task_idle,
 	.task_tick		= task_tick_idle,
 
 	.get_rr_interval	= get_rr_interval_idle,
@@ -703,9 +703,9 @@ static void disable_runtime(struct rq *rq)
 {
 	unsigned long flags;
 
-	raw_spin_lock_irqsave(&rq->lock, flags);
+	raw_spin_rq_lock_irqsave(rq, flags);
 	__disable_runtime(rq);
-	raw_spin_unlock_irqrestore(&rq->lock, flags);
+	raw_spin_rq_unlock_irqrestore(rq, flags);
 }
 
 static void __enable_runtime(struct rq *rq)
@@ -736,9 +736,9 @@ static void enable_runtime(struct rq *rq)
 {
 	unsigned long flags;
 
-	raw_spin_lock_irqsave(&rq->lock, flags);
+	raw_spin_rq_lock_irqsave(rq, flags);
 	__enable_runtime(rq);
-	raw_spin_unlock_irqrestore(&rq->lock, flags);
+	raw_spin_rq_unlock_irqrestore(rq, flags);
 }
 
 int update_runtime(struct notifier_block *nfb, unsigned long action, void *hcpu)
@@ -809,7 +809,7 @@ static int do_sched_rt_period_timer(struct rt_bandwidth *rt_b, int overrun)
 		struct rt_rq *rt_rq = sched_rt_period_rt_rq(rt_b, i);
 		struct rq *rq = rq_of_rt_rq(rt_rq);
 
-		raw_spin_lock(&rq->lock);
+		raw_spin_rq_lock(rq);
 		if (rt_rq->rt_time) {
 			u64 runtime;
 
@@ -842,7 +842,7 @@ static int do_sched_rt_period_timer(struct rt_bandwidth *rt_b, int overrun)
 
 		if (enqueue)
 			sched_rt_rq_enqueue(rt_rq);
-		raw_spin_unlock(&rq->lock);
+		raw_spin_rq_unlock(rq);
 	}
 
 	if (!throttled && (!rt_bandwidth_enabled() || rt_b->rt_runtime == RUNTIME_INF))
@@ -1378,10 +1378,9 @@ static struct sched_rt_entity *pick_next_rt_entity(struct rq *rq,
 	return next;
 }
 
-static struct task_struct *_pick_next_task_rt(struct rq *rq)
+static struct task_struct *pick_task_rt(struct rq *rq)
 {
 	struct sched_rt_entity *rt_se;
-	struct task_struct *p;
 	struct rt_rq *rt_rq;
 
 	rt_rq = &rq->rt;
@@ -1398,8 +1397,15 @@ static struct task_struct *_pick_next_task_rt(struct rq *rq)
 		rt_rq = group_rt_rq(rt_se);
 	} while (rt_rq);
 
-	p = rt_task_of(rt_se);
-	p->se.exec_start = rq->clock_task;
+	return rt_task_of(rt_se);
+}
+
+static struct task_struct *_pick_next_task_rt(struct rq *rq)
+{
+	struct task_struct *p = pick_task_rt(rq);
+
+	if (p)
+		p->se.exec_start = rq->clock_task;
 
 	return p;
 }
@@ -2047,16 +2053,38 @@ static void task_tick_rt(struct rq *rq, struct task_struct *p, int queued)
 	}
 }
 
-static void set_curr_task_rt(struct rq *rq)
+static void set_next_task_rt(struct rq *rq, struct task_struct *p)
 {
-	struct task_struct *p = rq->curr;
-
 	p->se.exec_start = rq->clock_task;
 
 	/* The running task is never eligible for pushing */
 	dequeue_pushable_task(rq, p);
+
+#ifdef CONFIG_SMP
+	rq->post_schedule = has_pushable_tasks(rq);
+#endif
+}
+
+static void set_curr_task_rt(struct rq *rq)
+{
+	set_next_task_rt(rq, rq->curr);
 }
 
+#ifdef CONFIG_SCHED_CORE
+/* a task below a throttled rt_rq can't be picked, whatever its cookie */
+bool rt_task_throttled(struct task_struct *p)
+{
+	struct sched_rt_entity *rt_se = &p->rt;
+
+	for_each_sched_rt_entity(rt_se) {
+		if (rt_rq_throttled(rt_rq_of_se(rt_se)))
+			return true;
+	}
+
+	return false;
+}
+#endif
+
 static unsigned int get_rr_interval_rt(struct rq *rq, struct task_struct *task)
 {
 	/*
@@ -2077,6 +2105,9 @@ const struct sched_class rt_sched_class = {
 	.check_preempt_curr	= check_preempt_curr_rt,
 
 	.pick_next_task		= pick_next_task_rt,
+#ifdef CONFIG_SCHED_CORE
+	.pick_task		= pick_task_rt,
+#endif
 	.put_prev_task		= put_prev_task_rt,
 
 #ifdef CONFIG_SMP
@@ -2092,6 +2123,7 @@ const struct sched_class rt_sched_class = {
 #endif
 
 	.set_curr_task          = set_curr_task_rt,
+	.set_next_task          = set_next_task_rt,
 	.task_tick		= task_tick_rt,
 
 	.get_rr_interval	= get_rr_interval_rt,
@@ -2,12 +2,15 @@
 #include <linux/sched.h>
 #include <linux/sched/sysctl.h>
 #include <linux/sched/rt.h>
+#include <linux/sched/deadline.h>
 #include <linux/mutex.h>
 #include <linux/spinlock.h>
+#include <linux/static_key.h>
 #include <linux/stop_machine.h>
 #include <linux/tick.h>
 
 #include "cpupri.h"
+#include "cpudeadline.h"
 #include "cpuacct.h"
 
 extern __read_mostly int scheduler_running;
@@ -72,6 +75,18 @@ extern __read_mostly int scheduler_running;
  */
 #define RUNTIME_INF	((u64)~0ULL)
 
+/*
+ * Single value that decides SCHED_DEADLINE internal math precision.
+ * 10 -> just above 1us
+ * 9  -> just above 0.5us
+ */
+#define DL_SCALE (10)
+
+static inline int fair_policy(int policy)
+{
+	return policy == SCHED_NORMAL || policy == SCHED_BATCH;
+}
+
 static inline int rt_policy(int policy)
 {
 	if (policy == SCHED_FIFO || policy == SCHED_RR)
@@ -79,11 +94,30 @@ static inline int rt_policy(int policy)
 	return 0;
 }
 
+static inline int dl_policy(int policy)
+{
+	return unlikely(policy == SCHED_DEADLINE);
+}
+
 static inline int task_has_rt_policy(struct task_struct *p)
 {
 	return rt_policy(p->policy);
 }
 
+static inline int task_has_dl_policy(struct task_struct *p)
+{
+	return dl_policy(p->policy);
+}
+
+/*
+ * Tells if entity @a should preempt entity @b.
+ */
+static inline bool
+dl_entity_preempt(struct sched_dl_entity *a, struct sched_dl_entity *b)
+{
+	return dl_time_before(a->deadline, b->deadline);
+}
+
 /*
  * This is the priority-queue data structure of the RT scheduling class:
  */
@@ -100,8 +134,81 @@ struct rt_bandwidth {
 	struct hrtimer		rt_period_timer;
 };
 
+/*
+ * To keep the bandwidth of -deadline tasks under control we need some
+ * place where:
+ *  - store the maximum -deadline bandwidth of the system;
+ *  - cache the fraction of that bandwidth that is currently allocated.
+ *
+ * This is all done in the data structures below. dl_bandwidth is
+ * similar to the one used for RT-throttling (rt_bandwidth), with the
+ * main difference that, since here we are only interested in admission
+ * control, we do not decrease any runtime while the tasks execute,
+ * neither we need a timer to replenish it.
+ *
+ * With respect to SMP, the bandwidth is given on a per-CPU basis, and
+ * the allocated fraction (dl_bw) is accounted per root domain: a task
+ * is admitted only if the sum of the bandwidths of all the -deadline
+ * tasks in its root domain does not exceed bw times the number of
+ * CPUs spanned by it.
+ */
+struct dl_bandwidth {
+	raw_spinlock_t dl_runtime_lock;
+	u64 dl_runtime;
+	u64 dl_period;
+};
+
+static inline int dl_bandwidth_enabled(void)
+{
+	return sysctl_sched_rt_runtime >= 0;
+}
+
+struct dl_bw {
+	raw_spinlock_t lock;
+	u64 bw, total_bw;
+};
+
+extern struct dl_bw *dl_bw_of(int i);
+
 extern struct mutex sched_domains_mutex;
 
+#ifdef CONFIG_SCHEDSTATS
+/*
+ * log2 latency histograms: bucket 0 counts delays below 1024ns, bucket i
+ * delays in [2^(i-1), 2^i) * 1024ns, and the last one everything longer.
+ */
+#define SCHED_LAT_BUCKETS	24
+
+enum sched_lat_type {
+	SCHED_LAT_WAKEUP,	/* wakeup until first run */
+	SCHED_LAT_RUNQ,		/* any wait on the runqueue, run_delay */
+	NR_SCHED_LAT,
+};
+
+enum sched_lat_class {
+	SCHED_LAT_DL,
+	SCHED_LAT_RT,
+	SCHED_LAT_FAIR,
+	NR_SCHED_LAT_CLASSES,
+};
+
+struct sched_lat_hist {
+	unsigned int bucket[SCHED_LAT_BUCKETS];
+};
+
+struct sched_lat_stats {
+	struct sched_lat_hist hist[NR_SCHED_LAT];
+};
+
+struct rq;
+struct seq_file;
+
+extern void sched_lat_account(struct rq *rq, struct task_struct *p,
+			      enum sched_lat_type type, u64 delta);
+extern void sched_lat_show(struct seq_file *seq, const char *prefix,
+			   const struct sched_lat_hist *hist);
+#endif
+
 #ifdef CONFIG_CGROUP_SCHED
 
 #include <linux/cgroup.h>
@@ -119,14 +226,18 @@ struct cfs_bandwidth {
 	u64 quota, runtime;
 	s64 hierarchal_quota;
 	u64 runtime_expires;
+	/* unused quota a group may carry into later periods */
+	u64 burst;
+	/* runtime right after the last refill, see __refill_cfs_bandwidth_runtime() */
+	u64 runtime_snap;
 
 	int idle, timer_active;
 	struct hrtimer period_timer, slack_timer;
 	struct list_head throttled_cfs_rq;
 
 	/* statistics */
-	int nr_periods, nr_throttled;
-	u64 throttled_time;
+	int nr_periods, nr_throttled, nr_burst;
+	u64 throttled_time, burst_time;
 #endif
 };
 
@@ -184,6 +295,15 @@ struct task_group {//cgroup_create->cpu_cgroup_css_alloc()
 #endif
     //̴
 	struct cfs_bandwidth cfs_bandwidth;
+#ifdef CONFIG_SCHED_CORE
+	/* tasks directly in this group share a core scheduling cookie */
+	unsigned int core_tagged;
+#endif
+
+#ifdef CONFIG_SCHEDSTATS
+	/* latency of the tasks in this group and its children, per cpu */
+	struct sched_lat_stats __percpu *lat_stats;
+#endif
 };
 
 #ifdef CONFIG_FAIR_GROUP_SCHED
@@ -278,6 +398,10 @@ struct cfs_rq {
 	u64 min_vruntime;
 #ifndef CONFIG_64BIT
 	u64 min_vruntime_copy;
+#endif
+#ifdef CONFIG_SCHED_CORE
+	/* min_vruntime when the core last went forced idle, root cfs_rq only */
+	u64 min_vruntime_fi;
 #endif
      /*root ڵ*/
 	struct rb_root tasks_timeline;
@@ -406,6 +530,42 @@ struct rt_rq {
 #endif
 };
 
+/* Deadline class' related fields in a runqueue */
+struct dl_rq {
+	/* runqueue is an rbtree, ordered by deadline */
+	struct rb_root rb_root;
+	struct rb_node *rb_leftmost;
+
+	unsigned long dl_nr_running;
+
+#ifdef CONFIG_SMP
+	/*
+	 * Deadline values of the currently executing and the
+	 * earliest ready task on this rq. Caching these facilitates
+	 * the decision wether or not a ready but not running task
+	 * should migrate somewhere else.
+	 */
+	struct {
+		u64 curr;
+		u64 next;
+	} earliest_dl;
+
+	unsigned long dl_nr_migratory;
+	unsigned long dl_nr_total;
+	int overloaded;
+
+	/*
+	 * Tasks on this rq that can be pushed away. They are kept in
+	 * an rb-tree, ordered by tasks' deadlines, with caching
+	 * of the leftmost (earliest deadline) element.
+	 */
+	struct rb_root pushable_dl_tasks_root;
+	struct rb_node *pushable_dl_tasks_leftmost;
+#else
+	struct dl_bw dl_bw;
+#endif
+};
+
 #ifdef CONFIG_SMP
 
 /*
@@ -429,6 +589,15 @@ struct root_domain {
 	 */
 	cpumask_var_t rto_mask;
 	struct cpupri cpupri;
+
+	/*
+	 * The bit corresponding to a CPU gets set here if such CPU has more
+	 * than one runnable -deadline task (as it is below for RT tasks).
+	 */
+	cpumask_var_t dlo_mask;
+	atomic_t dlo_count;
+	struct dl_bw dl_bw;
+	struct cpudl cpudl;
 };
 
 extern struct root_domain def_root_domain;
@@ -440,11 +609,14 @@ extern struct root_domain def_root_domain;
  *
  * Locking rule: those places that want to lock multiple runqueues
  * (such as the load balancing or the thread migration code), lock
- * acquire operations must be ordered by ascending &runqueue.
+ * acquire operations must be ordered by rq_order_less().
+ *
+ * Always go through rq_lockp() or the raw_spin_rq_*() helpers: with core
+ * scheduling on, the SMT siblings of a core share one lock.
  */
 struct rq {
 	/* runqueue lock: */
-	raw_spinlock_t lock;
+	raw_spinlock_t __lock;
 
 	/*
 	 * nr_running and cpu_load should be in the same cacheline because
@@ -464,6 +636,8 @@ struct rq {
 #endif
 #ifdef CONFIG_NO_HZ_FULL
 	unsigned long last_sched_tick;
+	/* ticks run on our behalf by a housekeeping cpu */
+	unsigned long nr_remote_ticks;
 #endif
 	int skip_clock_update;
 
@@ -477,6 +651,7 @@ struct rq {
     /*ÿcpuϵrqcfs_rq,rt_rqdl_rqȶУĸȶǶcfsȶ*/
 	struct cfs_rq cfs;
 	struct rt_rq rt;
+	struct dl_rq dl;
 
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	/* list of leaf cfs_rq on this cpu: */
@@ -582,12 +757,38 @@ struct rq {
 	/* try_to_wake_up() stats */
 	unsigned int ttwu_count;
 	unsigned int ttwu_local;
+
+	/* select_idle_sibling() stats */
+	unsigned int sis_search;
+	unsigned int sis_scanned;
+	unsigned int sis_idle_core;
+	unsigned int sis_failed;
+
+	/* wakeup and runqueue latency, see sched_lat_account() */
+	struct sched_lat_hist lat_hist[NR_SCHED_LAT][NR_SCHED_LAT_CLASSES];
 #endif
 
 #ifdef CONFIG_SMP
 	struct llist_head wake_list;
 #endif
 
+#ifdef CONFIG_SCHED_CORE
+	/* the leader of our core, whose lock the siblings share */
+	struct rq		*core;
+	/* what the last core wide pick chose for this cpu */
+	struct task_struct	*core_pick;
+	unsigned int		core_enabled;
+	unsigned int		core_sched_seq;
+	/* queued tasks carrying a cookie, ordered by cookie then prio */
+	struct rb_root		core_tree;
+
+	/* core wide state, only used on the leader */
+	unsigned int		core_task_seq;
+	unsigned int		core_pick_seq;
+	unsigned long		core_cookie;
+	unsigned int		core_forceidle;
+#endif
+
 	struct sched_avg avg;
 };
 
@@ -608,6 +809,101 @@ DECLARE_PER_CPU(struct rq, runqueues);
 #define cpu_curr(cpu)		(cpu_rq(cpu)->curr)
 #define raw_rq()		(&__raw_get_cpu_var(runqueues))
 
+#ifdef CONFIG_SCHED_CORE
+extern struct static_key __sched_core_enabled;
+
+static inline bool sched_core_enabled(struct rq *rq)
+{
+	return static_key_false(&__sched_core_enabled) && rq->core_enabled;
+}
+
+static inline bool sched_core_disabled(void)
+{
+	return !static_key_false(&__sched_core_enabled);
+}
+
+/*
+ * The lock serializing @rq: with core scheduling on, the one of the core's
+ * leader, so that whichever sibling schedules can pick for all of them.
+ * Only changes with the locks of all siblings held.
+ */
+static inline raw_spinlock_t *rq_lockp(struct rq *rq)
+{
+	if (sched_core_enabled(rq))
+		return &rq->core->__lock;
+
+	return &rq->__lock;
+}
+
+extern void raw_spin_rq_lock_nested(struct rq *rq, int subclass);
+extern bool raw_spin_rq_trylock(struct rq *rq);
+extern void raw_spin_rq_unlock(struct rq *rq);
+#else
+static inline bool sched_core_enabled(struct rq *rq)
+{
+	return false;
+}
+
+static inline raw_spinlock_t *rq_lockp(struct rq *rq)
+{
+	return &rq->__lock;
+}
+
+static inline void raw_spin_rq_lock_nested(struct rq *rq, int subclass)
+{
+	raw_spin_lock_nested(&rq->__lock, subclass);
+}
+
+static inline bool raw_spin_rq_trylock(struct rq *rq)
+{
+	return raw_spin_trylock(&rq->__lock);
+}
+
+static inline void raw_spin_rq_unlock(struct rq *rq)
+{
+	raw_spin_unlock(&rq->__lock);
+}
+#endif /* CONFIG_SCHED_CORE */
+
+static inline void raw_spin_rq_lock(struct rq *rq)
+{
+	raw_spin_rq_lock_nested(rq, 0);
+}
+
+static inline void raw_spin_rq_lock_irq(struct rq *rq)
+{
+	local_irq_disable();
+	raw_spin_rq_lock(rq);
+}
+
+static inline void raw_spin_rq_unlock_irq(struct rq *rq)
+{
+	raw_spin_rq_unlock(rq);
+	local_irq_enable();
+}
+
+static inline unsigned long _raw_spin_rq_lock_irqsave(struct rq *rq)
+{
+	unsigned long flags;
+
+	local_irq_save(flags);
+	raw_spin_rq_lock(rq);
+
+	return flags;
+}
+
+#define raw_spin_rq_lock_irqsave(rq, flags)		\
+do {							\
+	flags = _raw_spin_rq_lock_irqsave(rq);		\
+} while (0)
+
+static inline void raw_spin_rq_unlock_irqrestore(struct rq *rq,
+						 unsigned long flags)
+{
+	raw_spin_rq_unlock(rq);
+	local_irq_restore(flags);
+}
+
 #ifdef CONFIG_SMP
 
 #define rcu_dereference_check_sched_domain(p) \
@@ -651,6 +947,7 @@ static inline struct sched_domain *highest_flag_domain(int cpu, int flag)
 
 DECLARE_PER_CPU(struct sched_domain *, sd_llc);
 DECLARE_PER_CPU(int, sd_llc_id);
+DECLARE_PER_CPU(struct sched_domain_shared *, sd_llc_shared);
 
 struct sched_group_power {
 	atomic_t ref;
@@ -904,16 +1201,16 @@ static inline void finish_lock_switch(struct rq *rq, struct task_struct *prev)
 #endif
 #ifdef CONFIG_DEBUG_SPINLOCK
 	/* this is a valid case when another task releases the spinlock */
-	rq->lock.owner = current;
+	rq_lockp(rq)->owner = current;
 #endif
 	/*
 	 * If we are tracking spinlock dependencies then we have to
 	 * fix up the runqueue lock - which gets 'carried over' from
 	 * prev into current:
 	 */
-	spin_acquire(&rq->lock.dep_map, 0, 0, _THIS_IP_);
+	spin_acquire(&rq_lockp(rq)->dep_map, 0, 0, _THIS_IP_);
 
-	raw_spin_unlock_irq(&rq->lock);
+	raw_spin_rq_unlock_irq(rq);
 }
 
 #else /* __ARCH_WANT_UNLOCKED_CTXSW */
@@ -927,7 +1224,7 @@ static inline void prepare_lock_switch(struct rq *rq, struct task_struct *next)
 	 */
 	next->on_cpu = 1;
 #endif
-	raw_spin_unlock(&rq->lock);
+	raw_spin_rq_unlock(rq);
 }
 
 static inline void finish_lock_switch(struct rq *rq, struct task_struct *prev)
@@ -1030,6 +1327,7 @@ static const u32 prio_to_wmult[40] = {
 #else
 #define ENQUEUE_WAKING		0
 #endif
+#define ENQUEUE_REPLENISH	8
 
 #define DEQUEUE_SLEEP		1
 
@@ -1051,6 +1349,10 @@ struct sched_class {
 	void (*check_preempt_curr) (struct rq *rq, struct task_struct *p, int flags);
     //ѡһеĽ
 	struct task_struct * (*pick_next_task) (struct rq *rq);
+#ifdef CONFIG_SCHED_CORE
+	/* the task pick_next_task() would return, leaving the rq as it is */
+	struct task_struct * (*pick_task) (struct rq *rq);
+#endif
     //ǰеĽ̷ŻжУִpick_next_task
 	void (*put_prev_task) (struct rq *rq, struct task_struct *p);
 
@@ -1075,11 +1377,14 @@ struct sched_class {
 #endif
      /* ̸ıĵʱ */  
 	void (*set_curr_task) (struct rq *rq);
+	/* make the queued task @p current, the reverse of put_prev_task() */
+	void (*set_next_task) (struct rq *rq, struct task_struct *p);
     /* úͨ time tick л
     ⽫ʱrunningռ */  
 	void (*task_tick) (struct rq *rq, struct task_struct *p, int queued);
      /* ڽ̴ʱãͬȲԵĽ̳ʼһ */  
 	void (*task_fork) (struct task_struct *p);
+	void (*task_dead) (struct task_struct *p);
 
     //л
 	void (*switched_from) (struct rq *this_rq, struct task_struct *task);
@@ -1101,6 +1406,7 @@ struct sched_class {
    for (class = sched_class_highest; class; class = class->next)
 
 extern const struct sched_class stop_sched_class;
+extern const struct sched_class dl_sched_class;
 extern const struct sched_class rt_sched_class;
 extern const struct sched_class fair_sched_class;
 extern const struct sched_class idle_sched_class;
@@ -1125,6 +1431,12 @@ static inline void idle_enter_fair(struct rq *this_rq) {}
 static inline void idle_exit_fair(struct rq *this_rq) {}
 #endif
 
+#ifdef CONFIG_SCHED_SMT
+extern void update_idle_core(struct rq *rq);
+#else
+static inline void update_idle_core(struct rq *rq) {}
+#endif
+
 #else	/* CONFIG_SMP */
 
 static inline void idle_balance(int cpu, struct rq *rq)
@@ -1137,6 +1449,7 @@ extern void sysrq_sched_debug_show(void);
 extern void sched_init_granularity(void);
 extern void update_max_interval(void);
 extern int update_runtime(struct notifier_block *nfb, unsigned long action, void *hcpu);
+extern void init_sched_dl_class(void);
 extern void init_sched_rt_class(void);
 extern void init_sched_fair_class(void);
 
@@ -1146,6 +1459,26 @@ extern void resched_cpu(int cpu);
 extern struct rt_bandwidth def_rt_bandwidth;
 extern void init_rt_bandwidth(struct rt_bandwidth *rt_b, u64 period, u64 runtime);
 
+extern struct dl_bandwidth def_dl_bandwidth;
+extern void init_dl_bandwidth(struct dl_bandwidth *dl_b, u64 period, u64 runtime);
+extern void init_dl_bw(struct dl_bw *dl_b);
+extern void init_dl_task_timer(struct sched_dl_entity *dl_se);
+
+unsigned long to_ratio(u64 period, u64 runtime);
+
+#ifdef CONFIG_SCHED_CORE
+extern void sched_core_get(void);
+extern void sched_core_put(void);
+extern void sched_core_fork(struct task_struct *p);
+extern unsigned long sched_core_swap_cookie(struct task_struct *p,
+					    unsigned long cookie);
+extern bool fair_task_throttled(struct task_struct *p);
+extern bool rt_task_throttled(struct task_struct *p);
+extern bool cfs_prio_less(struct task_struct *a, struct task_struct *b);
+#else
+static inline void sched_core_fork(struct task_struct *p) { }
+#endif
+
 extern void update_idle_cpu_load(struct rq *this_rq);
 
 #ifdef CONFIG_PARAVIRT
@@ -1243,6 +1576,19 @@ static inline void sched_avg_update(struct rq *rq) { }
 extern void start_bandwidth_timer(struct hrtimer *period_timer, ktime_t period);
 
 #ifdef CONFIG_SMP
+/*
+ * Lock order of runqueues: by core, then by cpu, so that no rq of another
+ * core ever sorts between siblings that may share a lock.
+ */
+static inline bool rq_order_less(struct rq *rq1, struct rq *rq2)
+{
+#ifdef CONFIG_SCHED_CORE
+	if (rq1->core->cpu != rq2->core->cpu)
+		return rq1->core->cpu < rq2->core->cpu;
+#endif
+	return rq1->cpu < rq2->cpu;
+}
+
 #ifdef CONFIG_PREEMPT
 
 static inline void double_rq_lock(struct rq *rq1, struct rq *rq2);
@@ -1260,7 +1606,10 @@ static inline int _double_lock_balance(struct rq *this_rq, struct rq *busiest)
 	__acquires(busiest->lock)
 	__acquires(this_rq->lock)
 {
-	raw_spin_unlock(&this_rq->lock);
+	if (rq_lockp(this_rq) == rq_lockp(busiest))
+		return 0;
+
+	raw_spin_rq_unlock(this_rq);
 	double_rq_lock(this_rq, busiest);
 
 	return 1;
@@ -1281,15 +1630,18 @@ static inline int _double_lock_balance(struct rq *this_rq, struct rq *busiest)
 {
 	int ret = 0;
 
-	if (unlikely(!raw_spin_trylock(&busiest->lock))) {
-		if (busiest < this_rq) {
-			raw_spin_unlock(&this_rq->lock);
-			raw_spin_lock(&busiest->lock);
-			raw_spin_lock_nested(&this_rq->lock,
+	if (rq_lockp(this_rq) == rq_lockp(busiest))
+		return 0;
+
+	if (unlikely(!raw_spin_rq_trylock(busiest))) {
+		if (rq_order_less(busiest, this_rq)) {
+			raw_spin_rq_unlock(this_rq);
+			raw_spin_rq_lock(busiest);
+			raw_spin_rq_lock_nested(this_rq,
 					      SINGLE_DEPTH_NESTING);
 			ret = 1;
 		} else
-			raw_spin_lock_nested(&busiest->lock,
+			raw_spin_rq_lock_nested(busiest,
 					      SINGLE_DEPTH_NESTING);
 	}
 	return ret;
@@ -1304,7 +1656,7 @@ static inline int double_lock_balance(struct rq *this_rq, struct rq *busiest)
 {
 	if (unlikely(!irqs_disabled())) {
 		/* printk() doesn't work good under rq->lock */
-		raw_spin_unlock(&this_rq->lock);
+		raw_spin_rq_unlock(this_rq);
 		BUG_ON(1);
 	}
 
@@ -1314,8 +1666,9 @@ static inline int double_lock_balance(struct rq *this_rq, struct rq *busiest)
 static inline void double_unlock_balance(struct rq *this_rq, struct rq *busiest)
 	__releases(busiest->lock)
 {
-	raw_spin_unlock(&busiest->lock);
-	lock_set_subclass(&this_rq->lock.dep_map, 0, _RET_IP_);
+	if (rq_lockp(this_rq) != rq_lockp(busiest))
+		raw_spin_rq_unlock(busiest);
+	lock_set_subclass(&rq_lockp(this_rq)->dep_map, 0, _RET_IP_);
 }
 
 /*
@@ -1329,18 +1682,15 @@ static inline void double_rq_lock(struct rq *rq1, struct rq *rq2)
 	__acquires(rq2->lock)
 {
 	BUG_ON(!irqs_disabled());
-	if (rq1 == rq2) {
-		raw_spin_lock(&rq1->lock);
+	if (rq_order_less(rq2, rq1))
+		swap(rq1, rq2);
+
+	raw_spin_rq_lock(rq1);
+	/* siblings of a core may share their lock, see rq_lockp() */
+	if (rq_lockp(rq1) != rq_lockp(rq2))
+		raw_spin_rq_lock_nested(rq2, SINGLE_DEPTH_NESTING);
+	else
 		__acquire(rq2->lock);	/* Fake it out ;) */
-	} else {
-		if (rq1 < rq2) {
-			raw_spin_lock(&rq1->lock);
-			raw_spin_lock_nested(&rq2->lock, SINGLE_DEPTH_NESTING);
-		} else {
-			raw_spin_lock(&rq2->lock);
-			raw_spin_lock_nested(&rq1->lock, SINGLE_DEPTH_NESTING);
-		}
-	}
 }
 
 /*
@@ -1353,11 +1703,11 @@ static inline void double_rq_unlock(struct rq *rq1, struct rq *rq2)
 	__releases(rq1->lock)
 	__releases(rq2->lock)
 {
-	raw_spin_unlock(&rq1->lock);
-	if (rq1 != rq2)
-		raw_spin_unlock(&rq2->lock);
+	if (rq_lockp(rq1) != rq_lockp(rq2))
+		raw_spin_rq_unlock(rq2);
 	else
 		__release(rq2->lock);
+	raw_spin_rq_unlock(rq1);
 }
 
 #else /* CONFIG_SMP */
@@ -1374,7 +1724,7 @@ static inline void double_rq_lock(struct rq *rq1, struct rq *rq2)
 {
 	BUG_ON(!irqs_disabled());
 	BUG_ON(rq1 != rq2);
-	raw_spin_lock(&rq1->lock);
+	raw_spin_rq_lock(rq1);
 	__acquire(rq2->lock);	/* Fake it out ;) */
 }
 
@@ -1389,7 +1739,7 @@ static inline void double_rq_unlock(struct rq *rq1, struct rq *rq2)
 	__releases(rq2->lock)
 {
 	BUG_ON(rq1 != rq2);
-	raw_spin_unlock(&rq1->lock);
+	raw_spin_rq_unlock(rq1);
 	__release(rq2->lock);
 }
 
@@ -1399,9 +1749,11 @@ extern struct sched_entity *__pick_first_entity(struct cfs_rq *cfs_rq);
 extern struct sched_entity *__pick_last_entity(struct cfs_rq *cfs_rq);
 extern void print_cfs_stats(struct seq_file *m, int cpu);
 extern void print_rt_stats(struct seq_file *m, int cpu);
+extern void print_dl_stats(struct seq_file *m, int cpu);
 
 extern void init_cfs_rq(struct cfs_rq *cfs_rq);
 extern void init_rt_rq(struct rt_rq *rt_rq, struct rq *rq);
+extern void init_dl_rq(struct dl_rq *dl_rq, struct rq *rq);
 
 extern void cfs_bandwidth_usage_inc(void);
 extern void cfs_bandwidth_usage_dec(void);
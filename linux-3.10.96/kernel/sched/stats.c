@@ -10,7 +10,65 @@
  * bump this up when changing the output format or the meaning of an existing
  * format, so that tools can adapt (or abort)
  */
-#define SCHEDSTAT_VERSION 15
+#define SCHEDSTAT_VERSION 17
+
+static const char * const sched_lat_type_names[NR_SCHED_LAT] = {
+	[SCHED_LAT_WAKEUP]	= "wakeup",
+	[SCHED_LAT_RUNQ]	= "runq",
+};
+
+static const char * const sched_lat_class_names[NR_SCHED_LAT_CLASSES] = {
+	[SCHED_LAT_DL]		= "dl",
+	[SCHED_LAT_RT]		= "rt",
+	[SCHED_LAT_FAIR]	= "fair",
+};
+
+static inline int sched_lat_bucket(u64 delta)
+{
+	return min_t(int, fls64(delta >> 10), SCHED_LAT_BUCKETS - 1);
+}
+
+/*
+ * Called with rq->lock held when @p gets the cpu of @rq, so the per-cpu
+ * counters need no further serialization.  Groups are charged up to the
+ * root, like cpuacct does for cpu time.
+ */
+void sched_lat_account(struct rq *rq, struct task_struct *p,
+		       enum sched_lat_type type, u64 delta)
+{
+	int bucket = sched_lat_bucket(delta);
+	enum sched_lat_class class;
+#ifdef CONFIG_CGROUP_SCHED
+	struct task_group *tg;
+#endif
+
+	if (p->sched_class == &fair_sched_class)
+		class = SCHED_LAT_FAIR;
+	else if (p->sched_class == &rt_sched_class)
+		class = SCHED_LAT_RT;
+	else if (p->sched_class == &dl_sched_class)
+		class = SCHED_LAT_DL;
+	else
+		return;
+
+	rq->lat_hist[type][class].bucket[bucket]++;
+
+#ifdef CONFIG_CGROUP_SCHED
+	for (tg = task_group(p); tg; tg = tg->parent)
+		per_cpu_ptr(tg->lat_stats, cpu_of(rq))->hist[type].bucket[bucket]++;
+#endif
+}
+
+void sched_lat_show(struct seq_file *seq, const char *prefix,
+		    const struct sched_lat_hist *hist)
+{
+	int i;
+
+	seq_printf(seq, "%s", prefix);
+	for (i = 0; i < SCHED_LAT_BUCKETS; i++)
+		seq_printf(seq, " %u", hist->bucket[i]);
+	seq_printf(seq, "\n");
+}
 
 static int show_schedstat(struct seq_file *seq, void *v)
 {
@@ -26,6 +84,8 @@ static int show_schedstat(struct seq_file *seq, void *v)
 		seq_printf(seq, "timestamp %lu\n", jiffies);
 	} else {
 		struct rq *rq;
+		char prefix[32];
+		int type, class;
 #ifdef CONFIG_SMP
 		struct sched_domain *sd;
 		int dcount = 0;
@@ -35,15 +95,28 @@ static int show_schedstat(struct seq_file *seq, void *v)
 
 		/* runqueue-specific stats */
 		seq_printf(seq,
-		    "cpu%d %u 0 %u %u %u %u %llu %llu %lu",
+		    "cpu%d %u 0 %u %u %u %u %llu %llu %lu %u %u %u %u",
 		    cpu, rq->yld_count,
 		    rq->sched_count, rq->sched_goidle,
 		    rq->ttwu_count, rq->ttwu_local,
 		    rq->rq_cpu_time,
-		    rq->rq_sched_info.run_delay, rq->rq_sched_info.pcount);
+		    rq->rq_sched_info.run_delay, rq->rq_sched_info.pcount,
+		    rq->sis_search, rq->sis_scanned,
+		    rq->sis_idle_core, rq->sis_failed);
 
 		seq_printf(seq, "\n");
 
+		/* latency histograms, one line per type and class */
+		for (type = 0; type < NR_SCHED_LAT; type++) {
+			for (class = 0; class < NR_SCHED_LAT_CLASSES; class++) {
+				snprintf(prefix, sizeof(prefix), "latency %s %s",
+					 sched_lat_type_names[type],
+					 sched_lat_class_names[class]);
+				sched_lat_show(seq, prefix,
+					       &rq->lat_hist[type][class]);
+			}
+		}
+
 #ifdef CONFIG_SMP
 		/* domain-specific stats */
 		rcu_read_lock();
@@ -29,6 +29,24 @@ rq_sched_info_dequeued(struct rq *rq, unsigned long long delta)
 	if (rq)
 		rq->rq_sched_info.run_delay += delta;
 }
+
+/*
+ * @t gets the cpu after waiting @delta on the runqueue; if it was woken
+ * up since it last ran, also account the full wakeup latency.
+ */
+static inline void
+sched_lat_arrive(struct rq *rq, struct task_struct *t, unsigned long long delta)
+{
+	u64 wakeup = t->se.statistics.wakeup_start;
+
+	sched_lat_account(rq, t, SCHED_LAT_RUNQ, delta);
+	if (wakeup) {
+		t->se.statistics.wakeup_start = 0;
+		sched_lat_account(rq, t, SCHED_LAT_WAKEUP,
+				  (s64)(rq->clock - wakeup) > 0 ?
+				  rq->clock - wakeup : 0);
+	}
+}
 # define schedstat_inc(rq, field)	do { (rq)->field++; } while (0)
 # define schedstat_add(rq, field, amt)	do { (rq)->field += (amt); } while (0)
 # define schedstat_set(var, val)	do { var = (val); } while (0)
@@ -42,6 +60,9 @@ rq_sched_info_dequeued(struct rq *rq, unsigned long long delta)
 static inline void
 rq_sched_info_depart(struct rq *rq, unsigned long long delta)
 {}
+static inline void
+sched_lat_arrive(struct rq *rq, struct task_struct *t, unsigned long long delta)
+{}
 # define schedstat_inc(rq, field)	do { } while (0)
 # define schedstat_add(rq, field, amt)	do { } while (0)
 # define schedstat_set(var, val)	do { } while (0)
@@ -89,6 +110,7 @@ static void sched_info_arrive(struct task_struct *t)
 	t->sched_info.pcount++;
 
 	rq_sched_info_arrive(task_rq(t), delta);
+	sched_lat_arrive(task_rq(t), t, delta);
 }
 
 /*
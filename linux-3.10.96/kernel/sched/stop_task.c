@@ -23,18 +23,26 @@ check_preempt_curr_stop(struct rq *rq, struct task_struct *p, int flags)
 	/* we're never preempted */
 }
 
-static struct task_struct *pick_next_task_stop(struct rq *rq)
+static struct task_struct *pick_task_stop(struct rq *rq)
 {
 	struct task_struct *stop = rq->stop;
 
-	if (stop && stop->on_rq) {
-		stop->se.exec_start = rq->clock_task;
+	if (stop && stop->on_rq)
 		return stop;
-	}
 
 	return NULL;
 }
 
+static struct task_struct *pick_next_task_stop(struct rq *rq)
+{
+	struct task_struct *stop = pick_task_stop(rq);
+
+	if (stop)
+		stop->se.exec_start = rq->clock_task;
+
+	return stop;
+}
+
 static void
 enqueue_task_stop(struct rq *rq, struct task_struct *p, int flags)
 {
@@ -75,13 +83,16 @@ static void task_tick_stop(struct rq *rq, struct task_struct *curr, int queued)
 {
 }
 
-static void set_curr_task_stop(struct rq *rq)
+static void set_next_task_stop(struct rq *rq, struct task_struct *stop)
 {
-	struct task_struct *stop = rq->stop;
-
 	stop->se.exec_start = rq->clock_task;
 }
 
+static void set_curr_task_stop(struct rq *rq)
+{
+	set_next_task_stop(rq, rq->stop);
+}
+
 static void switched_to_stop(struct rq *rq, struct task_struct *p)
 {
 	BUG(); /* its impossible to change to this class */
@@ -103,7 +114,7 @@ get_rr_interval_stop(struct rq *rq, struct task_struct *task)
  * Simple, special scheduling class for the per-CPU stop tasks:
  */
 const struct sched_class stop_sched_class = {
-	.next			= &rt_sched_class,
+	.next			= &dl_sched_class,
 
 	.enqueue_task		= enqueue_task_stop,
 	.dequeue_task		= dequeue_task_stop,
@@ -112,6 +123,9 @@ const struct sched_class stop_sched_class = {
 	.check_preempt_curr	= check_preempt_curr_stop,
 
 	.pick_next_task		= pick_next_task_stop,
+#ifdef CONFIG_SCHED_CORE
+	.pick_task		= pick_task_stop,
+#endif
 	.put_prev_task		= put_prev_task_stop,
 
 #ifdef CONFIG_SMP
@@ -119,6 +133,7 @@ const struct sched_class stop_sched_class = {
 #endif
 
 	.set_curr_task          = set_curr_task_stop,
+	.set_next_task          = set_next_task_stop,
 	.task_tick		= task_tick_stop,
 
 	.get_rr_interval	= get_rr_interval_stop,
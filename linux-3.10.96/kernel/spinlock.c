@@ -14,12 +14,15 @@
  * frame contact the architecture maintainers.
  */
 
+#define LOCK_PROFILE_HOOKS
+
 #include <linux/linkage.h>
 #include <linux/preempt.h>
 #include <linux/spinlock.h>
 #include <linux/interrupt.h>
 #include <linux/debug_locks.h>
 #include <linux/export.h>
+#include <linux/lock_profile.h>
 
 /*
  * If lockdep is enabled then we use the non-preemption spin-ops
@@ -42,27 +45,37 @@
  * This could be a long-held lock. We both prepare to spin for a long
  * time (making _this_ CPU preemptable if possible), and we also signal
  * towards that other CPU that it should break the lock ASAP.
+ *
+ * With the contention profiler on, the wait is timed from the first
+ * failed trylock.
  */
 #define BUILD_LOCK_OPS(op, locktype)					\
 void __lockfunc __raw_##op##_lock(locktype##_t *lock)			\
 {									\
+	u64 start = 0;							\
+									\
 	for (;;) {							\
 		preempt_disable();					\
 		if (likely(do_raw_##op##_trylock(lock)))		\
 			break;						\
 		preempt_enable();					\
 									\
+		if (!start && lock_profile_active())			\
+			start = lock_profile_clock();			\
 		if (!(lock)->break_lock)				\
 			(lock)->break_lock = 1;				\
 		while (!raw_##op##_can_lock(lock) && (lock)->break_lock)\
 			arch_##op##_relax(&lock->raw_lock);		\
 	}								\
 	(lock)->break_lock = 0;						\
+	if (start)							\
+		lock_profile_contended(#op "_lock", lock, _RET_IP_, start); \
 }									\
 									\
 unsigned long __lockfunc __raw_##op##_lock_irqsave(locktype##_t *lock)	\
 {									\
 	unsigned long flags;						\
+	u64 start = 0;							\
 									\
 	for (;;) {							\
 		preempt_disable();					\
@@ -72,12 +85,16 @@ unsigned long __lockfunc __raw_##op##_lock_irqsave(locktype##_t *lock)	\
 		local_irq_restore(flags);				\
 		preempt_enable();					\
 									\
+		if (!start && lock_profile_active())			\
+			start = lock_profile_clock();			\
 		if (!(lock)->break_lock)				\
 			(lock)->break_lock = 1;				\
 		while (!raw_##op##_can_lock(lock) && (lock)->break_lock)\
 			arch_##op##_relax(&lock->raw_lock);		\
 	}								\
 	(lock)->break_lock = 0;						\
+	if (start)							\
+		lock_profile_contended(#op "_lock", lock, _RET_IP_, start); \
 	return flags;							\
 }									\
 									\
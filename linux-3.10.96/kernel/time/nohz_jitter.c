@@ -0,0 +1,230 @@
+/*
+ * Module-based jitter test for full dynticks cpus
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Modelled on kernel/locktorture.c.
+ *
+ * One kthread is bound to each nohz_full cpu (each online cpu if there
+ * are none) and spins reading local_clock().  Any gap between two reads
+ * larger than threshold_ns means something else ran on that cpu: a tick,
+ * an interrupt, a timer, a kworker.  The number of such interruptions per
+ * second is what full dynticks and housekeeping offload try to drive to
+ * zero, so the figure is printed per cpu along with the largest gap.
+ */
+#include <linux/types.h>
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/kthread.h>
+#include <linux/err.h>
+#include <linux/sched.h>
+#include <linux/moduleparam.h>
+#include <linux/slab.h>
+#include <linux/jiffies.h>
+#include <linux/math64.h>
+#include <linux/cpu.h>
+#include <linux/tick.h>
+
+MODULE_LICENSE("GPL");
+
+static int duration = 60;	/* Length of the measurement, in seconds. */
+				/*  Zero means "until the module is removed". */
+static int threshold_ns = 2000;	/* Smallest gap counted as an interruption. */
+static int stat_interval = 10;	/* Interval between stats, in seconds. */
+				/*  Zero means "only at end of test". */
+
+module_param(duration, int, 0444);
+MODULE_PARM_DESC(duration, "Number of seconds to measure jitter for");
+module_param(threshold_ns, int, 0444);
+MODULE_PARM_DESC(threshold_ns, "Minimum local_clock() gap (ns) counted as an interruption");
+module_param(stat_interval, int, 0644);
+MODULE_PARM_DESC(stat_interval, "Number of seconds between stats printk()s");
+
+#define JITTER_FLAG "nohz-jitter: "
+
+struct jitter_stats {
+	int cpu;
+	bool done;
+	u64 start;
+	u64 elapsed;
+	unsigned long n_interrupts;
+	u64 total_gap;
+	u64 max_gap;
+};
+
+static struct task_struct **jitter_tasks;
+static struct jitter_stats *jsa;	/* One per jitter thread. */
+static struct task_struct *stats_task;
+static int njitter;
+
+/*
+ * Spin on local_clock() until the test time runs out.  Stats are only
+ * ever written by this thread; readers may see slightly torn values,
+ * which is fine for a printk().
+ */
+static int nohz_jitter_thread(void *arg)
+{
+	struct jitter_stats *js = arg;
+	u64 end, prev, now, gap;
+
+	js->start = prev = local_clock();
+	end = duration ? js->start + (u64)duration * NSEC_PER_SEC : 0;
+
+	while (!kthread_should_stop()) {
+		now = local_clock();
+		gap = now - prev;
+		if (gap > threshold_ns) {
+			js->n_interrupts++;
+			js->total_gap += gap;
+			if (gap > js->max_gap)
+				js->max_gap = gap;
+		}
+		prev = now;
+		js->elapsed = now - js->start;
+
+		if (end && time_after64(now, end))
+			break;
+
+		/* Only gives up the cpu if something else wants it. */
+		cond_resched();
+	}
+	js->done = true;
+
+	while (!kthread_should_stop())
+		schedule_timeout_interruptible(HZ);
+	return 0;
+}
+
+static void nohz_jitter_stats_print(void)
+{
+	int i;
+
+	for (i = 0; i < njitter; i++) {
+		struct jitter_stats *js = &jsa[i];
+		u64 secs = div_u64(js->elapsed, NSEC_PER_SEC);
+		unsigned long rate;
+
+		rate = secs ? div64_u64(js->n_interrupts, secs) : js->n_interrupts;
+		pr_alert(JITTER_FLAG "cpu %d%s: interruptions: %lu (%lu/s) max gap: %llu ns avg gap: %llu ns\n",
+			 js->cpu, js->done ? "" : " (running)",
+			 js->n_interrupts, rate, js->max_gap,
+			 js->n_interrupts ?
+			 div64_u64(js->total_gap, js->n_interrupts) : 0ULL);
+	}
+}
+
+/*
+ * Periodically prints jitter statistics, if periodic statistics printing
+ * was specified via the stat_interval module parameter.
+ */
+static int nohz_jitter_stats(void *arg)
+{
+	do {
+		schedule_timeout_interruptible(stat_interval * HZ);
+		nohz_jitter_stats_print();
+	} while (!kthread_should_stop());
+	return 0;
+}
+
+static void nohz_jitter_cleanup(void)
+{
+	int i;
+
+	if (jitter_tasks) {
+		for (i = 0; i < njitter; i++) {
+			if (jitter_tasks[i])
+				kthread_stop(jitter_tasks[i]);
+			jitter_tasks[i] = NULL;
+		}
+		kfree(jitter_tasks);
+		jitter_tasks = NULL;
+	}
+
+	if (stats_task)
+		kthread_stop(stats_task);
+	stats_task = NULL;
+
+	if (jsa) {
+		nohz_jitter_stats_print();  /* -After- the stats thread is stopped! */
+		pr_alert(JITTER_FLAG "--- End of test: duration=%d threshold_ns=%d\n",
+			 duration, threshold_ns);
+	}
+
+	kfree(jsa);
+	jsa = NULL;
+}
+
+static int __init nohz_jitter_init(void)
+{
+	bool all_cpus = true;
+	int i, cpu;
+	int firsterr = 0;
+
+	if (threshold_ns <= 0)
+		return -EINVAL;
+
+	get_online_cpus();
+	for_each_online_cpu(cpu) {
+		if (tick_nohz_full_cpu(cpu))
+			all_cpus = false;
+	}
+	njitter = num_online_cpus();
+	jsa = kcalloc(njitter, sizeof(*jsa), GFP_KERNEL);
+	jitter_tasks = kcalloc(njitter, sizeof(jitter_tasks[0]), GFP_KERNEL);
+	if (!jsa || !jitter_tasks) {
+		put_online_cpus();
+		firsterr = -ENOMEM;
+		goto unwind;
+	}
+
+	pr_alert(JITTER_FLAG "--- Start of test: %s cpus duration=%d threshold_ns=%d stat_interval=%d\n",
+		 all_cpus ? "all online" : "nohz_full",
+		 duration, threshold_ns, stat_interval);
+
+	i = 0;
+	for_each_online_cpu(cpu) {
+		if (!all_cpus && !tick_nohz_full_cpu(cpu))
+			continue;
+		jsa[i].cpu = cpu;
+		jitter_tasks[i] = kthread_create(nohz_jitter_thread, &jsa[i],
+						 "nohz_jitter/%d", cpu);
+		if (IS_ERR(jitter_tasks[i])) {
+			put_online_cpus();
+			firsterr = PTR_ERR(jitter_tasks[i]);
+			jitter_tasks[i] = NULL;
+			goto unwind;
+		}
+		kthread_bind(jitter_tasks[i], cpu);
+		wake_up_process(jitter_tasks[i]);
+		i++;
+	}
+	njitter = i;
+	put_online_cpus();
+
+	if (stat_interval > 0) {
+		stats_task = kthread_run(nohz_jitter_stats, NULL,
+					 "nohz_jitter_stats");
+		if (IS_ERR(stats_task)) {
+			firsterr = PTR_ERR(stats_task);
+			stats_task = NULL;
+			goto unwind;
+		}
+	}
+	return 0;
+
+unwind:
+	nohz_jitter_cleanup();
+	return firsterr;
+}
+
+module_init(nohz_jitter_init);
+module_exit(nohz_jitter_cleanup);
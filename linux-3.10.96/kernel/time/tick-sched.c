@@ -150,6 +150,7 @@ static void tick_sched_handle(struct tick_sched *ts, struct pt_regs *regs)
 #ifdef CONFIG_NO_HZ_FULL
 static cpumask_var_t nohz_full_mask;
 bool have_nohz_full_mask;
+cpumask_var_t housekeeping_mask;
 
 static bool can_stop_full_tick(void)
 {
@@ -270,6 +271,7 @@ int tick_nohz_full_cpu(int cpu)
 
 	return cpumask_test_cpu(cpu, nohz_full_mask);
 }
+EXPORT_SYMBOL_GPL(tick_nohz_full_cpu);
 
 /* Parse the boot-time nohz CPU list from the kernel parameters. */
 static int __init tick_nohz_full_setup(char *str)
@@ -345,8 +347,20 @@ void __init tick_nohz_init(void)
 			return;
 	}
 
+	if (!alloc_cpumask_var(&housekeeping_mask, GFP_KERNEL)) {
+		pr_err("NO_HZ: Can't allocate housekeeping cpumask\n");
+		have_nohz_full_mask = false;
+		return;
+	}
+
 	cpu_notifier(tick_nohz_cpu_down_callback, 0);
 
+	/*
+	 * Full dynticks CPUs don't invoke RCU callbacks: offload them to the
+	 * no-CBs kthreads, which aren't spawned yet at this point.
+	 */
+	rcu_nocb_offload_cpus(nohz_full_mask);
+
 	/* Make sure full dynticks CPU are also RCU nocbs */
 	for_each_cpu(cpu, nohz_full_mask) {
 		if (!rcu_is_nocb_cpu(cpu)) {
@@ -356,6 +370,8 @@ void __init tick_nohz_init(void)
 		}
 	}
 
+	cpumask_andnot(housekeeping_mask, cpu_possible_mask, nohz_full_mask);
+
 	cpulist_scnprintf(nohz_full_buf, sizeof(nohz_full_buf), nohz_full_mask);
 	pr_info("NO_HZ: Full dynticks CPUs: %s.\n", nohz_full_buf);
 }
@@ -47,6 +47,9 @@
 #include <linux/nodemask.h>
 #include <linux/moduleparam.h>
 #include <linux/uaccess.h>
+#include <linux/llist.h>
+#include <linux/topology.h>
+#include <linux/tick.h>
 
 #include "workqueue_internal.h"
 
@@ -147,6 +150,7 @@ struct worker_pool {
 	unsigned int		flags;		/* X: flags */
     //__queue_work()аstruct work_struct *workӵworklistworker_thread()дworklistȡstruct work_struct *work
 	struct list_head	worklist;	/* L: list of pending works */
+	struct llist_head	pending;	/* works queued without pool->lock */
 	int			nr_workers;	/* L: total number of workers */
 
 	/* nr_idle includes the ones off idle_list for rebinding */
@@ -261,7 +265,7 @@ struct workqueue_struct {//bdi
 	/* hot fields used during command issue, aligned to cacheline */
 	unsigned int		flags ____cacheline_aligned; /* WQ: WQ_* flags */
 	struct pool_workqueue __percpu *cpu_pwqs; /* I: per-cpu pwqs */
-	struct pool_workqueue __rcu *numa_pwq_tbl[]; /* FR: unbound pwqs indexed by node */
+	struct pool_workqueue __rcu *cpu_pwq_tbl[]; /* FR: unbound pwqs indexed by cpu */
 };
 
 static struct kmem_cache *pwq_cache;
@@ -275,8 +279,52 @@ module_param_named(disable_numa, wq_disable_numa, bool, 0444);
 
 static bool wq_numa_enabled;		/* unbound NUMA affinity enabled */
 
-/* buf for wq_update_unbound_numa_attrs(), protected by CPU hotplug exclusion */
-static struct workqueue_attrs *wq_update_unbound_numa_attrs_buf;
+static const char *wq_affn_names[WQ_AFFN_NR_TYPES] = {
+	[WQ_AFFN_CPU]		= "cpu",
+	[WQ_AFFN_SMT]		= "smt",
+	[WQ_AFFN_CACHE]		= "cache",
+	[WQ_AFFN_NUMA]		= "numa",
+	[WQ_AFFN_SYSTEM]	= "system",
+};
+
+/* affinity scope new unbound workqueues start with */
+static int wq_affn_dfl = WQ_AFFN_CACHE;
+
+static int parse_affn_scope(const char *val)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(wq_affn_names); i++) {
+		if (sysfs_streq(val, wq_affn_names[i]))
+			return i;
+	}
+	return -EINVAL;
+}
+
+static int wq_affn_dfl_set(const char *val, const struct kernel_param *kp)
+{
+	int affn = parse_affn_scope(val);
+
+	if (affn < 0)
+		return affn;
+
+	wq_affn_dfl = affn;
+	return 0;
+}
+
+static int wq_affn_dfl_get(char *buffer, const struct kernel_param *kp)
+{
+	return scnprintf(buffer, PAGE_SIZE, "%s", wq_affn_names[wq_affn_dfl]);
+}
+
+static struct kernel_param_ops wq_affn_dfl_ops = {
+	.set	= wq_affn_dfl_set,
+	.get	= wq_affn_dfl_get,
+};
+module_param_cb(default_affinity_scope, &wq_affn_dfl_ops, NULL, 0444);
+
+/* buf for wq_update_pod_cpu(), protected by CPU hotplug exclusion */
+static struct workqueue_attrs *wq_update_pod_attrs_buf;
 
 static DEFINE_MUTEX(wq_pool_mutex);	/* protects pools and workqueues list */
 static DEFINE_SPINLOCK(wq_mayday_lock);	/* protects wq->maydays list */
@@ -311,6 +359,7 @@ struct workqueue_struct *system_freezable_wq __read_mostly;
 EXPORT_SYMBOL_GPL(system_freezable_wq);
 
 static int worker_thread(void *__worker);
+static void pool_drain_pending(struct worker_pool *pool);
 static void copy_workqueue_attrs(struct workqueue_attrs *to,
 				 const struct workqueue_attrs *from);
 
@@ -524,19 +573,19 @@ static int worker_pool_assign_id(struct worker_pool *pool)
 }
 
 /**
- * unbound_pwq_by_node - return the unbound pool_workqueue for the given node
+ * unbound_pwq_by_cpu - return the unbound pool_workqueue for the given cpu
  * @wq: the target workqueue
- * @node: the node ID
+ * @cpu: the CPU work items are issued on
  *
  * This must be called either with pwq_lock held or sched RCU read locked.
  * If the pwq needs to be used beyond the locking in effect, the caller is
  * responsible for guaranteeing that the pwq stays online.
  */
-static struct pool_workqueue *unbound_pwq_by_node(struct workqueue_struct *wq,
-						  int node)
+static struct pool_workqueue *unbound_pwq_by_cpu(struct workqueue_struct *wq,
+						 int cpu)
 {
 	assert_rcu_or_wq_mutex(wq);
-	return rcu_dereference_raw(wq->numa_pwq_tbl[node]);
+	return rcu_dereference_raw(wq->cpu_pwq_tbl[cpu]);
 }
 
 static unsigned int work_color_to_flags(int color)
@@ -712,6 +761,7 @@ static bool __need_more_worker(struct worker_pool *pool)
  */
 static bool need_more_worker(struct worker_pool *pool)
 {
+	pool_drain_pending(pool);
 	return !list_empty(&pool->worklist) && __need_more_worker(pool);
 }
 
@@ -724,6 +774,7 @@ static bool may_start_working(struct worker_pool *pool)
 /* Do I need to keep working?  Called from currently running workers. */
 static bool keep_working(struct worker_pool *pool)
 {
+	pool_drain_pending(pool);
 	return !list_empty(&pool->worklist) &&
 		atomic_read(&pool->nr_running) <= 1;
 }
@@ -846,8 +897,9 @@ struct task_struct *wq_worker_sleeping(struct task_struct *task, int cpu)
 
 	/*
 	 * The counterpart of the following dec_and_test, implied mb,
-	 * worklist not empty test sequence is in insert_work().
-	 * Please read comment there.
+	 * worklist not empty test sequence is in insert_work() and, for
+	 * the lockless pending list, in queue_work_lockless().  Please
+	 * read comments there.
 	 *
 	 * NOT_RUNNING is clear.  This means that we're bound to and
 	 * running on the local cpu w/ rq lock held and preemption
@@ -856,7 +908,7 @@ struct task_struct *wq_worker_sleeping(struct task_struct *task, int cpu)
 	 * lock is safe.
 	 */
 	if (atomic_dec_and_test(&pool->nr_running) &&
-	    !list_empty(&pool->worklist))
+	    (!list_empty(&pool->worklist) || !llist_empty(&pool->pending)))
 		to_wakeup = first_worker(pool);
 	return to_wakeup ? to_wakeup->task : NULL;
 }
@@ -890,7 +942,7 @@ static inline void worker_set_flags(struct worker *worker, unsigned int flags,
 	    !(worker->flags & WORKER_NOT_RUNNING)) {
 		if (wakeup) {
 			if (atomic_dec_and_test(&pool->nr_running) &&
-			    !list_empty(&pool->worklist))
+			    need_more_worker(pool))
 				wake_up_worker(pool);
 		} else
 			atomic_dec(&pool->nr_running);
@@ -1198,6 +1250,7 @@ static int try_to_grab_pending(struct work_struct *work, bool is_dwork,
 		goto fail;
 
 	spin_lock(&pool->lock);
+	pool_drain_pending(pool);
 	/*
 	 * work->data is guaranteed to point to pwq only while the work
 	 * item is queued on pwq->wq, and both updating work->data to point
@@ -1205,9 +1258,21 @@ static int try_to_grab_pending(struct work_struct *work, bool is_dwork,
 	 * pwq->pool->lock.  This in turn guarantees that, if work->data
 	 * points to pwq which is associated with a locked pool, the work
 	 * item is currently queued on that pool.
+	 *
+	 * The only exception is queue_work_lockless() which points
+	 * work->data to pwq before the work item reaches pool->pending.
+	 * Everything already on pool->pending has been moved to the
+	 * worklist above, so a NULL ->entry.prev means that the queueing
+	 * is still in progress.
 	 */
 	pwq = get_work_pwq(work);
 	if (pwq && pwq->pool == pool) {
+		smp_rmb();	/* pairs with smp_wmb() in queue_work_lockless() */
+		if (unlikely(!work->entry.prev)) {
+			spin_unlock(&pool->lock);
+			goto fail;
+		}
+
 		debug_work_deactivate(work);
 
 		/*
@@ -1273,6 +1338,132 @@ static void insert_work(struct pool_workqueue *pwq, struct work_struct *work,
 		wake_up_worker(pool);//workeṛ߳bdiˢݽ"kworker/u128:2"
 }
 
+/**
+ * pwq_queue_work - account a work item to a pwq and queue it
+ * @pwq: pwq @work belongs to
+ * @work: work to queue
+ *
+ * Put @work on @pwq->pool's worklist or, if @pwq already has max_active
+ * work items active, on @pwq's delayed list.
+ *
+ * CONTEXT:
+ * spin_lock_irq(pool->lock).
+ */
+static void pwq_queue_work(struct pool_workqueue *pwq, struct work_struct *work)
+{
+	struct list_head *worklist;
+	unsigned int work_flags;
+
+	pwq->nr_in_flight[pwq->work_color]++;
+	work_flags = work_color_to_flags(pwq->work_color);
+
+	if (likely(pwq->nr_active < pwq->max_active)) {
+		trace_workqueue_activate_work(work);
+		pwq->nr_active++;
+		worklist = &pwq->pool->worklist;
+	} else {
+		work_flags |= WORK_STRUCT_DELAYED;
+		worklist = &pwq->delayed_works;
+	}
+
+	insert_work(pwq, work, worklist, work_flags);
+}
+
+/*
+ * While on pool->pending, a work item is linked through the first word of
+ * its ->entry; ->entry.prev is kept NULL until the item reaches a real
+ * list.  See queue_work_lockless().
+ */
+static inline struct llist_node *work_llnode(struct work_struct *work)
+{
+	return (struct llist_node *)&work->entry.next;
+}
+
+static inline struct work_struct *llnode_to_work(struct llist_node *node)
+{
+	return container_of((struct list_head *)node, struct work_struct, entry);
+}
+
+/**
+ * pool_drain_pending - move locklessly queued work items to the worklist
+ * @pool: the target pool
+ *
+ * Splice everything queue_work_lockless() pushed on @pool->pending onto
+ * the worklist in queueing order.  This is where work items queued
+ * without pool->lock are accounted, so anyone about to look at the
+ * worklist or at a pwq's in-flight counts must call this first.  A whole
+ * batch of submissions is moved per pool->lock acquisition.
+ *
+ * CONTEXT:
+ * spin_lock_irq(pool->lock).
+ */
+static void pool_drain_pending(struct worker_pool *pool)
+{
+	struct llist_node *node;
+
+	if (llist_empty(&pool->pending))
+		return;
+
+	node = llist_reverse_order(llist_del_all(&pool->pending));
+	while (node) {
+		struct work_struct *work = llnode_to_work(node);
+
+		/* insert_work() reuses the link, advance first */
+		node = node->next;
+		pwq_queue_work(get_work_pwq(work), work);
+	}
+}
+
+/**
+ * queue_work_lockless - queue a work item without taking pool->lock
+ * @req_cpu: the cpu @work was requested on
+ * @pwq: pwq to queue @work on
+ * @work: work to queue
+ *
+ * Push @work on @pwq->pool's lockless pending list.  A running worker
+ * picks it up the next time it checks the worklist, so on a busy pool
+ * queueing never touches pool->lock and the workers drain submissions in
+ * batches.  Only if no worker is running does the queuer take the lock
+ * to drain the list and kick an idle worker.
+ *
+ * CONTEXT:
+ * IRQ disabled, PENDING owned.
+ */
+static void queue_work_lockless(unsigned int req_cpu,
+				struct pool_workqueue *pwq,
+				struct work_struct *work)
+{
+	struct worker_pool *pool = pwq->pool;
+
+	if (WARN_ON(!list_empty(&work->entry)))
+		return;
+
+	trace_workqueue_queue_work(req_cpu, pwq, work);
+
+	/*
+	 * try_to_grab_pending() and start_flush_work() rely on ->entry.prev
+	 * being NULL whenever work->data points to @pwq but @work hasn't
+	 * been moved to the worklist yet.
+	 */
+	work->entry.prev = NULL;
+	smp_wmb();
+	set_work_pwq(work, pwq, 0);
+
+	/*
+	 * llist_add() implies a full barrier which pairs with the one
+	 * following nr_running decrements, see wq_worker_sleeping(),
+	 * worker_set_flags() and worker_thread().  Either a worker going
+	 * idle sees @work on the list, or we see nr_running at zero.
+	 */
+	llist_add(work_llnode(work), &pool->pending);
+
+	if (__need_more_worker(pool)) {
+		spin_lock(&pool->lock);
+		pool_drain_pending(pool);
+		spin_unlock(&pool->lock);
+	}
+}
+
 /*
  * Test whether @work is being queued from another work executing on the
  * same workqueue.
@@ -1294,8 +1485,6 @@ static void __queue_work(int cpu, struct workqueue_struct *wq,
 {
 	struct pool_workqueue *pwq;
 	struct worker_pool *last_pool;
-	struct list_head *worklist;
-	unsigned int work_flags;
 	unsigned int req_cpu = cpu;
 
 	/*
@@ -1320,7 +1509,7 @@ retry:
 	if (!(wq->flags & WQ_UNBOUND))
 		pwq = per_cpu_ptr(wq->cpu_pwqs, cpu);
 	else
-		pwq = unbound_pwq_by_node(wq, cpu_to_node(cpu));
+		pwq = unbound_pwq_by_cpu(wq, cpu);
 
 	/*
 	 * If @work was previously on a different pool, it might still be
@@ -1328,6 +1517,18 @@ retry:
 	 * pool to guarantee non-reentrancy.
 	 */
 	last_pool = get_work_pool(work);
+
+	/*
+	 * Per-cpu pwqs never go away while their workqueue is alive, so
+	 * unless @work may still be running on another pool it can be
+	 * queued without pool->lock.
+	 */
+	if (!(wq->flags & WQ_UNBOUND) &&
+	    (!last_pool || last_pool == pwq->pool)) {
+		queue_work_lockless(req_cpu, pwq, work);
+		return;
+	}
+
 	if (last_pool && last_pool != pwq->pool) {
 		struct worker *worker;
 
@@ -1350,7 +1551,7 @@ retry:
 	 * pwq is determined and locked.  For unbound pools, we could have
 	 * raced with pwq release and it could already be dead.  If its
 	 * refcnt is zero, repeat pwq selection.  Note that pwqs never die
-	 * without another pwq replacing it in the numa_pwq_tbl or while
+	 * without another pwq replacing it in the cpu_pwq_tbl or while
 	 * work items are executing on it, so the retrying is guaranteed to
 	 * make forward-progress.
 	 */
@@ -1373,20 +1574,9 @@ retry:
 		return;
 	}
 
-	pwq->nr_in_flight[pwq->work_color]++;
-	work_flags = work_color_to_flags(pwq->work_color);
-
-	if (likely(pwq->nr_active < pwq->max_active)) {
-		trace_workqueue_activate_work(work);
-		pwq->nr_active++;
-        //ȡworker_poolworklist
-		worklist = &pwq->pool->worklist;
-	} else {
-		work_flags |= WORK_STRUCT_DELAYED;
-		worklist = &pwq->delayed_works;
-	}
-    //struct work_struct *workӵworklist﻽workӦĽ
-	insert_work(pwq, work, worklist, work_flags);
+	/* keep the pool FIFO wrt. locklessly queued items */
+	pool_drain_pending(pwq->pool);
+	pwq_queue_work(pwq, work);
 
 	spin_unlock(&pwq->pool->lock);
 }
@@ -2319,6 +2509,16 @@ recheck:
 
 	worker_set_flags(worker, WORKER_PREP, false);
 sleep:
+	/*
+	 * A lockless queuer that saw us running skipped waking anyone up.
+	 * Order the nr_running decrement above against the pending list
+	 * test in need_more_worker(); pairs with llist_add() in
+	 * queue_work_lockless().
+	 */
+	smp_mb();
+	if (unlikely(need_more_worker(pool)))
+		goto recheck;
+
 	if (unlikely(need_to_manage_workers(pool)) && manage_workers(worker))
 		goto recheck;
 
@@ -2406,6 +2606,7 @@ repeat:
 		 * process'em.
 		 */
 		WARN_ON_ONCE(!list_empty(&rescuer->scheduled));
+		pool_drain_pending(pool);
 		list_for_each_entry_safe(work, n, &pool->worklist, entry)
 			if (get_work_pwq(work) == pwq)
 				move_linked_works(work, scheduled, &n);
@@ -2564,6 +2765,9 @@ static bool flush_workqueue_prep_pwqs(struct workqueue_struct *wq,
 
 		spin_lock_irq(&pool->lock);
 
+		/* account locklessly queued items to the current color */
+		pool_drain_pending(pool);
+
 		if (flush_color >= 0) {
 			WARN_ON_ONCE(pwq->flush_color != -1);
 
@@ -2812,11 +3016,16 @@ static bool start_flush_work(struct work_struct *work, struct wq_barrier *barr)
 	}
 
 	spin_lock(&pool->lock);
+	pool_drain_pending(pool);
 	/* see the comment in try_to_grab_pending() with the same code */
 	pwq = get_work_pwq(work);
 	if (pwq) {
 		if (unlikely(pwq->pool != pool))
 			goto already_gone;
+		/* racing with queue_work_lockless(), treat as not queued yet */
+		smp_rmb();
+		if (unlikely(!work->entry.prev))
+			goto already_gone;
 	} else {
 		worker = find_worker_executing_work(pool, work);
 		if (!worker)
@@ -3198,13 +3407,13 @@ static ssize_t wq_pool_ids_show(struct device *dev,
 {
 	struct workqueue_struct *wq = dev_to_wq(dev);
 	const char *delim = "";
-	int node, written = 0;
+	int cpu, written = 0;
 
 	rcu_read_lock_sched();
-	for_each_node(node) {
+	for_each_possible_cpu(cpu) {
 		written += scnprintf(buf + written, PAGE_SIZE - written,
-				     "%s%d:%d", delim, node,
-				     unbound_pwq_by_node(wq, node)->pool->id);
+				     "%s%d:%d", delim, cpu,
+				     unbound_pwq_by_cpu(wq, cpu)->pool->id);
 		delim = " ";
 	}
 	written += scnprintf(buf + written, PAGE_SIZE - written, "\n");
@@ -3304,7 +3513,7 @@ static ssize_t wq_numa_show(struct device *dev, struct device_attribute *attr,
 
 	mutex_lock(&wq->mutex);
 	written = scnprintf(buf, PAGE_SIZE, "%d\n",
-			    !wq->unbound_attrs->no_numa);
+			    wq->unbound_attrs->affn_scope != WQ_AFFN_SYSTEM);
 	mutex_unlock(&wq->mutex);
 
 	return written;
@@ -3323,7 +3532,7 @@ static ssize_t wq_numa_store(struct device *dev, struct device_attribute *attr,
 
 	ret = -EINVAL;
 	if (sscanf(buf, "%d", &v) == 1) {
-		attrs->no_numa = !v;
+		attrs->affn_scope = v ? WQ_AFFN_NUMA : WQ_AFFN_SYSTEM;
 		ret = apply_workqueue_attrs(wq, attrs);
 	}
 
@@ -3331,11 +3540,49 @@ static ssize_t wq_numa_store(struct device *dev, struct device_attribute *attr,
 	return ret ?: count;
 }
 
+static ssize_t wq_affn_scope_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	struct workqueue_struct *wq = dev_to_wq(dev);
+	int written;
+
+	mutex_lock(&wq->mutex);
+	written = scnprintf(buf, PAGE_SIZE, "%s\n",
+			    wq_affn_names[wq->unbound_attrs->affn_scope]);
+	mutex_unlock(&wq->mutex);
+
+	return written;
+}
+
+static ssize_t wq_affn_scope_store(struct device *dev,
+				   struct device_attribute *attr,
+				   const char *buf, size_t count)
+{
+	struct workqueue_struct *wq = dev_to_wq(dev);
+	struct workqueue_attrs *attrs;
+	int affn, ret;
+
+	affn = parse_affn_scope(buf);
+	if (affn < 0)
+		return affn;
+
+	attrs = wq_sysfs_prep_attrs(wq);
+	if (!attrs)
+		return -ENOMEM;
+
+	attrs->affn_scope = affn;
+	ret = apply_workqueue_attrs(wq, attrs);
+
+	free_workqueue_attrs(attrs);
+	return ret ?: count;
+}
+
 static struct device_attribute wq_sysfs_unbound_attrs[] = {
 	__ATTR(pool_ids, 0444, wq_pool_ids_show, NULL),
 	__ATTR(nice, 0644, wq_nice_show, wq_nice_store),
 	__ATTR(cpumask, 0644, wq_cpumask_show, wq_cpumask_store),
 	__ATTR(numa, 0644, wq_numa_show, wq_numa_store),
+	__ATTR(affinity_scope, 0644, wq_affn_scope_show, wq_affn_scope_store),
 	__ATTR_NULL,
 };
 
@@ -3477,6 +3724,7 @@ struct workqueue_attrs *alloc_workqueue_attrs(gfp_t gfp_mask)
 		goto fail;
 
 	cpumask_copy(attrs->cpumask, cpu_possible_mask);
+	attrs->affn_scope = wq_affn_dfl;
 	return attrs;
 fail:
 	free_workqueue_attrs(attrs);
@@ -3490,10 +3738,10 @@ static void copy_workqueue_attrs(struct workqueue_attrs *to,
 	cpumask_copy(to->cpumask, from->cpumask);
 	/*
 	 * Unlike hash and equality test, this function doesn't ignore
-	 * ->no_numa as it is used for both pool and wq attrs.  Instead,
-	 * get_unbound_pool() explicitly clears ->no_numa after copying.
+	 * ->affn_scope as it is used for both pool and wq attrs.  Instead,
+	 * get_unbound_pool() explicitly resets ->affn_scope after copying.
 	 */
-	to->no_numa = from->no_numa;
+	to->affn_scope = from->affn_scope;
 }
 
 /* hash value of the content of @attr */
@@ -3535,6 +3783,7 @@ static int init_worker_pool(struct worker_pool *pool)
 	pool->node = NUMA_NO_NODE;
 	pool->flags |= POOL_DISASSOCIATED;
 	INIT_LIST_HEAD(&pool->worklist);
+	init_llist_head(&pool->pending);
 	INIT_LIST_HEAD(&pool->idle_list);
 	hash_init(pool->busy_hash);
 
@@ -3662,10 +3911,10 @@ static struct worker_pool *get_unbound_pool(const struct workqueue_attrs *attrs)
 	copy_workqueue_attrs(pool->attrs, attrs);
 
 	/*
-	 * no_numa isn't a worker_pool attribute, always clear it.  See
+	 * affn_scope isn't a worker_pool attribute, always reset it.  See
 	 * 'struct workqueue_attrs' comments for detail.
 	 */
-	pool->attrs->no_numa = false;
+	pool->attrs->affn_scope = WQ_AFFN_SYSTEM;
 
 	/* if cpumask is contained inside a NUMA node, we belong to that node */
 	if (wq_numa_enabled) {
@@ -3860,42 +4109,78 @@ static void free_unbound_pwq(struct pool_workqueue *pwq)
 }
 
 /**
- * wq_calc_node_mask - calculate a wq_attrs' cpumask for the specified node
+ * wq_pod_cpumask - the pod a CPU belongs to in an affinity scope
+ * @scope: WQ_AFFN_* affinity scope
+ * @cpu: the CPU of interest
+ *
+ * The SMT and cache pods come from the CPU topology and thus only cover
+ * CPUs which have been brought up; wq_update_pod() refreshes the affected
+ * entries as CPUs come and go.  Scopes the machine can't describe fall
+ * back to the next wider one.
+ */
+static const struct cpumask *wq_pod_cpumask(int scope, int cpu)
+{
+	switch (scope) {
+	case WQ_AFFN_CPU:
+		return cpumask_of(cpu);
+	case WQ_AFFN_SMT:
+		return topology_thread_cpumask(cpu);
+	case WQ_AFFN_CACHE:
+#ifdef CONFIG_SCHED_MC
+		return cpu_coregroup_mask(cpu);
+#endif
+		/* fall through */
+	case WQ_AFFN_NUMA:
+		if (wq_numa_enabled)
+			return wq_numa_possible_cpumask[cpu_to_node(cpu)];
+		/* fall through */
+	default:
+		return cpu_possible_mask;
+	}
+}
+
+/**
+ * wq_calc_pod_cpumask - calculate a wq_attrs' cpumask for the pod of a CPU
  * @attrs: the wq_attrs of interest
- * @node: the target NUMA node
+ * @cpu: the target CPU
  * @cpu_going_down: if >= 0, the CPU to consider as offline
  * @cpumask: outarg, the resulting cpumask
  *
- * Calculate the cpumask a workqueue with @attrs should use on @node.  If
- * @cpu_going_down is >= 0, that cpu is considered offline during
- * calculation.  The result is stored in @cpumask.  This function returns
- * %true if the resulting @cpumask is different from @attrs->cpumask,
- * %false if equal.
+ * Calculate the cpumask a workqueue with @attrs should use for work items
+ * issued on @cpu.  If @cpu_going_down is >= 0, that cpu is considered
+ * offline during calculation.  The result is stored in @cpumask.  This
+ * function returns %true if the resulting @cpumask is different from
+ * @attrs->cpumask, %false if equal.
  *
- * If NUMA affinity is not enabled, @attrs->cpumask is always used.  If
- * enabled and @node has online CPUs requested by @attrs, the returned
- * cpumask is the intersection of the possible CPUs of @node and
+ * If the affinity scope is WQ_AFFN_SYSTEM, @attrs->cpumask is always
+ * used.  Otherwise, if the pod of @cpu has online CPUs requested by
+ * @attrs, the returned cpumask is the intersection of the pod and
  * @attrs->cpumask.
  *
- * The caller is responsible for ensuring that the cpumask of @node stays
+ * The caller is responsible for ensuring that the pod of @cpu stays
  * stable.
  */
-static bool wq_calc_node_cpumask(const struct workqueue_attrs *attrs, int node,
-				 int cpu_going_down, cpumask_t *cpumask)
+static bool wq_calc_pod_cpumask(const struct workqueue_attrs *attrs, int cpu,
+				int cpu_going_down, cpumask_t *cpumask)
 {
-	if (!wq_numa_enabled || attrs->no_numa)
+	const struct cpumask *pod;
+
+	if (attrs->affn_scope == WQ_AFFN_SYSTEM)
 		goto use_dfl;
 
-	/* does @node have any online CPUs @attrs wants? */
-	cpumask_and(cpumask, cpumask_of_node(node), attrs->cpumask);
+	pod = wq_pod_cpumask(attrs->affn_scope, cpu);
+
+	/* does the pod have any online CPUs @attrs wants? */
+	cpumask_and(cpumask, pod, attrs->cpumask);
+	cpumask_and(cpumask, cpumask, cpu_online_mask);
 	if (cpu_going_down >= 0)
 		cpumask_clear_cpu(cpu_going_down, cpumask);
 
 	if (cpumask_empty(cpumask))
 		goto use_dfl;
 
-	/* yeap, return possible CPUs in @node that @attrs wants */
-	cpumask_and(cpumask, attrs->cpumask, wq_numa_possible_cpumask[node]);
+	/* yeap, return CPUs of the pod that @attrs wants */
+	cpumask_and(cpumask, attrs->cpumask, pod);
 	return !cpumask_equal(cpumask, attrs->cpumask);
 
 use_dfl:
@@ -3903,10 +4188,10 @@ use_dfl:
 	return false;
 }
 
-/* install @pwq into @wq's numa_pwq_tbl[] for @node and return the old pwq */
-static struct pool_workqueue *numa_pwq_tbl_install(struct workqueue_struct *wq,
-						   int node,
-						   struct pool_workqueue *pwq)
+/* install @pwq into @wq's cpu_pwq_tbl[] for @cpu and return the old pwq */
+static struct pool_workqueue *cpu_pwq_tbl_install(struct workqueue_struct *wq,
+						  int cpu,
+						  struct pool_workqueue *pwq)
 {
 	struct pool_workqueue *old_pwq;
 
@@ -3915,8 +4200,8 @@ static struct pool_workqueue *numa_pwq_tbl_install(struct workqueue_struct *wq,
 	/* link_pwq() can handle duplicate calls */
 	link_pwq(pwq);
 
-	old_pwq = rcu_access_pointer(wq->numa_pwq_tbl[node]);
-	rcu_assign_pointer(wq->numa_pwq_tbl[node], pwq);
+	old_pwq = rcu_access_pointer(wq->cpu_pwq_tbl[cpu]);
+	rcu_assign_pointer(wq->cpu_pwq_tbl[cpu], pwq);
 	return old_pwq;
 }
 
@@ -3925,12 +4210,13 @@ static struct pool_workqueue *numa_pwq_tbl_install(struct workqueue_struct *wq,
  * @wq: the target workqueue
  * @attrs: the workqueue_attrs to apply, allocated with alloc_workqueue_attrs()
  *
- * Apply @attrs to an unbound workqueue @wq.  Unless disabled, on NUMA
- * machines, this function maps a separate pwq to each NUMA node with
- * possibles CPUs in @attrs->cpumask so that work items are affine to the
- * NUMA node it was issued on.  Older pwqs are released as in-flight work
- * items finish.  Note that a work item which repeatedly requeues itself
- * back-to-back will stay on its current pwq.
+ * Apply @attrs to an unbound workqueue @wq.  Unless the affinity scope is
+ * WQ_AFFN_SYSTEM, this function maps a separate pwq to each pod of
+ * @attrs->affn_scope with CPUs in @attrs->cpumask so that work items are
+ * affine to the pod they were issued on.  All CPUs of a pod share its
+ * pwq.  Older pwqs are released as in-flight work items finish.  Note
+ * that a work item which repeatedly requeues itself back-to-back will
+ * stay on its current pwq.
  *
  * Performs GFP_KERNEL allocations.  Returns 0 on success and -errno on
  * failure.
@@ -3939,8 +4225,8 @@ int apply_workqueue_attrs(struct workqueue_struct *wq,
 			  const struct workqueue_attrs *attrs)
 {
 	struct workqueue_attrs *new_attrs, *tmp_attrs;
-	struct pool_workqueue **pwq_tbl, *dfl_pwq;
-	int node, ret;
+	struct pool_workqueue **pwq_tbl, *dfl_pwq, *pwq;
+	int cpu, sib, ret;
 
 	/* only unbound workqueues can change attributes */
 	if (WARN_ON(!(wq->flags & WQ_UNBOUND)))
@@ -3950,7 +4236,11 @@ int apply_workqueue_attrs(struct workqueue_struct *wq,
 	if (WARN_ON((wq->flags & __WQ_ORDERED) && !list_empty(&wq->pwqs)))
 		return -EINVAL;
 
-	pwq_tbl = kzalloc(wq_numa_tbl_len * sizeof(pwq_tbl[0]), GFP_KERNEL);
+	if (WARN_ON(attrs->affn_scope < 0 ||
+		    attrs->affn_scope >= WQ_AFFN_NR_TYPES))
+		return -EINVAL;
+
+	pwq_tbl = kzalloc(nr_cpu_ids * sizeof(pwq_tbl[0]), GFP_KERNEL);
 	new_attrs = alloc_workqueue_attrs(GFP_KERNEL);
 	tmp_attrs = alloc_workqueue_attrs(GFP_KERNEL);
 	if (!pwq_tbl || !new_attrs || !tmp_attrs)
@@ -3969,7 +4259,7 @@ int apply_workqueue_attrs(struct workqueue_struct *wq,
 
 	/*
 	 * CPUs should stay stable across pwq creations and installations.
-	 * Pin CPUs, determine the target cpumask for each node and create
+	 * Pin CPUs, determine the target cpumask for each pod and create
 	 * pwqs accordingly.
 	 */
 	get_online_cpus();
@@ -3985,15 +4275,31 @@ int apply_workqueue_attrs(struct workqueue_struct *wq,
 	if (!dfl_pwq)
 		goto enomem_pwq;
 
-	for_each_node(node) {
-		if (wq_calc_node_cpumask(attrs, node, -1, tmp_attrs->cpumask)) {
-			pwq_tbl[node] = alloc_unbound_pwq(wq, tmp_attrs);
-			if (!pwq_tbl[node])
-				goto enomem_pwq;
-		} else {
+	for_each_possible_cpu(cpu) {
+		if (!wq_calc_pod_cpumask(new_attrs, cpu, -1,
+					 tmp_attrs->cpumask)) {
 			dfl_pwq->refcnt++;
-			pwq_tbl[node] = dfl_pwq;
+			pwq_tbl[cpu] = dfl_pwq;
+			continue;
+		}
+
+		/* share the pwq of a pod sibling set up earlier */
+		pwq = NULL;
+		for_each_cpu(sib, wq_pod_cpumask(new_attrs->affn_scope, cpu)) {
+			if (pwq_tbl[sib] && pwq_tbl[sib] != dfl_pwq &&
+			    cpumask_equal(pwq_tbl[sib]->pool->attrs->cpumask,
+					  tmp_attrs->cpumask)) {
+				pwq = pwq_tbl[sib];
+				pwq->refcnt++;
+				break;
+			}
 		}
+
+		if (!pwq)
+			pwq = alloc_unbound_pwq(wq, tmp_attrs);
+		if (!pwq)
+			goto enomem_pwq;
+		pwq_tbl[cpu] = pwq;
 	}
 
 	mutex_unlock(&wq_pool_mutex);
@@ -4004,8 +4310,8 @@ int apply_workqueue_attrs(struct workqueue_struct *wq,
 	copy_workqueue_attrs(wq->unbound_attrs, new_attrs);
 
 	/* save the previous pwq and install the new one */
-	for_each_node(node)
-		pwq_tbl[node] = numa_pwq_tbl_install(wq, node, pwq_tbl[node]);
+	for_each_possible_cpu(cpu)
+		pwq_tbl[cpu] = cpu_pwq_tbl_install(wq, cpu, pwq_tbl[cpu]);
 
 	/* @dfl_pwq might not have been used, ensure it's linked */
 	link_pwq(dfl_pwq);
@@ -4014,8 +4320,8 @@ int apply_workqueue_attrs(struct workqueue_struct *wq,
 	mutex_unlock(&wq->mutex);
 
 	/* put the old pwqs */
-	for_each_node(node)
-		put_pwq_unlocked(pwq_tbl[node]);
+	for_each_possible_cpu(cpu)
+		put_pwq_unlocked(pwq_tbl[cpu]);
 	put_pwq_unlocked(dfl_pwq);
 
 	put_online_cpus();
@@ -4029,9 +4335,12 @@ out_free:
 
 enomem_pwq:
 	free_unbound_pwq(dfl_pwq);
-	for_each_node(node)
-		if (pwq_tbl && pwq_tbl[node] != dfl_pwq)
-			free_unbound_pwq(pwq_tbl[node]);
+	for_each_possible_cpu(cpu) {
+		pwq = pwq_tbl[cpu];
+		/* pwqs shared inside a pod are freed with their last user */
+		if (pwq && pwq != dfl_pwq && !--pwq->refcnt)
+			free_unbound_pwq(pwq);
+	}
 	mutex_unlock(&wq_pool_mutex);
 	put_online_cpus();
 enomem:
@@ -4039,56 +4348,27 @@ enomem:
 	goto out_free;
 }
 
-/**
- * wq_update_unbound_numa - update NUMA affinity of a wq for CPU hot[un]plug
- * @wq: the target workqueue
- * @cpu: the CPU coming up or going down
- * @online: whether @cpu is coming up or going down
- *
- * This function is to be called from %CPU_DOWN_PREPARE, %CPU_ONLINE and
- * %CPU_DOWN_FAILED.  @cpu is being hot[un]plugged, update NUMA affinity of
- * @wq accordingly.
- *
- * If NUMA affinity can't be adjusted due to memory allocation failure, it
- * falls back to @wq->dfl_pwq which may not be optimal but is always
- * correct.
- *
- * Note that when the last allowed CPU of a NUMA node goes offline for a
- * workqueue with a cpumask spanning multiple nodes, the workers which were
- * already executing the work items for the workqueue will lose their CPU
- * affinity and may execute on any CPU.  This is similar to how per-cpu
- * workqueues behave on CPU_DOWN.  If a workqueue user wants strict
- * affinity, it's the user's responsibility to flush the work item from
- * CPU_DOWN_PREPARE.
- */
-static void wq_update_unbound_numa(struct workqueue_struct *wq, int cpu,
-				   bool online)
+/* update the pwq @wq uses for work items issued on @cpu */
+static void wq_update_pod_cpu(struct workqueue_struct *wq, int cpu,
+			      int cpu_off)
 {
-	int node = cpu_to_node(cpu);
-	int cpu_off = online ? -1 : cpu;
 	struct pool_workqueue *old_pwq = NULL, *pwq;
 	struct workqueue_attrs *target_attrs;
 	cpumask_t *cpumask;
-
-	lockdep_assert_held(&wq_pool_mutex);
-
-	if (!wq_numa_enabled || !(wq->flags & WQ_UNBOUND))
-		return;
+	int sib;
 
 	/*
 	 * We don't wanna alloc/free wq_attrs for each wq for each CPU.
 	 * Let's use a preallocated one.  The following buf is protected by
 	 * CPU hotplug exclusion.
 	 */
-	target_attrs = wq_update_unbound_numa_attrs_buf;
+	target_attrs = wq_update_pod_attrs_buf;
 	cpumask = target_attrs->cpumask;
 
 	mutex_lock(&wq->mutex);
-	if (wq->unbound_attrs->no_numa)
-		goto out_unlock;
 
 	copy_workqueue_attrs(target_attrs, wq->unbound_attrs);
-	pwq = unbound_pwq_by_node(wq, node);
+	pwq = unbound_pwq_by_cpu(wq, cpu);
 
 	/*
 	 * Let's determine what needs to be done.  If the target cpumask is
@@ -4097,7 +4377,7 @@ static void wq_update_unbound_numa(struct workqueue_struct *wq, int cpu,
 	 * wq's, the default pwq should be used.  If @pwq is already the
 	 * default one, nothing to do; otherwise, install the default one.
 	 */
-	if (wq_calc_node_cpumask(wq->unbound_attrs, node, cpu_off, cpumask)) {
+	if (wq_calc_pod_cpumask(wq->unbound_attrs, cpu, cpu_off, cpumask)) {
 		if (cpumask_equal(cpumask, pwq->pool->attrs->cpumask))
 			goto out_unlock;
 	} else {
@@ -4107,12 +4387,25 @@ static void wq_update_unbound_numa(struct workqueue_struct *wq, int cpu,
 			goto use_dfl_pwq;
 	}
 
+	/* a pod sibling updated before us may already have a matching pwq */
+	for_each_cpu(sib, wq_pod_cpumask(target_attrs->affn_scope, cpu)) {
+		pwq = unbound_pwq_by_cpu(wq, sib);
+		if (pwq != wq->dfl_pwq &&
+		    cpumask_equal(cpumask, pwq->pool->attrs->cpumask)) {
+			spin_lock_irq(&pwq->pool->lock);
+			get_pwq(pwq);
+			spin_unlock_irq(&pwq->pool->lock);
+			old_pwq = cpu_pwq_tbl_install(wq, cpu, pwq);
+			goto out_unlock;
+		}
+	}
+
 	mutex_unlock(&wq->mutex);
 
 	/* create a new pwq */
 	pwq = alloc_unbound_pwq(wq, target_attrs);
 	if (!pwq) {
-		pr_warning("workqueue: allocation failed while updating NUMA affinity of \"%s\"\n",
+		pr_warning("workqueue: allocation failed while updating affinity of \"%s\"\n",
 			   wq->name);
 		mutex_lock(&wq->mutex);
 		goto use_dfl_pwq;
@@ -4125,19 +4418,63 @@ static void wq_update_unbound_numa(struct workqueue_struct *wq, int cpu,
 	 * inbetween.
 	 */
 	mutex_lock(&wq->mutex);
-	old_pwq = numa_pwq_tbl_install(wq, node, pwq);
+	old_pwq = cpu_pwq_tbl_install(wq, cpu, pwq);
 	goto out_unlock;
 
 use_dfl_pwq:
 	spin_lock_irq(&wq->dfl_pwq->pool->lock);
 	get_pwq(wq->dfl_pwq);
 	spin_unlock_irq(&wq->dfl_pwq->pool->lock);
-	old_pwq = numa_pwq_tbl_install(wq, node, wq->dfl_pwq);
+	old_pwq = cpu_pwq_tbl_install(wq, cpu, wq->dfl_pwq);
 out_unlock:
 	mutex_unlock(&wq->mutex);
 	put_pwq_unlocked(old_pwq);
 }
 
+/**
+ * wq_update_pod - update pod affinity of a wq for CPU hot[un]plug
+ * @wq: the target workqueue
+ * @cpu: the CPU coming up or going down
+ * @online: whether @cpu is coming up or going down
+ *
+ * This function is to be called from %CPU_DOWN_PREPARE, %CPU_ONLINE and
+ * %CPU_DOWN_FAILED.  @cpu is being hot[un]plugged, update the pwqs of
+ * all CPUs in its pod accordingly.  For the SMT and cache scopes, this is
+ * also where pods pick up CPUs whose topology wasn't known yet when the
+ * workqueue was created.
+ *
+ * If pod affinity can't be adjusted due to memory allocation failure, it
+ * falls back to @wq->dfl_pwq which may not be optimal but is always
+ * correct.
+ *
+ * Note that when the last allowed CPU of a pod goes offline for a
+ * workqueue with a cpumask spanning multiple pods, the workers which were
+ * already executing the work items for the workqueue will lose their CPU
+ * affinity and may execute on any CPU.  This is similar to how per-cpu
+ * workqueues behave on CPU_DOWN.  If a workqueue user wants strict
+ * affinity, it's the user's responsibility to flush the work item from
+ * CPU_DOWN_PREPARE.
+ */
+static void wq_update_pod(struct workqueue_struct *wq, int cpu, bool online)
+{
+	int cpu_off = online ? -1 : cpu;
+	const struct cpumask *pod;
+	int tgt;
+
+	lockdep_assert_held(&wq_pool_mutex);
+
+	/* @wq->unbound_attrs can't change while CPU hotplug is in progress */
+	if (!(wq->flags & WQ_UNBOUND) ||
+	    wq->unbound_attrs->affn_scope == WQ_AFFN_SYSTEM)
+		return;
+
+	pod = wq_pod_cpumask(wq->unbound_attrs->affn_scope, cpu);
+	for_each_cpu(tgt, pod)
+		wq_update_pod_cpu(wq, tgt, cpu_off);
+	if (!cpumask_test_cpu(cpu, pod))
+		wq_update_pod_cpu(wq, cpu, cpu_off);
+}
+
 static int alloc_and_link_pwqs(struct workqueue_struct *wq)
 {
 	bool highpri = wq->flags & WQ_HIGHPRI;
@@ -4198,7 +4535,7 @@ struct workqueue_struct *__alloc_workqueue_key(const char *fmt,
 
 	/* allocate wq and format name */
 	if (flags & WQ_UNBOUND)
-		tbl_size = wq_numa_tbl_len * sizeof(wq->numa_pwq_tbl[0]);
+		tbl_size = nr_cpu_ids * sizeof(wq->cpu_pwq_tbl[0]);
 
 	wq = kzalloc(sizeof(*wq) + tbl_size, GFP_KERNEL);
 	if (!wq)
@@ -4297,7 +4634,7 @@ EXPORT_SYMBOL_GPL(__alloc_workqueue_key);
 void destroy_workqueue(struct workqueue_struct *wq)
 {
 	struct pool_workqueue *pwq;
-	int node;
+	int cpu;
 
 	/* drain it before proceeding with destruction */
 	drain_workqueue(wq);
@@ -4349,12 +4686,12 @@ void destroy_workqueue(struct workqueue_struct *wq)
 	} else {
 		/*
 		 * We're the sole accessor of @wq at this point.  Directly
-		 * access numa_pwq_tbl[] and dfl_pwq to put the base refs.
+		 * access cpu_pwq_tbl[] and dfl_pwq to put the base refs.
 		 * @wq will be freed when the last pwq is released.
 		 */
-		for_each_node(node) {
-			pwq = rcu_access_pointer(wq->numa_pwq_tbl[node]);
-			RCU_INIT_POINTER(wq->numa_pwq_tbl[node], NULL);
+		for_each_possible_cpu(cpu) {
+			pwq = rcu_access_pointer(wq->cpu_pwq_tbl[cpu]);
+			RCU_INIT_POINTER(wq->cpu_pwq_tbl[cpu], NULL);
 			put_pwq_unlocked(pwq);
 		}
 
@@ -4444,7 +4781,7 @@ bool workqueue_congested(int cpu, struct workqueue_struct *wq)
 	if (!(wq->flags & WQ_UNBOUND))
 		pwq = per_cpu_ptr(wq->cpu_pwqs, cpu);
 	else
-		pwq = unbound_pwq_by_node(wq, cpu_to_node(cpu));
+		pwq = unbound_pwq_by_cpu(wq, cpu);
 
 	ret = !list_empty(&pwq->delayed_works);
 	rcu_read_unlock_sched();
@@ -4776,9 +5113,9 @@ static int __cpuinit workqueue_cpu_up_callback(struct notifier_block *nfb,
 			mutex_unlock(&pool->manager_mutex);
 		}
 
-		/* update NUMA affinity of unbound workqueues */
+		/* update pod affinity of unbound workqueues */
 		list_for_each_entry(wq, &workqueues, list)
-			wq_update_unbound_numa(wq, cpu, true);
+			wq_update_pod(wq, cpu, true);
 
 		mutex_unlock(&wq_pool_mutex);
 		break;
@@ -4804,10 +5141,10 @@ static int __cpuinit workqueue_cpu_down_callback(struct notifier_block *nfb,
 		INIT_WORK_ONSTACK(&unbind_work, wq_unbind_fn);
 		queue_work_on(cpu, system_highpri_wq, &unbind_work);
 
-		/* update NUMA affinity of unbound workqueues */
+		/* update pod affinity of unbound workqueues */
 		mutex_lock(&wq_pool_mutex);
 		list_for_each_entry(wq, &workqueues, list)
-			wq_update_unbound_numa(wq, cpu, false);
+			wq_update_pod(wq, cpu, false);
 		mutex_unlock(&wq_pool_mutex);
 
 		/* wait for per-cpu unbinding to finish */
@@ -4991,7 +5328,7 @@ static void __init wq_numa_init(void)
 	cpumask_var_t *tbl;
 	int node, cpu;
 
-	/* determine NUMA pwq table len - highest node id + 1 */
+	/* determine node table len - highest node id + 1 */
 	for_each_node(node)
 		wq_numa_tbl_len = max(wq_numa_tbl_len, node + 1);
 
@@ -5003,9 +5340,6 @@ static void __init wq_numa_init(void)
 		return;
 	}
 
-	wq_update_unbound_numa_attrs_buf = alloc_workqueue_attrs(GFP_KERNEL);
-	BUG_ON(!wq_update_unbound_numa_attrs_buf);
-
 	/*
 	 * We want masks of possible CPUs of each node which isn't readily
 	 * available.  Build one from cpu_to_node() which should have been
@@ -5048,6 +5382,9 @@ static int __init init_workqueues(void)
 	cpu_notifier(workqueue_cpu_up_callback, CPU_PRI_WORKQUEUE_UP);
 	hotcpu_notifier(workqueue_cpu_down_callback, CPU_PRI_WORKQUEUE_DOWN);
 
+	wq_update_pod_attrs_buf = alloc_workqueue_attrs(GFP_KERNEL);
+	BUG_ON(!wq_update_pod_attrs_buf);
+
 	wq_numa_init();
 
 	/* initialize CPU pools */
@@ -5085,16 +5422,19 @@ static int __init init_workqueues(void)
 
 		BUG_ON(!(attrs = alloc_workqueue_attrs(GFP_KERNEL)));
 		attrs->nice = std_nice[i];
+		/* keep unbound work off full dynticks CPUs by default */
+		cpumask_copy(attrs->cpumask, housekeeping_cpumask());
 		unbound_std_wq_attrs[i] = attrs;
 
 		/*
 		 * An ordered wq should have only one pwq as ordering is
 		 * guaranteed by max_active which is enforced by pwqs.
-		 * Turn off NUMA so that dfl_pwq is used for all nodes.
+		 * Use the system scope so that dfl_pwq is used for all CPUs.
 		 */
 		BUG_ON(!(attrs = alloc_workqueue_attrs(GFP_KERNEL)));
 		attrs->nice = std_nice[i];
-		attrs->no_numa = true;
+		attrs->affn_scope = WQ_AFFN_SYSTEM;
+		cpumask_copy(attrs->cpumask, housekeeping_cpumask());
 		ordered_wq_attrs[i] = attrs;
 	}
 
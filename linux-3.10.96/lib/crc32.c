@@ -177,26 +177,44 @@ static inline u32 __pure crc32_le_generic(u32 crc, unsigned char const *p,
 }
 
 #if CRC_LE_BITS == 1
-u32 __pure crc32_le(u32 crc, unsigned char const *p, size_t len)
+static u32 __pure crc32_le_base(u32 crc, unsigned char const *p, size_t len)
 {
 	return crc32_le_generic(crc, p, len, NULL, CRCPOLY_LE);
 }
-u32 __pure __crc32c_le(u32 crc, unsigned char const *p, size_t len)
+static u32 __pure __crc32c_le_base(u32 crc, unsigned char const *p, size_t len)
 {
 	return crc32_le_generic(crc, p, len, NULL, CRC32C_POLY_LE);
 }
 #else
-u32 __pure crc32_le(u32 crc, unsigned char const *p, size_t len)
+static u32 __pure crc32_le_base(u32 crc, unsigned char const *p, size_t len)
 {
 	return crc32_le_generic(crc, p, len,
 			(const u32 (*)[256])crc32table_le, CRCPOLY_LE);
 }
-u32 __pure __crc32c_le(u32 crc, unsigned char const *p, size_t len)
+static u32 __pure __crc32c_le_base(u32 crc, unsigned char const *p, size_t len)
 {
 	return crc32_le_generic(crc, p, len,
 			(const u32 (*)[256])crc32ctable_le, CRC32C_POLY_LE);
 }
 #endif
+
+/*
+ * The table (or bitwise) code is the fallback for an arch implementation.
+ * These wrappers are not __pure: the arch path may save and restore FP
+ * state around the computation.
+ */
+u32 crc32_le(u32 crc, unsigned char const *p, size_t len)
+{
+	if (crc32_arch_enabled())
+		return crc32_le_arch(crc, p, len);
+	return crc32_le_base(crc, p, len);
+}
+u32 __crc32c_le(u32 crc, unsigned char const *p, size_t len)
+{
+	if (crc32_arch_enabled())
+		return __crc32c_le_arch(crc, p, len);
+	return __crc32c_le_base(crc, p, len);
+}
 EXPORT_SYMBOL(crc32_le);
 EXPORT_SYMBOL(__crc32c_le);
 
@@ -1104,10 +1122,74 @@ static int __init crc32_test(void)
 	return 0;
 }
 
+#ifdef CONFIG_ARCH_HAS_CRC32
+static u64 __init crc32_time(u32 (*crc_fn)(u32, unsigned char const *, size_t),
+			     bool whole_buf, u32 *crc)
+{
+	struct timespec start, stop;
+	unsigned long flags;
+	int i;
+
+	local_irq_save(flags);
+
+	getnstimeofday(&start);
+	for (i = 0; i < 100; i++) {
+		if (whole_buf)
+			*crc ^= crc_fn(*crc, test_buf, sizeof(test_buf));
+		else
+			*crc ^= crc_fn(test[i].crc, test_buf +
+				       test[i].start, test[i].length);
+	}
+	getnstimeofday(&stop);
+
+	local_irq_restore(flags);
+
+	return stop.tv_nsec - start.tv_nsec +
+		1000000000 * (stop.tv_sec - start.tv_sec);
+}
+
+/*
+ * Time the arch code against the table code it replaces, over the test
+ * vectors and over the whole test buffer, which is long enough to take
+ * any bulk path the arch code has.
+ */
+static void __init crc32_bench(const char *name,
+	u32 (*arch_fn)(u32, unsigned char const *, size_t),
+	u32 (*base_fn)(u32, unsigned char const *, size_t))
+{
+	u32 arch_crc = 0, base_crc = 0;
+	u64 arch_nsec, base_nsec;
+	int i, bytes = 0;
+
+	if (!crc32_arch_enabled())
+		return;
+
+	for (i = 0; i < 100; i++)
+		bytes += test[i].length;
+
+	arch_nsec = crc32_time(arch_fn, false, &arch_crc);
+	base_nsec = crc32_time(base_fn, false, &base_crc);
+	pr_info("%s: %d bytes in test vectors: arch %lld nsec, table %lld nsec\n",
+		name, bytes, arch_nsec, base_nsec);
+
+	arch_nsec = crc32_time(arch_fn, true, &arch_crc);
+	base_nsec = crc32_time(base_fn, true, &base_crc);
+	pr_info("%s: 100 x %zu bytes: arch %lld nsec, table %lld nsec\n",
+		name, sizeof(test_buf), arch_nsec, base_nsec);
+
+	if (arch_crc != base_crc)
+		pr_warn("%s: arch and table results differ\n", name);
+}
+#endif
+
 static int __init crc32test_init(void)
 {
 	crc32_test();
 	crc32c_test();
+#ifdef CONFIG_ARCH_HAS_CRC32
+	crc32_bench("crc32", crc32_le_arch, crc32_le_base);
+	crc32_bench("crc32c", __crc32c_le_arch, __crc32c_le_base);
+#endif
 	return 0;
 }
 
@@ -32,6 +32,7 @@
  */
 
 #include <crypto/hash.h>
+#include <linux/crc32.h>
 #include <linux/err.h>
 #include <linux/init.h>
 #include <linux/kernel.h>
@@ -47,6 +48,10 @@ u32 crc32c(u32 crc, const void *address, unsigned int length)
 	} desc;
 	int err;
 
+	/* the CPU does it faster than any detour through the crypto API */
+	if (crc32_arch_enabled())
+		return __crc32c_le(crc, address, length);
+
 	desc.shash.tfm = tfm;
 	desc.shash.flags = 0;
 	*(u32 *)desc.ctx = crc;
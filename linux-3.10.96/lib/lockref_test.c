@@ -0,0 +1,93 @@
+/*
+ * Parallel stat benchmark for the dentry lockref: a work item on every
+ * online cpu (schedule_on_each_cpu()) repeatedly looks up and stats the
+ * same path, which makes all of them take and drop references on the
+ * same few dentries, and the aggregate rate is reported.  Run it with
+ * "path=" pointing into a hot directory, e.g. path=/usr/lib, and compare
+ * kernels with and without CONFIG_CMPXCHG_LOCKREF.
+ */
+#include <linux/module.h>
+#include <linux/workqueue.h>
+#include <linux/namei.h>
+#include <linux/fs.h>
+#include <linux/stat.h>
+#include <linux/jiffies.h>
+#include <linux/ktime.h>
+#include <linux/sched.h>
+
+static char *path = "/";
+module_param(path, charp, 0444);
+MODULE_PARM_DESC(path, "path to stat");
+
+static unsigned int duration_ms = 1000;
+module_param(duration_ms, uint, 0444);
+MODULE_PARM_DESC(duration_ms, "run time in milliseconds");
+
+static atomic_long_t total_ops;
+static unsigned long test_end;
+static int test_error;
+
+static void stat_work_fn(struct work_struct *work)
+{
+	unsigned long end = test_end, ops = 0;
+	struct kstat stat;
+	struct path p;
+	int err;
+
+	while (time_before(jiffies, end)) {
+		err = kern_path(path, LOOKUP_FOLLOW, &p);
+		if (!err) {
+			err = vfs_getattr(&p, &stat);
+			path_put(&p);
+		}
+		if (err) {
+			test_error = err;
+			break;
+		}
+		ops++;
+		if (!(ops & 255))
+			cond_resched();
+	}
+
+	atomic_long_add(ops, &total_ops);
+}
+
+static int __init lockref_test_init(void)
+{
+	unsigned long ops;
+	ktime_t start;
+	s64 ns;
+	int err;
+
+	/* a common deadline, so late-starting cpus don't stretch the run */
+	test_end = jiffies + msecs_to_jiffies(duration_ms);
+	start = ktime_get();
+	err = schedule_on_each_cpu(stat_work_fn);
+	if (err)
+		return err;
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	if (test_error) {
+		pr_err("stat %s failed: %d\n", path, test_error);
+		return -EAGAIN;
+	}
+
+	ops = atomic_long_read(&total_ops);
+	pr_info("stat %s: %u cpus, %lu ops in %llu ms, %llu ops/s%s\n",
+		path, num_online_cpus(), ops,
+		(unsigned long long)div_u64(ns, NSEC_PER_MSEC),
+		(unsigned long long)div64_u64((u64)ops * NSEC_PER_SEC, ns ?: 1),
+		IS_ENABLED(CONFIG_CMPXCHG_LOCKREF) ? " (cmpxchg lockref)" : "");
+
+	return -EAGAIN; /* Fail will directly unload the module */
+}
+
+static void __exit lockref_test_exit(void)
+{
+}
+
+module_init(lockref_test_init)
+module_exit(lockref_test_exit)
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Parallel stat benchmark for dentry lockref");
@@ -0,0 +1,133 @@
+/*
+ * Refcount scalability benchmark: every online cpu hammers get/put on a
+ * single shared refcount from schedule_on_each_cpu(), first an
+ * atomic_long_t and then a percpu_ref, and the time per get/put pair is
+ * reported.  Finally the percpu_ref is killed half way through a run to
+ * check that the switch to atomic mode keeps the count exact: with one
+ * extra ref held across the run, exactly that ref must be left afterwards.
+ */
+#include <linux/module.h>
+#include <linux/workqueue.h>
+#include <linux/percpu-refcount.h>
+#include <linux/ktime.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+
+static unsigned int loops = 1000000;
+module_param(loops, uint, 0444);
+MODULE_PARM_DESC(loops, "get/put pairs per cpu");
+
+static atomic_long_t test_atomic;
+static struct percpu_ref test_ref;
+static bool test_released;
+static atomic_t test_kill_pending;
+
+static void test_ref_release(struct percpu_ref *ref)
+{
+	test_released = true;
+}
+
+static void atomic_bench_fn(struct work_struct *work)
+{
+	unsigned int i;
+
+	for (i = 0; i < loops; i++) {
+		atomic_long_inc(&test_atomic);
+		atomic_long_dec(&test_atomic);
+		if (!(i & 1023))
+			cond_resched();
+	}
+}
+
+/*
+ * With test_kill_pending set, whichever cpu gets half way first kills
+ * the ref while the others keep going.
+ */
+static void percpu_ref_bench_fn(struct work_struct *work)
+{
+	unsigned int i;
+
+	for (i = 0; i < loops; i++) {
+		percpu_ref_get(&test_ref);
+		percpu_ref_put(&test_ref);
+		if (i == loops / 2 && atomic_xchg(&test_kill_pending, 0))
+			percpu_ref_kill(&test_ref);
+		if (!(i & 1023))
+			cond_resched();
+	}
+}
+
+/* Run @fn on every online cpu at once; returns elapsed ns or -errno. */
+static s64 run_test(work_func_t fn)
+{
+	ktime_t start = ktime_get();
+	int ret;
+
+	ret = schedule_on_each_cpu(fn);
+	if (ret)
+		return ret;
+	return ktime_to_ns(ktime_sub(ktime_get(), start));
+}
+
+static void report(const char *name, s64 ns)
+{
+	u64 ops = (u64)loops * num_online_cpus();
+
+	pr_info("%-10s %u cpus: %llu ns/get+put, %llu total ms\n",
+		name, num_online_cpus(),
+		(unsigned long long)div64_u64((u64)ns * num_online_cpus(), ops),
+		(unsigned long long)div_u64(ns, NSEC_PER_MSEC));
+}
+
+static int __init percpu_ref_test_init(void)
+{
+	s64 ns;
+
+	atomic_long_set(&test_atomic, 1);
+	ns = run_test(atomic_bench_fn);
+	if (ns < 0)
+		return ns;
+	report("atomic", ns);
+
+	if (percpu_ref_init(&test_ref, test_ref_release, 0, GFP_KERNEL))
+		return -ENOMEM;
+
+	ns = run_test(percpu_ref_bench_fn);
+	if (ns < 0)
+		goto out;
+	report("percpu_ref", ns);
+
+	test_released = false;
+	percpu_ref_get(&test_ref);
+	atomic_set(&test_kill_pending, 1);
+	ns = run_test(percpu_ref_bench_fn);
+	if (ns < 0) {
+		percpu_ref_put(&test_ref);
+		goto out;
+	}
+	/* wait for the switch to atomic mode to finish */
+	rcu_barrier_sched();
+	if (test_released || atomic_long_read(&test_ref.count) != 1)
+		pr_err("percpu_ref count %ld after kill, expected 1\n",
+		       atomic_long_read(&test_ref.count));
+	percpu_ref_put(&test_ref);
+	if (test_released)
+		pr_info("percpu_ref kill under load ok\n");
+	else
+		pr_err("percpu_ref not released after last put\n");
+
+out:
+	percpu_ref_exit(&test_ref);
+
+	return -EAGAIN; /* Fail will directly unload the module */
+}
+
+static void __exit percpu_ref_test_exit(void)
+{
+}
+
+module_init(percpu_ref_test_init)
+module_exit(percpu_ref_test_exit)
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("percpu_ref scalability benchmark");
@@ -65,6 +65,12 @@ const struct raid6_calls * const raid6_algos[] = {
 	&raid6_altivec2,
 	&raid6_altivec4,
 	&raid6_altivec8,
+#endif
+#ifdef CONFIG_KERNEL_MODE_NEON
+	&raid6_neonx1,
+	&raid6_neonx2,
+	&raid6_neonx4,
+	&raid6_neonx8,
 #endif
 	&raid6_intx1,
 	&raid6_intx2,
@@ -85,6 +91,9 @@ const struct raid6_recov_calls *const raid6_recov_algos[] = {
 	&raid6_recov_avx2,
 #endif
 	&raid6_recov_ssse3,
+#endif
+#ifdef CONFIG_KERNEL_MODE_NEON
+	&raid6_recov_neon,
 #endif
 	&raid6_recov_intx1,
 	NULL
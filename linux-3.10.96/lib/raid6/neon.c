@@ -0,0 +1,50 @@
+/* -*- linux-c -*- ------------------------------------------------------- *
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, Inc., 53 Temple Place Ste 330,
+ *   Boston MA 02111-1307, USA; either version 2 of the License, or
+ *   (at your option) any later version; incorporated herein by reference.
+ *
+ * ----------------------------------------------------------------------- */
+
+/*
+ * raid6/neon.c
+ *
+ * RAID-6 syndrome calculation using the arm64 NEON unit
+ *
+ * The loops are in neon$#.c, generated from neon.uc by unroll.awk.  They
+ * are kept out of this file for two reasons: <arm_neon.h> does not get
+ * along with the kernel headers, and they are built without
+ * -mgeneral-regs-only, which must not leak into code that runs outside
+ * kernel_neon_begin()/kernel_neon_end().
+ */
+
+#include <linux/raid/pq.h>
+#include "neon.h"
+
+static int raid6_have_neon(void)
+{
+	return cpu_has_neon();
+}
+
+#define RAID6_NEON_WRAPPER(_n)						\
+	static void raid6_neon ## _n ## _gen_syndrome(int disks,	\
+					size_t bytes, void **ptrs)	\
+	{								\
+		kernel_neon_begin();					\
+		raid6_neon ## _n ## _gen_syndrome_real(disks,		\
+					(unsigned long)bytes, ptrs);	\
+		kernel_neon_end();					\
+	}								\
+	const struct raid6_calls raid6_neonx ## _n = {			\
+		raid6_neon ## _n ## _gen_syndrome,			\
+		raid6_have_neon,					\
+		"neonx" #_n,						\
+		0							\
+	}
+
+RAID6_NEON_WRAPPER(1);
+RAID6_NEON_WRAPPER(2);
+RAID6_NEON_WRAPPER(4);
+RAID6_NEON_WRAPPER(8);
@@ -0,0 +1,55 @@
+/* ----------------------------------------------------------------------- *
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, Inc., 53 Temple Place Ste 330,
+ *   Boston MA 02111-1307, USA; either version 2 of the License, or
+ *   (at your option) any later version; incorporated herein by reference.
+ *
+ * ----------------------------------------------------------------------- */
+
+/*
+ * raid6/neon.h
+ *
+ * Definitions common to the arm64 NEON RAID-6 code.  The NEON routines
+ * themselves live in neon$#.c and recov_neon_inner.c, which are built
+ * from <arm_neon.h> and so cannot include any kernel header; the
+ * callers here bracket them with kernel_neon_begin()/kernel_neon_end().
+ */
+
+#ifndef LINUX_RAID_RAID6NEON_H
+#define LINUX_RAID_RAID6NEON_H
+
+#ifdef __KERNEL__ /* Real code */
+
+#include <asm/neon.h>
+
+#else /* Dummy code for user space testing */
+
+static inline void kernel_neon_begin(void)
+{
+}
+
+static inline void kernel_neon_end(void)
+{
+}
+
+#define cpu_has_neon()		(1)
+
+#endif /* ndef __KERNEL__ */
+
+void raid6_neon1_gen_syndrome_real(int disks, unsigned long bytes,
+				   void **ptrs);
+void raid6_neon2_gen_syndrome_real(int disks, unsigned long bytes,
+				   void **ptrs);
+void raid6_neon4_gen_syndrome_real(int disks, unsigned long bytes,
+				   void **ptrs);
+void raid6_neon8_gen_syndrome_real(int disks, unsigned long bytes,
+				   void **ptrs);
+
+void __raid6_2data_recov_neon(int bytes, u8 *p, u8 *q, u8 *dp, u8 *dq,
+			      const u8 *pbmul, const u8 *qmul);
+void __raid6_datap_recov_neon(int bytes, u8 *p, u8 *q, u8 *dq,
+			      const u8 *qmul);
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ * of the License.
+ */
+
+/*
+ * The NEON half of recov_neon.c.  As with neon.uc, only <arm_neon.h>
+ * may be included here.
+ *
+ * A GF(2^8) multiplication by a constant is done a nibble at a time:
+ * the 32 byte raid6_vgfmul rows hold the products of the constant with
+ * every low nibble, then with every high nibble, and TBL looks up sixteen
+ * bytes of either at once.
+ */
+
+#include <arm_neon.h>
+
+void __raid6_2data_recov_neon(int bytes, uint8_t *p, uint8_t *q, uint8_t *dp,
+			      uint8_t *dq, const uint8_t *pbmul,
+			      const uint8_t *qmul);
+void __raid6_datap_recov_neon(int bytes, uint8_t *p, uint8_t *q, uint8_t *dq,
+			      const uint8_t *qmul);
+
+static inline uint8x16_t gf_mul(uint8x16_t lo, uint8x16_t hi, uint8x16_t x)
+{
+	uint8x16_t vx, vy;
+
+	vy = vshrq_n_u8(x, 4);
+	vx = vqtbl1q_u8(lo, vandq_u8(x, vdupq_n_u8(0x0f)));
+	vy = vqtbl1q_u8(hi, vy);
+
+	return veorq_u8(vx, vy);
+}
+
+void __raid6_2data_recov_neon(int bytes, uint8_t *p, uint8_t *q, uint8_t *dp,
+			      uint8_t *dq, const uint8_t *pbmul,
+			      const uint8_t *qmul)
+{
+	uint8x16_t pm0 = vld1q_u8(pbmul);
+	uint8x16_t pm1 = vld1q_u8(pbmul + 16);
+	uint8x16_t qm0 = vld1q_u8(qmul);
+	uint8x16_t qm1 = vld1q_u8(qmul + 16);
+	uint8x16_t px, qx, db;
+
+	/*
+	 * px    = *p ^ *dp;
+	 * qx    = qmul[*q ^ *dq];
+	 * *dq++ = db = pbmul[px] ^ qx;
+	 * *dp++ = db ^ px;
+	 */
+	while (bytes) {
+		px = veorq_u8(vld1q_u8(p), vld1q_u8(dp));
+		qx = gf_mul(qm0, qm1, veorq_u8(vld1q_u8(q), vld1q_u8(dq)));
+		db = veorq_u8(gf_mul(pm0, pm1, px), qx);
+
+		vst1q_u8(dq, db);
+		vst1q_u8(dp, veorq_u8(db, px));
+
+		bytes -= 16;
+		p += 16;
+		q += 16;
+		dp += 16;
+		dq += 16;
+	}
+}
+
+void __raid6_datap_recov_neon(int bytes, uint8_t *p, uint8_t *q, uint8_t *dq,
+			      const uint8_t *qmul)
+{
+	uint8x16_t qm0 = vld1q_u8(qmul);
+	uint8x16_t qm1 = vld1q_u8(qmul + 16);
+	uint8x16_t vx;
+
+	/*
+	 * *p++ ^= *dq = qmul[*q ^ *dq];
+	 */
+	while (bytes) {
+		vx = gf_mul(qm0, qm1, veorq_u8(vld1q_u8(q), vld1q_u8(dq)));
+
+		vst1q_u8(dq, vx);
+		vst1q_u8(p, veorq_u8(vx, vld1q_u8(p)));
+
+		bytes -= 16;
+		p += 16;
+		q += 16;
+		dq += 16;
+	}
+}
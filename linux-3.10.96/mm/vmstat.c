@@ -19,6 +19,7 @@
 #include <linux/math64.h>
 #include <linux/writeback.h>
 #include <linux/compaction.h>
+#include <linux/tick.h>
 
 #ifdef CONFIG_VM_EVENT_COUNTERS
 DEFINE_PER_CPU(struct vm_event_state, vm_event_states) = {{0}};
@@ -1191,6 +1192,15 @@ static void __cpuinit start_cpu_timer(int cpu)
 	struct delayed_work *work = &per_cpu(vmstat_work, cpu);
 
 	INIT_DEFERRABLE_WORK(work, vmstat_update);
+
+	/*
+	 * Full dynticks CPUs don't run the periodic update: their diffs
+	 * still get folded once they cross stat_threshold, which bounds the
+	 * drift of the global counters.
+	 */
+	if (!is_housekeeping_cpu(cpu))
+		return;
+
 	schedule_delayed_work_on(cpu, work, __round_jiffies_relative(HZ, cpu));
 }
 